@@ -0,0 +1,2 @@
+/* generated UART component, the host declares its API in project.h */
+#include "project.h"
@@ -0,0 +1,2 @@
+/* CyLib is part of project.h on the host */
+#include "project.h"
@@ -0,0 +1,2 @@
+/* the sources include it under both spellings */
+#include "../../include/SDcard.h"
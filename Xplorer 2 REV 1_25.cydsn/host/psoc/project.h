@@ -0,0 +1,120 @@
+/* ========================================
+ *
+ * Host stand-in for the PSoC Creator generated API
+ *
+ * Only what the firmware sources built by host/Makefile call is declared
+ * here. The components behave as described in psoc_sim.c.
+ *
+ * ========================================
+*/
+#ifndef HOST_PROJECT_H
+#define HOST_PROJECT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef uint8_t   uint8;
+typedef uint16_t  uint16;
+typedef uint32_t  uint32;
+typedef int8_t    int8;
+typedef int16_t   int16;
+typedef int32_t   int32;
+typedef uint64_t  uint64;
+typedef int64_t   int64;
+typedef float     float32;
+typedef double    float64;
+typedef char      char8;
+typedef volatile uint8  reg8;
+typedef volatile uint16 reg16;
+typedef volatile uint32 reg32;
+typedef void ( * cyisraddress ) ( void );
+
+#define CY_ISR(n)          void n ( void )
+#define CY_ISR_PROTO(n)    void n ( void )
+#define CYCODE
+#define CY_PACKED
+#define CY_PACKED_ATTR
+#define CY_NOINIT
+
+/* interrupts are never preempted on the host, the simulator runs the ISRs
+   between firmware calls */
+#define CyGlobalIntDisable do { } while ( 0 )
+#define CyGlobalIntEnable  do { } while ( 0 )
+
+void   CyDelay ( uint32 ms );
+
+/* SysTick, counting down at the bus clock from the reload */
+#define BCLK__BUS_CLK__MHZ        64u
+#define CY_SYS_SYST_RVR_CNT_MASK  0x00FFFFFFu
+void   CySysTickStart ( void );
+void   CySysTickDisableInterrupt ( void );
+void   CySysTickSetReload ( uint32 value );
+uint32 CySysTickGetValue ( void );
+
+/* EEPROM, mapped onto a RAM array */
+extern uint8 simEeprom[];
+#define CYDEV_EE_BASE          ( (uintptr_t)simEeprom )
+#define CYDEV_EE_SIZE          2048u
+#define CYDEV_EEPROM_ROW_SIZE  16u
+#define EEPROM_EEPROM_SIZE     CYDEV_EE_SIZE
+void   EEPROM_Start ( void );
+uint8  EEPROM_Write ( const uint8 * rowData, uint8 rowNumber );
+
+/* pulse counters, count up to the period then wrap and interrupt */
+void   Counter_GM_Start ( void );
+uint16 Counter_GM_ReadCounter ( void );
+void   Counter_GM_WriteCounter ( uint16 counter );
+uint16 Counter_GM_ReadPeriod ( void );
+void   Counter_GM_WritePeriod ( uint16 period );
+uint8  Counter_GM_ReadStatusRegister ( void );
+void   Counter_HE3_Start ( void );
+uint16 Counter_HE3_ReadCounter ( void );
+void   Counter_HE3_WriteCounter ( uint16 counter );
+uint16 Counter_HE3_ReadPeriod ( void );
+void   Counter_HE3_WritePeriod ( uint16 period );
+uint8  Counter_HE3_ReadStatusRegister ( void );
+void   isr_GM_StartEx ( cyisraddress address );
+void   isr_HE3_StartEx ( cyisraddress address );
+
+/* 8 bit counters clocked by the pulse counters' terminal count */
+void   Counter_GM_WRAP_Start ( void );
+uint8  Counter_GM_WRAP_ReadCounter ( void );
+void   Counter_HE3_WRAP_Start ( void );
+uint8  Counter_HE3_WRAP_ReadCounter ( void );
+
+/* one shot gating the counters */
+void   one_shot_timer_clock_Start ( void );
+void   ONE_SHOT_TIMER_Start ( void );
+void   ONE_SHOT_TIMER_Stop ( void );
+void   ONE_SHOT_TIMER_ClearFIFO ( void );
+void   ONE_SHOT_TIMER_WritePeriod ( uint32 period );
+uint32 ONE_SHOT_TIMER_ReadCounter ( void );
+void   ONE_SHOT_TIMER_WriteCounter ( uint32 counter );
+void   ONE_SHOT_RESET_Write ( uint8 value );
+void   isrOneShot_StartEx ( cyisraddress address );
+void   isrOneShot_ClearPending ( void );
+
+/* 1ms system timer */
+void   TIMER_1_Start ( void );
+void   TIMER_1_WriteCounter ( uint32 counter );
+void   isrTIMER_1_ClearPending ( void );
+void   isrTIMER_1_Enable ( void );
+void   isrTIMER_1_Disable ( void );
+
+/* pins and peripherals the count path touches, no effect on the host */
+void   GM_TUBE_SELECT_Write ( uint8 value );
+void   LCD_BK_EN_Write ( uint8 value );
+void   BUZZER_Write ( uint8 value );
+void   ROW_2_Write ( uint8 value );
+uint8  Status_KEY_COLUMN_0_Read ( void );
+uint8  Status_KEY_COLUMN_1_Read ( void );
+void   ADC_DelSig_Start ( void );
+void   ADC_SAR_Start ( void );
+void   UART_GPS_Start ( void );
+uint8  SD_CARD_DETECT_Read ( void );
+void   emFile_1_Sleep ( void );
+void   emFile_1_Wakeup ( void );
+
+char * itoa ( int value, char * str, int base );
+
+#endif
@@ -0,0 +1,48 @@
+/* ========================================
+ *
+ * Minimal check macros for the host tests. A failed check is reported
+ * with its line and the test program exits non-zero at the end.
+ *
+ * ========================================
+*/
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+#include <time.h>
+
+static int hostChecks, hostFailures;
+
+#define CHECK(cond) do { \
+    hostChecks++; \
+    if ( !( cond ) ) \
+    { \
+      hostFailures++; \
+      printf ( "  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond ); \
+    } \
+  } while ( 0 )
+
+#define CHECK_NEAR(a, b, tol) do { \
+    double a_ = ( a ), b_ = ( b ); \
+    hostChecks++; \
+    if ( !( ( a_ - b_ <= ( tol ) ) && ( b_ - a_ <= ( tol ) ) ) ) \
+    { \
+      hostFailures++; \
+      printf ( "  FAIL %s:%d: %s = %g, expected %g +- %g\n", __FILE__, __LINE__, #a, a_, b_, (double)( tol ) ); \
+    } \
+  } while ( 0 )
+
+static int hostTestEnd ( const char * name )
+{
+  printf ( "%s: %d checks, %d failed\n", name, hostChecks, hostFailures );
+  return hostFailures ? 1 : 0;
+}
+
+static double hostSeconds ( void )
+{
+  struct timespec ts;
+  clock_gettime ( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+#endif
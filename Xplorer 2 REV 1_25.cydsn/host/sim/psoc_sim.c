@@ -0,0 +1,381 @@
+/* ========================================
+ *
+ * Simulated PSoC layer for host builds of the counting chain,
+ * see psoc_sim.h
+ *
+ * ========================================
+*/
+#include <math.h>
+#include <string.h>
+#include "psoc_sim.h"
+
+extern volatile uint32 msTimer;
+void pulseBinTick ( void );
+
+typedef struct
+{
+  double rate;                          // true counts per second
+  double tau;                           // dead time in seconds
+  uint8  model;                         // SIM_DEAD_xxx
+  double next;                          // time of the next arrival in s
+  double dead_until;
+  uint16 counter;
+  uint16 period;
+  uint8  pending;                       // reload interrupt held by simMaskIsrs
+  uint8  wraps;                         // Counter_xxx_WRAP, counts every wrap
+  uint32 delivered;                     // counts delivered to the counter
+  cyisraddress isr;
+} sim_tube_t;
+
+static sim_tube_t tube[SIM_TUBES] = { { .period = 200 }, { .period = 200 } };
+static uint16 counterMask = 0xFFFF;
+static uint32 nowMs;
+static uint32 maskUntil;
+static uint8  tickPending;              // 1ms timer interrupt held by simMaskIsrs
+static uint32 sysTickReload = CY_SYS_SYST_RVR_CNT_MASK;
+
+static struct
+{
+  uint8  enabled;                       // ONE_SHOT_TIMER_Start
+  uint8  armed;                         // reset released, not expired yet
+  uint8  in_reset;
+  uint8  pending;                       // expiry interrupt held by simMaskIsrs
+  uint32 period;
+  uint32 elapsed;                       // ticks of PULSETIMERCLK, 1ms each
+  cyisraddress isr;
+} oneShot;
+
+static uint32 keyAt;
+static int    keyNext;
+static int    keyLast;
+static uint64 rng = 88172645463325252ull;
+
+uint8 simEeprom[CYDEV_EE_SIZE];
+
+/*******************************************************************************
+* Seeded generator
+*******************************************************************************/
+void simSeed ( uint64 seed )
+{
+  rng = seed ? seed : 88172645463325252ull;
+}
+
+double simUniform ( void )            // (0,1]
+{
+  rng ^= rng >> 12;
+  rng ^= rng << 25;
+  rng ^= rng >> 27;
+  return ( ( ( rng * 2685821657736338717ull ) >> 11 ) + 1 ) * ( 1.0 / 9007199254740992.0 );
+}
+
+double simExp ( double rate )
+{
+  return -log ( simUniform ( ) ) / rate;
+}
+
+double simNormal ( void )
+{
+  return sqrt ( -2.0 * log ( simUniform ( ) ) ) * cos ( 6.283185307179586 * simUniform ( ) );
+}
+
+uint32 simPoisson ( double mean )
+{
+  double l, p;
+  uint32 k = 0;
+
+  if ( mean > 500.0 )                   // normal approximation is well inside the count scatter
+  {
+    p = floor ( mean + sqrt ( mean ) * simNormal ( ) + 0.5 );
+    return ( p > 0 ) ? (uint32)p : 0;
+  }
+  l = exp ( -mean );
+  p = simUniform ( );
+  while ( p > l )
+  {
+    p *= simUniform ( );
+    k++;
+  }
+  return k;
+}
+
+/*******************************************************************************
+* Simulation control
+*******************************************************************************/
+void simReset ( uint64 seed )
+{
+  uint8 i;
+
+  for ( i = 0; i < SIM_TUBES; i++ )     // the ISRs and periods belong to the firmware's init
+  {
+    tube[i].rate       = 0;
+    tube[i].tau        = 0;
+    tube[i].model      = SIM_DEAD_NONE;
+    tube[i].dead_until = 0;
+    tube[i].counter    = 0;
+    tube[i].pending    = 0;
+    tube[i].wraps      = 0;
+    tube[i].delivered  = 0;
+  }
+  oneShot.enabled  = 0;
+  oneShot.armed    = 0;
+  oneShot.in_reset = 0;
+  oneShot.pending  = 0;
+  oneShot.elapsed  = 0;
+  nowMs     = 0;
+  maskUntil = 0;
+  tickPending = 0;
+  keyAt     = 0xFFFFFFFF;
+  keyLast   = 99;                       // DFLT, no key
+  msTimer   = 0;
+  simSeed ( seed );
+}
+
+void simSetRate ( uint8 t, double cps )
+{
+  tube[t].rate = cps;
+  tube[t].next = nowMs / 1000.0 + ( ( cps > 0 ) ? simExp ( cps ) : 0 );
+}
+
+void simSetDeadTime ( uint8 t, double tau_s, uint8 model )
+{
+  tube[t].tau   = tau_s;
+  tube[t].model = model;
+}
+
+void simSetCounterBits ( uint8 bits )
+{
+  counterMask = ( bits >= 16 ) ? 0xFFFF : (uint16)( ( 1u << bits ) - 1 );
+}
+
+void simMaskIsrs ( uint32 ms )
+{
+  maskUntil = nowMs + ms;
+}
+
+uint32 simNowMs ( void )
+{
+  return nowMs;
+}
+
+uint32 simDelivered ( uint8 t )
+{
+  return tube[t].delivered;
+}
+
+void simPressKey ( uint32 at_ms, int key )
+{
+  keyAt   = at_ms;
+  keyNext = key;
+}
+
+int simLastKey ( void )
+{
+  return keyLast;
+}
+
+/*******************************************************************************
+* One tube's arrivals in the tick ending at t_end
+*******************************************************************************/
+static void simTubeTick ( sim_tube_t * tb, double t_end, uint8 gate )
+{
+  uint8 registered;
+
+  if ( tb->rate <= 0 )
+  {
+    return;
+  }
+  while ( tb->next < t_end )
+  {
+    registered = ( tb->model == SIM_DEAD_NONE ) || ( tb->next >= tb->dead_until );
+    if ( registered || ( tb->model == SIM_DEAD_PARALYZABLE ) )
+    {
+      tb->dead_until = tb->next + tb->tau;
+    }
+    if ( registered && gate )
+    {
+      tb->delivered++;
+      if ( ++tb->counter >= tb->period )
+      {
+        tb->counter = 0;
+        tb->wraps++;
+        if ( ( nowMs < maskUntil ) || ( tb->isr == 0 ) )
+        {
+          tb->pending = 1;              // a second wrap while pending is lost, as on the NVIC
+        }
+        else
+        {
+          tb->isr ( );
+        }
+      }
+    }
+    tb->next += simExp ( tb->rate );
+  }
+}
+
+static void simMsTick ( void )
+{
+  msTimer++;
+  pulseBinTick ( );
+}
+
+void simRunMs ( uint32 ms )
+{
+  uint8 i, gate, masked;
+
+  while ( ms-- )
+  {
+    masked = ( nowMs < maskUntil );
+    if ( !masked )                      // held interrupts run once each, however many fired
+    {
+      for ( i = 0; i < SIM_TUBES; i++ )
+      {
+        if ( tube[i].pending && tube[i].isr )
+        {
+          tube[i].pending = 0;
+          tube[i].isr ( );
+        }
+      }
+      if ( tickPending )
+      {
+        tickPending = 0;
+        simMsTick ( );
+      }
+      if ( oneShot.pending )
+      {
+        oneShot.pending = 0;
+        oneShot.isr ( );
+      }
+    }
+    gate = oneShot.enabled && oneShot.armed;
+    for ( i = 0; i < SIM_TUBES; i++ )
+    {
+      simTubeTick ( &tube[i], ( nowMs + 1 ) / 1000.0, gate );
+    }
+    nowMs++;
+    if ( nowMs == keyAt )
+    {
+      keyLast = keyNext;
+    }
+    if ( masked )
+    {
+      tickPending = 1;
+    }
+    else
+    {
+      simMsTick ( );
+    }
+    if ( gate && ( ++oneShot.elapsed + 1 >= oneShot.period ) )
+    {
+      oneShot.armed = 0;
+      if ( masked )
+      {
+        oneShot.pending = ( oneShot.isr != 0 );
+      }
+      else if ( oneShot.isr )
+      {
+        oneShot.isr ( );
+      }
+    }
+  }
+}
+
+void CyDelay ( uint32 ms )
+{
+  simRunMs ( ms );
+}
+
+/*******************************************************************************
+* SysTick, follows the virtual time. Interrupts run on ms boundaries, so
+* an unmasked ms tick always reads exactly 1ms after the last one.
+*******************************************************************************/
+void   CySysTickStart ( void )                         { }
+void   CySysTickDisableInterrupt ( void )              { }
+void   CySysTickSetReload ( uint32 value )             { sysTickReload = value & CY_SYS_SYST_RVR_CNT_MASK; }
+
+uint32 CySysTickGetValue ( void )
+{
+  uint64 ticks = (uint64)nowMs * 1000 * BCLK__BUS_CLK__MHZ;
+
+  return sysTickReload - (uint32)( ticks % ( (uint64)sysTickReload + 1 ) );
+}
+
+/*******************************************************************************
+* Pulse counters
+*******************************************************************************/
+static uint16 simCounterRead ( uint8 t )              { return tube[t].counter; }
+static void   simCounterWrite ( uint8 t, uint16 c )   { tube[t].counter = c & counterMask; }
+static void   simPeriodWrite ( uint8 t, uint16 p )    { tube[t].period = p & counterMask; }
+
+void   Counter_GM_Start ( void )                       { }
+uint16 Counter_GM_ReadCounter ( void )                 { return simCounterRead ( 0 ); }
+void   Counter_GM_WriteCounter ( uint16 counter )      { simCounterWrite ( 0, counter ); }
+uint16 Counter_GM_ReadPeriod ( void )                  { return tube[0].period; }
+void   Counter_GM_WritePeriod ( uint16 period )        { simPeriodWrite ( 0, period ); }
+uint8  Counter_GM_ReadStatusRegister ( void )          { return 0; }
+void   Counter_HE3_Start ( void )                      { }
+uint16 Counter_HE3_ReadCounter ( void )                { return simCounterRead ( 1 ); }
+void   Counter_HE3_WriteCounter ( uint16 counter )     { simCounterWrite ( 1, counter ); }
+uint16 Counter_HE3_ReadPeriod ( void )                 { return tube[1].period; }
+void   Counter_HE3_WritePeriod ( uint16 period )       { simPeriodWrite ( 1, period ); }
+uint8  Counter_HE3_ReadStatusRegister ( void )         { return 0; }
+void   isr_GM_StartEx ( cyisraddress address )         { tube[0].isr = address; }
+void   isr_HE3_StartEx ( cyisraddress address )        { tube[1].isr = address; }
+void   Counter_GM_WRAP_Start ( void )                  { }
+uint8  Counter_GM_WRAP_ReadCounter ( void )            { return tube[0].wraps; }
+void   Counter_HE3_WRAP_Start ( void )                 { }
+uint8  Counter_HE3_WRAP_ReadCounter ( void )           { return tube[1].wraps; }
+
+/*******************************************************************************
+* One shot. It runs while started and out of reset, and stops itself when
+* the period expires until the reset is pulsed again.
+*******************************************************************************/
+void   one_shot_timer_clock_Start ( void )             { }
+void   ONE_SHOT_TIMER_Start ( void )                   { oneShot.enabled = 1; }
+void   ONE_SHOT_TIMER_Stop ( void )                    { oneShot.enabled = 0; }
+void   ONE_SHOT_TIMER_ClearFIFO ( void )               { }
+void   ONE_SHOT_TIMER_WritePeriod ( uint32 period )    { oneShot.period = period; }
+uint32 ONE_SHOT_TIMER_ReadCounter ( void )             { return ( oneShot.period > oneShot.elapsed ) ? oneShot.period - oneShot.elapsed - 1 : 0; }
+void   ONE_SHOT_TIMER_WriteCounter ( uint32 counter )  { (void)counter; }
+void   isrOneShot_StartEx ( cyisraddress address )     { oneShot.isr = address; }
+void   isrOneShot_ClearPending ( void )                { }
+
+void ONE_SHOT_RESET_Write ( uint8 value )
+{
+  if ( value )
+  {
+    oneShot.in_reset = 1;
+    oneShot.armed    = 0;
+  }
+  else if ( oneShot.in_reset )
+  {
+    oneShot.in_reset = 0;
+    oneShot.armed    = 1;
+    oneShot.elapsed  = 0;
+  }
+}
+
+/*******************************************************************************
+* 1ms timer, EEPROM and pins
+*******************************************************************************/
+void   TIMER_1_Start ( void )                          { }
+void   TIMER_1_WriteCounter ( uint32 counter )         { (void)counter; }
+void   isrTIMER_1_ClearPending ( void )                { }
+void   isrTIMER_1_Enable ( void )                      { }
+void   isrTIMER_1_Disable ( void )                     { }
+
+void   EEPROM_Start ( void )                           { }
+uint8  EEPROM_Write ( const uint8 * rowData, uint8 rowNumber )
+{
+  memcpy ( &simEeprom[rowNumber * CYDEV_EEPROM_ROW_SIZE], rowData, CYDEV_EEPROM_ROW_SIZE );
+  return 0;
+}
+
+void   GM_TUBE_SELECT_Write ( uint8 value )            { (void)value; }
+void   LCD_BK_EN_Write ( uint8 value )                 { (void)value; }
+void   BUZZER_Write ( uint8 value )                    { (void)value; }
+void   ROW_2_Write ( uint8 value )                     { (void)value; }
+uint8  Status_KEY_COLUMN_0_Read ( void )               { return 0; }
+uint8  Status_KEY_COLUMN_1_Read ( void )               { return 0; }
+void   ADC_DelSig_Start ( void )                       { }
+void   ADC_SAR_Start ( void )                          { }
+void   UART_GPS_Start ( void )                         { }
@@ -0,0 +1,48 @@
+/* ========================================
+ *
+ * Simulated PSoC layer for host builds of the counting chain
+ *
+ * Virtual time only moves in CyDelay and simRunMs, one 1ms tick at a
+ * time, so a 240s count runs in well under a second and every run with
+ * the same seed gives the same counts. Each tick:
+ *   - pulses arriving in the tick are delivered to the tube counters while
+ *     the one shot gates them, wrapping at the counter period, bumping the
+ *     wrap counter and calling the reload ISR,
+ *   - the 1ms timer ISR runs (msTimer++, pulseBinTick),
+ *   - the one shot counts down and calls its ISR when it expires.
+ * simMaskIsrs stands for a Global_ID() section: every ISR that fires in
+ * it is held pending and runs once when it ends, so a second reload wrap
+ * or ms tick inside the section is lost as on the NVIC. The counters and
+ * the one shot keep running.
+ *
+ * ========================================
+*/
+#ifndef PSOC_SIM_H
+#define PSOC_SIM_H
+
+#include "project.h"
+
+#define SIM_TUBES         2     // PROBE_GM_COUNT, PROBE_HE3_COUNT
+#define SIM_DEAD_NONE     0     // dead time models of the simulated tubes
+#define SIM_DEAD_NON_PARALYZABLE  1
+#define SIM_DEAD_PARALYZABLE  2
+
+void   simReset ( uint64 seed );
+void   simSetRate ( uint8 tube, double cps );
+void   simSetDeadTime ( uint8 tube, double tau_s, uint8 model );
+void   simSetCounterBits ( uint8 bits );
+void   simMaskIsrs ( uint32 ms );
+void   simRunMs ( uint32 ms );
+uint32 simNowMs ( void );
+uint32 simDelivered ( uint8 tube );
+void   simPressKey ( uint32 at_ms, int key );
+int    simLastKey ( void );
+
+/* seeded generator shared by the tests, xorshift64* */
+void   simSeed ( uint64 seed );
+double simUniform ( void );
+double simExp ( double rate );
+uint32 simPoisson ( double mean );
+double simNormal ( void );
+
+#endif
@@ -0,0 +1,440 @@
+/* ========================================
+ *
+ * RAM disk stand-in for emFile, see ramdisk.h. Names are matched without
+ * case or a leading backslash, like FAT. A seek past the end is allowed
+ * and a write there fills the gap with zeros.
+ *
+ * ========================================
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <FS.h>
+#include "ramdisk.h"
+
+#define RD_FILES      32
+#define RD_HANDLES    8
+#define RD_NAME       64
+
+typedef struct
+{
+  char    name[RD_NAME];
+  uint8 * data;
+  uint32  size, cap;
+  uint32  time;                         // bumped by every write, stands in for the FAT time
+} rd_file_t;
+
+struct FS_FILE
+{
+  int     file;                         // index into rdFile, -1 when closed
+  uint32  pos;
+  uint8   dead;                         // left over from before a power cut
+};
+
+static rd_file_t rdFile[RD_FILES];
+static FS_FILE   rdHandle[RD_HANDLES];
+static ramdisk_stats_t rdStats;
+static uint8  rdCard = 1;
+static int32  rdBudget = -1;            // bytes left before the cut, -1 for none
+static uint32 rdClock;
+
+static const char * rdName ( const char * name )
+{
+  while ( *name == '\\' )
+  {
+    name++;
+  }
+  return name;
+}
+
+static int rdFind ( const char * name )
+{
+  int i;
+  name = rdName ( name );
+  for ( i = 0; i < RD_FILES; i++ )
+  {
+    if ( ( rdFile[i].data != NULL ) && ( strcasecmp ( rdFile[i].name, name ) == 0 ) )
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static int rdCreate ( const char * name )
+{
+  int i;
+  for ( i = 0; i < RD_FILES; i++ )
+  {
+    if ( rdFile[i].data == NULL )
+    {
+      strncpy ( rdFile[i].name, rdName ( name ), RD_NAME - 1 );
+      rdFile[i].cap  = 512;
+      rdFile[i].data = calloc ( 1, rdFile[i].cap );
+      rdFile[i].size = 0;
+      rdFile[i].time = ++rdClock;
+      return i;
+    }
+  }
+  return -1;
+}
+
+static void rdGrow ( rd_file_t * f, uint32 size )
+{
+  if ( size > f->cap )
+  {
+    while ( f->cap < size )
+    {
+      f->cap *= 2;
+    }
+    f->data = realloc ( f->data, f->cap );
+  }
+  if ( size > f->size )
+  {
+    memset ( f->data + f->size, 0, size - f->size );
+    f->size = size;
+  }
+}
+
+static void rdDelete ( int i )
+{
+  free ( rdFile[i].data );
+  memset ( &rdFile[i], 0, sizeof(rdFile[i]) );
+}
+
+void ramdiskReset ( void )
+{
+  int i;
+  for ( i = 0; i < RD_FILES; i++ )
+  {
+    if ( rdFile[i].data != NULL )
+    {
+      rdDelete ( i );
+    }
+  }
+  for ( i = 0; i < RD_HANDLES; i++ )
+  {
+    rdHandle[i].file = -1;
+  }
+  memset ( &rdStats, 0, sizeof(rdStats) );
+  rdCard   = 1;
+  rdBudget = -1;
+}
+
+void ramdiskSetCard ( uint8 present )
+{
+  rdCard = present;
+}
+
+void ramdiskCutAfter ( int32 bytes )
+{
+  rdBudget = bytes;
+}
+
+uint8 ramdiskIsCut ( void )
+{
+  return ( rdBudget == 0 );
+}
+
+/* what the card holds stays, every open handle is lost */
+void ramdiskPowerCycle ( void )
+{
+  int i;
+  for ( i = 0; i < RD_HANDLES; i++ )
+  {
+    if ( rdHandle[i].file >= 0 )
+    {
+      rdHandle[i].dead = 1;
+    }
+  }
+  rdBudget = -1;
+}
+
+void ramdiskStats ( ramdisk_stats_t * stats, uint8 reset )
+{
+  *stats = rdStats;
+  if ( reset )
+  {
+    memset ( &rdStats, 0, sizeof(rdStats) );
+  }
+}
+
+int32 ramdiskPut ( const char * name, const void * data, uint32 len )
+{
+  int i = rdFind ( name );
+  if ( ( i < 0 ) && ( ( i = rdCreate ( name ) ) < 0 ) )
+  {
+    return -1;
+  }
+  rdFile[i].size = 0;
+  rdGrow ( &rdFile[i], len );
+  memcpy ( rdFile[i].data, data, len );
+  rdFile[i].time = ++rdClock;
+  return 0;
+}
+
+int32 ramdiskGet ( const char * name, void * data, uint32 len )
+{
+  int i = rdFind ( name );
+  if ( ( i < 0 ) || ( len > rdFile[i].size ) )
+  {
+    return -1;
+  }
+  memcpy ( data, rdFile[i].data, len );
+  return 0;
+}
+
+int32 ramdiskSize ( const char * name )
+{
+  int i = rdFind ( name );
+  return ( i < 0 ) ? -1 : (int32)rdFile[i].size;
+}
+
+static uint8 rdLive ( FS_FILE * h )
+{
+  return ( h != NULL ) && ( h->file >= 0 ) && !h->dead && rdCard;
+}
+
+/*********************************************************************
+*
+*       emFile calls
+*/
+FS_FILE * FS_FOpen ( const char * pFileName, const char * pMode )
+{
+  int i, f;
+  if ( !rdCard )
+  {
+    return NULL;
+  }
+  for ( i = 0; ( i < RD_HANDLES ) && ( rdHandle[i].file >= 0 ); i++ )
+  {
+  }
+  if ( i == RD_HANDLES )
+  {
+    return NULL;
+  }
+  f = rdFind ( pFileName );
+  if ( ( pMode[0] == 'w' ) || ( pMode[0] == 'a' ) )
+  {
+    if ( ( f < 0 ) && ( ( f = rdCreate ( pFileName ) ) < 0 ) )
+    {
+      return NULL;
+    }
+    if ( pMode[0] == 'w' )
+    {
+      rdFile[f].size = 0;
+      rdFile[f].time = ++rdClock;
+    }
+  }
+  else if ( f < 0 )
+  {
+    return NULL;
+  }
+  rdStats.opens++;
+  rdHandle[i].file = f;
+  rdHandle[i].dead = 0;
+  rdHandle[i].pos  = ( pMode[0] == 'a' ) ? rdFile[f].size : 0;
+  return &rdHandle[i];
+}
+
+int FS_FClose ( FS_FILE * pFile )
+{
+  if ( pFile != NULL )
+  {
+    pFile->file = -1;
+    pFile->dead = 0;
+  }
+  return 0;
+}
+
+U32 FS_Read ( FS_FILE * pFile, void * pData, U32 NumBytes )
+{
+  rd_file_t * f;
+  U32 n;
+  if ( !rdLive ( pFile ) )
+  {
+    return 0;
+  }
+  f = &rdFile[pFile->file];
+  n = ( pFile->pos >= f->size ) ? 0 : f->size - pFile->pos;
+  n = ( NumBytes < n ) ? NumBytes : n;
+  memcpy ( pData, f->data + pFile->pos, n );
+  pFile->pos += n;
+  rdStats.reads++;
+  rdStats.read_bytes += n;
+  return n;
+}
+
+U32 FS_Write ( FS_FILE * pFile, const void * pData, U32 NumBytes )
+{
+  rd_file_t * f;
+  U32 n = NumBytes;
+  if ( !rdLive ( pFile ) )
+  {
+    return 0;
+  }
+  if ( rdBudget >= 0 )
+  {
+    n = ( n < (U32)rdBudget ) ? n : (U32)rdBudget;
+    rdBudget -= n;
+  }
+  f = &rdFile[pFile->file];
+  rdGrow ( f, pFile->pos + n );
+  memcpy ( f->data + pFile->pos, pData, n );
+  pFile->pos += n;
+  f->time = ++rdClock;
+  rdStats.writes++;
+  rdStats.write_bytes += n;
+  return n;
+}
+
+int FS_FSeek ( FS_FILE * pFile, I32 Offset, int Origin )
+{
+  I32 base = 0;
+  if ( !rdLive ( pFile ) )
+  {
+    return -1;
+  }
+  if ( Origin == FS_SEEK_CUR )
+  {
+    base = pFile->pos;
+  }
+  else if ( Origin == FS_SEEK_END )
+  {
+    base = rdFile[pFile->file].size;
+  }
+  if ( base + Offset < 0 )
+  {
+    return -1;
+  }
+  pFile->pos = base + Offset;
+  rdStats.seeks++;
+  return 0;
+}
+
+U32 FS_GetFileSize ( FS_FILE * pFile )
+{
+  return rdLive ( pFile ) ? rdFile[pFile->file].size : 0;
+}
+
+int FS_Truncate ( FS_FILE * pFile, U32 NewSize )
+{
+  if ( !rdLive ( pFile ) || ( rdBudget == 0 ) )
+  {
+    return -1;
+  }
+  if ( NewSize < rdFile[pFile->file].size )
+  {
+    rdFile[pFile->file].size = NewSize;
+  }
+  rdStats.truncates++;
+  return 0;
+}
+
+int FS_Sync ( const char * sVolume )
+{
+  (void)sVolume;
+  rdStats.syncs++;
+  return 0;
+}
+
+int FS_Remove ( const char * pFileName )
+{
+  int i = rdFind ( pFileName );
+  if ( ( i < 0 ) || !rdCard || ( rdBudget == 0 ) )
+  {
+    return -1;
+  }
+  rdDelete ( i );
+  return 0;
+}
+
+/* the new name is a bare name in the directory of the old one */
+int FS_Rename ( const char * sOldName, const char * sNewName )
+{
+  int i = rdFind ( sOldName );
+  char * dir;
+  if ( ( i < 0 ) || !rdCard || ( rdBudget == 0 ) )
+  {
+    return -1;
+  }
+  dir = strrchr ( rdFile[i].name, '\\' );
+  dir = ( dir != NULL ) ? dir + 1 : rdFile[i].name;
+  strncpy ( dir, sNewName, RD_NAME - 1 - ( dir - rdFile[i].name ) );
+  return 0;
+}
+
+int FS_GetFileTime ( const char * pName, U32 * pTimeStamp )
+{
+  int i = rdFind ( pName );
+  if ( i < 0 )
+  {
+    return -1;
+  }
+  *pTimeStamp = rdFile[i].time;
+  return 0;
+}
+
+/* directory walk, fd->Dir.DirEntryIndex is the next file to look at and
+   fd->Dir.FirstCluster keeps the length of the directory prefix */
+static int rdFindFrom ( FS_FIND_DATA * pfd )
+{
+  const char * dir = pfd->Dir.pVolume ? (const char *)pfd->Dir.pVolume : "";
+  size_t n = pfd->Dir.FirstCluster;
+  int i;
+  for ( i = pfd->Dir.DirEntryIndex; i < RD_FILES; i++ )
+  {
+    if ( ( rdFile[i].data != NULL ) && ( strncasecmp ( rdFile[i].name, dir, n ) == 0 )
+         && ( strchr ( rdFile[i].name + n, '\\' ) == NULL ) )
+    {
+      strncpy ( pfd->sFileName, rdFile[i].name + n, pfd->SizeofFileName - 1 );
+      pfd->sFileName[pfd->SizeofFileName - 1] = '\0';
+      pfd->Attributes    = 0;
+      pfd->FileSize      = rdFile[i].size;
+      pfd->LastWriteTime = rdFile[i].time;
+      pfd->Dir.DirEntryIndex = i + 1;
+      rdStats.finds++;
+      return 1;
+    }
+  }
+  pfd->Dir.DirEntryIndex = RD_FILES;
+  return 0;
+}
+
+static char rdFindDir[RD_NAME];
+
+char FS_FindFirstFile ( FS_FIND_DATA * pfd, const char * sPath, char * sFilename, int sizeofFilename )
+{
+  memset ( pfd, 0, sizeof(*pfd) );
+  if ( !rdCard )
+  {
+    return -1;
+  }
+  strncpy ( rdFindDir, rdName ( sPath ), RD_NAME - 1 );
+  pfd->Dir.pVolume       = (FS_VOLUME *)rdFindDir;
+  pfd->Dir.FirstCluster  = strlen ( rdFindDir );
+  pfd->sFileName         = sFilename;
+  pfd->SizeofFileName    = sizeofFilename;
+  return rdFindFrom ( pfd ) ? 0 : 1;
+}
+
+char FS_FindNextFile ( FS_FIND_DATA * pfd )
+{
+  return rdFindFrom ( pfd );
+}
+
+void FS_FindClose ( FS_FIND_DATA * pfd )
+{
+  (void)pfd;
+}
+
+/* the volume and directory calls have nothing to do on a RAM disk */
+void FS_Init ( void )                                   { }
+void FS_DeInit ( void )                                 { }
+void FS_FAT_SupportLFN ( void )                         { }
+FS_DIR * FS_OpenDir ( const char * pDirName )           { (void)pDirName; return (FS_DIR *)rdFindDir; }
+int  FS_CloseDir ( FS_DIR * pDir )                      { (void)pDir; return 0; }
+int  FS_MkDir ( const char * pDirName )                 { (void)pDirName; return 0; }
+uint8 SD_CARD_DETECT_Read ( void )                      { return rdCard ? 0 : 1; }
+void emFile_1_Sleep ( void )                            { }
+void emFile_1_Wakeup ( void )                           { }
@@ -0,0 +1,38 @@
+/* ========================================
+ *
+ * RAM disk stand-in for the emFile calls the project store makes, so
+ * SDcard.c and ProjectData.c run on the host. It counts every call that
+ * would reach the card and can cut the power after a number of written
+ * bytes, leaving the last write torn.
+ *
+ * ========================================
+*/
+#ifndef RAMDISK_H
+#define RAMDISK_H
+
+#include "project.h"
+
+typedef struct
+{
+  uint32 opens;                         // FS_FOpen that found or made a file
+  uint32 reads;                         // FS_Read calls
+  uint32 writes;                        // FS_Write calls
+  uint32 read_bytes;
+  uint32 write_bytes;
+  uint32 seeks;
+  uint32 syncs;
+  uint32 truncates;
+  uint32 finds;                         // directory entries walked
+} ramdisk_stats_t;
+
+void   ramdiskReset ( void );
+void   ramdiskSetCard ( uint8 present );
+void   ramdiskCutAfter ( int32 bytes );
+uint8  ramdiskIsCut ( void );
+void   ramdiskPowerCycle ( void );
+void   ramdiskStats ( ramdisk_stats_t * stats, uint8 reset );
+int32  ramdiskPut ( const char * name, const void * data, uint32 len );
+int32  ramdiskGet ( const char * name, void * data, uint32 len );
+int32  ramdiskSize ( const char * name );
+
+#endif
@@ -0,0 +1,44 @@
+/* ========================================
+ *
+ * Host stand-ins for the LCD, text, RTC and keypad functions the counting
+ * chain and the project store call. The display calls do nothing, keys come from the simulated
+ * keypad schedule in psoc_sim.c.
+ *
+ * ========================================
+*/
+#include "Globals.h"
+#include "LCD_drivers.h"
+#include "Keypad_functions.h"
+#include "StoreFunctions.h"
+#include "prompts.h"
+#include "psoc_sim.h"
+
+unsigned int LCD_timeout, LCD_timer;
+project_info_t project_info;
+
+void LCD_position ( BYTE cX )                                   { (void)cX; }
+void LCD_print ( char * cX )                                    { (void)cX; }
+void LCD_PrintAtPosition ( char * buffer, uint8_t position )    { (void)buffer; (void)position; }
+void LCD_PrintAtPositionCentered ( char * buffer, uint8_t line_position ) { (void)buffer; (void)line_position; }
+void DisplayStrCentered ( uint8 line, char * str )              { (void)line; (void)str; }
+void clearlcd ( void )                                          { }
+
+void current_project_text ( char * temp_str )                   { (void)temp_str; }
+void display_station_name ( char * temp_str )                   { (void)temp_str; }
+void display_depth ( BYTE function, BYTE depth_temp )           { (void)function; (void)depth_temp; }
+void display_offset ( struct offsets_struct which_offsets )     { (void)which_offsets; }
+void display_time ( BYTE cnt_temp, uint8_t line )               { (void)cnt_temp; (void)line; }
+void std_text ( void )                                          { }
+void stat_text ( void )                                         { }
+void drift_text ( void )                                        { }
+void spec_text ( void )                                         { }
+void nomograph_text ( void )                                    { }
+void trench_text ( void )                                       { }
+
+Bool check_temp ( Bool display )                                { (void)display; return TRUE; }
+void read_RTC ( date_time_t * date )                            { memset ( date, 0, sizeof(*date) ); }
+void printTimeDate ( date_time_t date )                         { (void)date; }
+
+enum buttons getLastKey ( void )                                { return (enum buttons)simLastKey ( ); }
+void wait_for_key_release ( void )                              { }
+void serviceShutDown ( void )                                   { }
@@ -0,0 +1,281 @@
+/* ========================================
+ *
+ * Golden values for the cached density kernel in Measurement.c. Over a
+ * table of calibration sets, getCalTerms/calDensityGcc and calSpecialB are
+ * compared with the double expressions they replaced and with a long
+ * double reference. "bench" as the first argument times them.
+ *
+ * ========================================
+*/
+#include <string.h>
+#include "Globals.h"
+#include "DataStructs.h"
+#include "Measurement.h"
+#include "host_test.h"
+
+uint8_t getCalibrationDepth ( uint8_t depth_inches );   // Measurement.c, no header
+
+#define ERR_BOUND(b,a,x)  ( 4.0 * 5.9604645e-8 * fabs ( 1.0 / ( b ) ) * ( fabs ( log ( a ) ) + fabs ( log ( x ) ) + 1.0 ) )
+
+/* representative cal sets, one for each depth setting from backscatter to
+   12 inch, plus the documented corner of B = 0.05. SAFE and AC read the
+   backscatter constants, so these are every DEPTHS entry a depth reaches;
+   the last of the MAX_DEPTHS entries has no depth setting. */
+typedef struct
+{
+  uint8  depth;                         // depth setting in inches, 1 is BS
+  double A, B, C;
+} cal_set_t;
+
+static const cal_set_t calSets[] =
+{
+  {  1,  3.2,  0.85, -0.08 },
+  {  2,  5.1,  0.95,  0.02 },
+  {  3,  7.5,  1.07,  0.015 },
+  {  4,  9.8,  1.18,  0.01 },
+  {  5, 12.1,  1.25, -0.005 },
+  {  6, 14.2,  1.31, -0.02 },
+  {  7, 16.0,  1.34, -0.01 },
+  {  8, 17.5,  1.36,  0.00 },
+  {  9, 18.8,  1.38,  0.005 },
+  { 10, 19.9,  1.39,  0.015 },
+  { 11, 20.8,  1.395, 0.02 },
+  { 12, 21.6,  1.40,  0.03 },
+  {  3,  1.15, 0.05,  0.0 },
+};
+#define CAL_SETS  ( sizeof(calSets) / sizeof(calSets[0]) )
+#define CAL_DEPTHS  12                  // calSets[d - 1] is depth setting d
+
+/* golden densities in GCC at the count ratios of about 1.2, 1.8 and
+   2.4 GCC for each depth, worked out once in double from the constants
+   rounded to float as the EEPROM holds them */
+static const struct { uint8 depth; float cr; double density; } golden[] =
+{
+  {  1, 1.234f, 1.199901947 },
+  {  1, 0.773f, 1.799854184 },
+  {  1, 0.496f, 2.400259766 },
+  {  2, 1.611f, 1.200049734 },
+  {  2, 0.902f, 1.800474303 },
+  {  2, 0.502f, 2.399292938 },
+  {  3, 2.062f, 1.199979809 },
+  {  3, 1.078f, 1.799978284 },
+  {  3, 0.560f, 2.400269280 },
+  {  4, 2.368f, 1.200103947 },
+  {  4, 1.162f, 1.799721067 },
+  {  4, 0.567f, 2.400250502 },
+  {  5, 2.705f, 1.199962991 },
+  {  5, 1.280f, 1.800207462 },
+  {  5, 0.607f, 2.400562663 },
+  {  6, 2.968f, 1.200087838 },
+  {  6, 1.363f, 1.800256573 },
+  {  6, 0.632f, 2.400202318 },
+  {  7, 3.215f, 1.199907924 },
+  {  7, 1.444f, 1.800090236 },
+  {  7, 0.652f, 2.399817613 },
+  {  8, 3.422f, 1.199982138 },
+  {  8, 1.513f, 1.800078245 },
+  {  8, 0.669f, 2.400126486 },
+  {  9, 3.584f, 1.199987820 },
+  {  9, 1.563f, 1.800040536 },
+  {  9, 0.680f, 2.400140052 },
+  { 10, 3.739f, 1.199926453 },
+  { 10, 1.615f, 1.800100516 },
+  { 10, 0.693f, 2.400022235 },
+  { 11, 3.880f, 1.199983076 },
+  { 11, 1.669f, 1.799868336 },
+  { 11, 0.711f, 2.400211313 },
+  { 12, 3.996f, 1.199942872 },
+  { 12, 1.708f, 1.799970272 },
+  { 12, 0.720f, 2.400268161 },
+};
+#define GOLDEN  ( sizeof(golden) / sizeof(golden[0]) )
+
+static void loadSet ( const cal_set_t * s, meas_consts_t * k )
+{
+  uint8 i = getCalibrationDepth ( s->depth );
+  const cal_terms_t * t;
+
+  NV_CONSTANTS(DEPTHS[i].A) = s->A;
+  NV_CONSTANTS(DEPTHS[i].B) = s->B;
+  NV_CONSTANTS(DEPTHS[i].C) = s->C;
+  t = getCalTerms ( s->depth );
+  k->lnA  = t->lnA;
+  k->invB = t->invB;
+  k->Cd   = t->C;
+}
+
+/* the expressions before the cache: float constants, double log */
+static float oldDensity ( float Ad, float Bd, float Cd, float cr )
+{
+  return 1 / Bd * log ( Ad / ( cr + Cd ) );
+}
+
+static float oldSpecialB ( float a, float c, float cr, float den )
+{
+  return log ( a / ( cr + c ) ) / den;
+}
+
+static long double exactDensity ( const cal_set_t * s, float cr )
+{
+  return logl ( (long double)s->A / ( (long double)cr + s->C ) ) / s->B;
+}
+
+/* each set over its working range, 1.0 to 2.8 GCC */
+static void testTable ( void )
+{
+  meas_consts_t k;
+  double d, cr_f, err_new, err_old, worst_new = 0, worst_old = 0, worst_b = 0, worst_diff = 0, bound;
+  long double exact;
+  float cr, b_new, b_old;
+  uint8 i;
+  uint16 j;
+
+  printf ( "  depth   A      B      C     max |new-exact|  max |old-exact|  bound     max |B new-old|/B\n" );
+  for ( i = 0; i < CAL_SETS; i++ )
+  {
+    loadSet ( &calSets[i], &k );
+    worst_new = worst_old = worst_b = 0;
+    bound = 0;
+    for ( j = 0; j <= 1000; j++ )
+    {
+      d    = 1.0 + 1.8 * j / 1000;
+      cr_f = calSets[i].A * exp ( -calSets[i].B * d ) - calSets[i].C;
+      cr   = (float)cr_f;
+      exact   = exactDensity ( &calSets[i], cr );
+      err_new = fabsl ( calDensityGcc ( &k, cr ) - exact );
+      err_old = fabsl ( oldDensity ( calSets[i].A, calSets[i].B, calSets[i].C, cr ) - exact );
+      worst_new = ( err_new > worst_new ) ? err_new : worst_new;
+      worst_old = ( err_old > worst_old ) ? err_old : worst_old;
+      if ( ERR_BOUND ( calSets[i].B, calSets[i].A, cr + calSets[i].C ) > bound )
+      {
+        bound = ERR_BOUND ( calSets[i].B, calSets[i].A, cr + calSets[i].C );
+      }
+      CHECK ( err_new <= ERR_BOUND ( calSets[i].B, calSets[i].A, cr + calSets[i].C ) );
+      b_new = calSpecialB ( calSets[i].depth, cr, (float)exact );
+      b_old = oldSpecialB ( calSets[i].A, calSets[i].C, cr, (float)exact );
+      err_new = fabs ( b_new - b_old ) / calSets[i].B;
+      worst_b = ( err_new > worst_b ) ? err_new : worst_b;
+    }
+    printf ( "  %5u %6.2f %6.3f %6.3f   %.2e         %.2e         %.2e  %.2e\n", calSets[i].depth, calSets[i].A,
+             calSets[i].B, calSets[i].C, worst_new, worst_old, bound, worst_b );
+    CHECK ( worst_new < 1e-4 );         // the display shows 0.001 GCC
+    CHECK ( worst_b < 1e-5 );
+    worst_diff = ( worst_new > worst_diff ) ? worst_new : worst_diff;
+  }
+  printf ( "  largest density error of the cached kernel: %.2e GCC\n", worst_diff );
+}
+
+static void testGolden ( void )
+{
+  meas_consts_t k;
+  const cal_set_t * s;
+  uint8 i, d, seen[MAX_DEPTHS];
+
+  memset ( seen, 0, sizeof(seen) );
+  for ( i = 0; i < CAL_DEPTHS; i++ )
+  {
+    loadSet ( &calSets[i], &k );        // every depth holds its own constants at once
+  }
+  for ( i = 0; i < GOLDEN; i++ )
+  {
+    s = &calSets[golden[i].depth - 1];
+    loadSet ( s, &k );
+    CHECK_NEAR ( calDensityGcc ( &k, golden[i].cr ), golden[i].density, 2e-6 );
+    CHECK_NEAR ( calSpecialB ( s->depth, golden[i].cr, golden[i].density ), s->B, 2e-6 );
+    seen[getCalibrationDepth ( s->depth )] = TRUE;
+  }
+  // SAFE to AC, each depth setting reads a DEPTHS entry with golden values
+  for ( d = 0; d <= 13; d++ )
+  {
+    CHECK ( seen[getCalibrationDepth ( d )] );
+  }
+  CHECK ( getCalTerms ( 0 ) == getCalTerms ( 1 ) );
+  CHECK ( getCalTerms ( 13 ) == getCalTerms ( 1 ) );
+}
+
+/* new constants are picked up on the next call, without a hook */
+static void testCacheRefresh ( void )
+{
+  uint8 i = getCalibrationDepth ( 6 );
+  const cal_terms_t * t;
+
+  NV_CONSTANTS(DEPTHS[i].A) = 14.2;
+  NV_CONSTANTS(DEPTHS[i].B) = 1.31;
+  NV_CONSTANTS(DEPTHS[i].C) = -0.02;
+  t = getCalTerms ( 6 );
+  CHECK_NEAR ( t->invB, 1 / 1.31, 1e-7 );
+  NV_CONSTANTS(DEPTHS[i].B) = 1.25;
+  t = getCalTerms ( 6 );
+  CHECK_NEAR ( t->invB, 1 / 1.25, 1e-7 );
+  NV_CONSTANTS(DEPTHS[i].A) = 15.0;
+  t = getCalTerms ( 6 );
+  CHECK_NEAR ( t->lnA, log ( 15.0 ), 1e-6 );
+}
+
+static void bench ( void )
+{
+  meas_consts_t k;
+  volatile float sink = 0;
+  const cal_terms_t * volatile tp;
+  uint32 i, n = 10000000;
+  uint8 idx = getCalibrationDepth ( 6 );
+  double t0, t_hit, t_miss, t_new, t_old, t_b, t_b_old;
+
+  loadSet ( &calSets[5], &k );
+  t0 = hostSeconds ( );
+  for ( i = 0; i < n; i++ )
+  {
+    tp = getCalTerms ( 6 );
+  }
+  t_hit = hostSeconds ( ) - t0;
+  t0 = hostSeconds ( );
+  for ( i = 0; i < n / 10; i++ )
+  {
+    NV_CONSTANTS(DEPTHS[idx].B) = ( i & 1 ) ? 1.31 : 1.30;
+    tp = getCalTerms ( 6 );
+  }
+  t_miss = hostSeconds ( ) - t0;
+  loadSet ( &calSets[5], &k );
+  t0 = hostSeconds ( );
+  for ( i = 0; i < n; i++ )
+  {
+    sink += calDensityGcc ( &k, 0.5f + ( i & 1023 ) * 0.001f );
+  }
+  t_new = hostSeconds ( ) - t0;
+  t0 = hostSeconds ( );
+  for ( i = 0; i < n; i++ )
+  {
+    sink += oldDensity ( 14.2f, 1.31f, -0.02f, 0.5f + ( i & 1023 ) * 0.001f );
+  }
+  t_old = hostSeconds ( ) - t0;
+  t0 = hostSeconds ( );
+  for ( i = 0; i < n; i++ )
+  {
+    sink += calSpecialB ( 6, 0.5f + ( i & 1023 ) * 0.001f, 2.0f );
+  }
+  t_b = hostSeconds ( ) - t0;
+  t0 = hostSeconds ( );
+  for ( i = 0; i < n; i++ )
+  {
+    sink += oldSpecialB ( 14.2f, -0.02f, 0.5f + ( i & 1023 ) * 0.001f, 2.0f );
+  }
+  t_b_old = hostSeconds ( ) - t0;
+  (void)tp;
+  printf ( "getCalTerms: %.1f ns cached, %.1f ns after a constant changed\n", t_hit * 1e9 / n, t_miss * 1e10 / n );
+  printf ( "calDensityGcc: %.1f ns, old double expression %.1f ns\n", t_new * 1e9 / n, t_old * 1e9 / n );
+  printf ( "calSpecialB: %.1f ns, old double expression %.1f ns\n", t_b * 1e9 / n, t_b_old * 1e9 / n );
+}
+
+int main ( int argc, char ** argv )
+{
+  memset ( &eepromData, 0, sizeof(eepromData) );
+  if ( ( argc > 1 ) && ( strcmp ( argv[1], "bench" ) == 0 ) )
+  {
+    bench ( );
+    return 0;
+  }
+  testTable ( );
+  testGolden ( );
+  testCacheRefresh ( );
+  return hostTestEnd ( "test_cal_terms" );
+}
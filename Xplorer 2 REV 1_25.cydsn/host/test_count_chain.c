@@ -0,0 +1,245 @@
+/* ========================================
+ *
+ * Host simulation of the counting chain: measurePulses and
+ * measurePulsesStandardCount from Tests.c over PulseCounter.c, and the
+ * density/moisture math of measureMoistureDensity, driven by the seeded
+ * Poisson tubes, one shot, msTimer and keypad of sim/psoc_sim.c.
+ * "bench" as the first argument reports throughput and how closely the
+ * single precision math agrees with a double reference.
+ *
+ * ========================================
+*/
+#include <string.h>
+#include "Globals.h"
+#include "DataStructs.h"
+#include "Tests.h"
+#include "Measurement.h"
+#include "PulseCounter.h"
+#include "Keypad_functions.h"
+#include "LCD_drivers.h"
+#include "psoc_sim.h"
+#include "host_test.h"
+
+#define GM_CPS          600.0           // field rates, about 1.8 GCC with the constants below
+#define HE3_CPS         60.0
+#define CAL_DEPTH       6
+#define CAL_A           6.0             // WD = 1/B ln ( A / ( CR + C ) )
+#define CAL_B           1.0
+#define CAL_C           0.0
+#define CAL_E           0.02            // M = ( MCR - E ) / F
+#define CAL_F           0.6
+#define D_STAND         2800            // standard counts per 3.75s
+#define M_STAND         600
+
+/* a calibrated gauge with no offsets, as a user would have it after
+   auto_initialization and entering constants */
+static void setupGauge ( void )
+{
+  memset ( &eepromData, 0, sizeof(eepromData) );
+  NV_CONSTANTS(DEPTHS[DEPTH_6_INCH].A) = CAL_A;
+  NV_CONSTANTS(DEPTHS[DEPTH_6_INCH].B) = CAL_B;
+  NV_CONSTANTS(DEPTHS[DEPTH_6_INCH].C) = CAL_C;
+  NV_CONSTANTS(E_MOIST_CONST) = CAL_E;
+  NV_CONSTANTS(F_MOIST_CONST) = CAL_F;
+  eepromData.DEN_STAND   = D_STAND;
+  eepromData.MOIST_STAND = M_STAND;
+  eepromData.PROCTOR     = 1800;
+  eepromData.gauge_type  = GAUGE_3440;  // no temperature check in measurePulses
+  Offsets.den_offset_pos   = 0;
+  Offsets.moist_offset_pos = 0;
+  Offsets.tren_offset_pos  = 0;
+  Spec_flags.spec_cal_flag = FALSE;
+  Spec_flags.self_test     = FALSE;
+  Features.language_f      = 1;
+  Features.adaptive_count  = 0;
+  Features.dummy_mode      = FALSE;
+  Flags.stand_flag = Flags.stat_flag = Flags.drift_flag = Flags.in_spec_cal = 0;
+}
+
+static void startScenario ( uint64 seed, double gm_cps, double he3_cps )
+{
+  simReset ( seed );
+  simSetRate ( PROBE_GM_COUNT, gm_cps );
+  simSetRate ( PROBE_HE3_COUNT, he3_cps );
+}
+
+/* density and moisture in KG/M3 worked out in double from counts per 3.75s */
+static void referenceResult ( double d_cnt, double m_cnt, double * density, double * moisture )
+{
+  double mcr = m_cnt / M_STAND, cr = d_cnt / D_STAND;
+  double m_gcc = ( mcr - CAL_E ) / CAL_F;
+
+  *moisture = m_gcc / GCC_TO_KG;
+  *density  = ( log ( CAL_A / ( cr + CAL_C ) ) / CAL_B - m_gcc / 20 ) / GCC_TO_KG;
+}
+
+/* a 60s field count divides the raw counts by 16 and stores them */
+static void testFieldCount ( void )
+{
+  uint32 d_cnt;
+  uint16 m_cnt;
+
+  setupGauge ( );
+  startScenario ( 1, GM_CPS, HE3_CPS );
+  measurePulses ( LINE3, 60, &m_cnt, &d_cnt, CAL_DEPTH );
+  CHECK ( simNowMs ( ) >= 60000 );
+  CHECK ( simNowMs ( ) < 60500 );
+  CHECK ( d_cnt == simDelivered ( PROBE_GM_COUNT ) / 16 );
+  CHECK ( m_cnt == simDelivered ( PROBE_HE3_COUNT ) / 16 );
+  CHECK_NEAR ( d_cnt, GM_CPS * 3.75, 5 * sqrt ( GM_CPS * 60 ) / 16 );
+  CHECK_NEAR ( m_cnt, HE3_CPS * 3.75, 5 * sqrt ( HE3_CPS * 60 ) / 16 );
+  CHECK ( eepromData.D_CNT_AVG == d_cnt );
+  CHECK ( eepromData.M_CNT_AVG == m_cnt );
+  CHECK ( last_count_ms == 60000 );
+}
+
+/* the same seed gives the same counts, another seed does not */
+static void testDeterministic ( void )
+{
+  uint32 d1, d2, d3;
+  uint16 m1, m2, m3;
+
+  setupGauge ( );
+  startScenario ( 42, GM_CPS, HE3_CPS );
+  measurePulses ( LINE3, 15, &m1, &d1, CAL_DEPTH );
+  startScenario ( 42, GM_CPS, HE3_CPS );
+  measurePulses ( LINE3, 15, &m2, &d2, CAL_DEPTH );
+  startScenario ( 43, GM_CPS, HE3_CPS );
+  measurePulses ( LINE3, 15, &m3, &d3, CAL_DEPTH );
+  CHECK ( ( d1 == d2 ) && ( m1 == m2 ) );
+  CHECK ( ( d1 != d3 ) || ( m1 != m3 ) );
+}
+
+/* ESC during a count stops it and leaves the stored counts alone, ENTER
+   asks for a restart */
+static void testKeypad ( void )
+{
+  uint32 d_cnt = 0;
+  uint16 m_cnt = 0;
+
+  setupGauge ( );
+  eepromData.D_CNT_AVG = 1234;
+  startScenario ( 2, GM_CPS, HE3_CPS );
+  simPressKey ( 10000, ESC );
+  measurePulses ( LINE3, 60, &m_cnt, &d_cnt, CAL_DEPTH );
+  CHECK ( simNowMs ( ) < 11000 );
+  CHECK ( eepromData.D_CNT_AVG == 1234 );
+  CHECK ( checkCountDone ( ) == FALSE );
+
+  startScenario ( 3, GM_CPS, HE3_CPS );
+  simPressKey ( 5000, ENTER );
+  measurePulses ( LINE3, 60, &m_cnt, &d_cnt, CAL_DEPTH );
+  CHECK ( Controls.reset_count == TRUE );
+  CHECK ( simNowMs ( ) < 6000 );
+}
+
+/* with adaptive counts the count stops at the precision target and the
+   counts are scaled to 3.75s */
+static void testPrecisionStop ( void )
+{
+  uint32 d_cnt;
+  uint16 m_cnt;
+
+  setupGauge ( );
+  Features.adaptive_count = 1;
+  eepromData.COUNT_RSE    = 200;        // 2%, 2501 counts of each tube
+  startScenario ( 4, GM_CPS, HE3_CPS );
+  measurePulses ( LINE3, 240, &m_cnt, &d_cnt, CAL_DEPTH );
+  CHECK ( last_count_ms < 240000 );
+  CHECK_NEAR ( last_count_ms, 2501 / HE3_CPS * 1000, 5000 );
+  CHECK_NEAR ( d_cnt, GM_CPS * 3.75, 5 * GM_CPS * 3.75 * 0.02 );
+  CHECK_NEAR ( m_cnt, HE3_CPS * 3.75, 5 * HE3_CPS * 3.75 * 0.02 );
+  CHECK ( last_count_rse <= 2.0 );
+}
+
+/* the standard count takes 32 sub-counts of 7.5s, each halved */
+static void testStandardCount ( void )
+{
+  std_stats_t stats;
+
+  setupGauge ( );
+  memset ( &stats, 0, sizeof(stats) );
+  Features.std_early_accept = 0;
+  startScenario ( 5, D_STAND / 3.75, M_STAND / 3.75 );
+  measurePulsesStandardCount ( LINE4, &stats );
+  CHECK ( stats.taken == 32 );
+  CHECK ( simNowMs ( ) >= 240000 );
+  CHECK_NEAR ( stats.d.mean, D_STAND, 5 * sqrt ( D_STAND / 2.0 / 32 ) );
+  CHECK_NEAR ( stats.m.mean, M_STAND, 5 * sqrt ( M_STAND / 2.0 / 32 ) );
+  CHECK_NEAR ( stats.d.mean * stats.taken, ( simDelivered ( PROBE_GM_COUNT ) / 2.0 ), 16 * stats.rejected + 16 );
+}
+
+/* the whole reading agrees with the double reference on the same counts,
+   and with the true density within the count scatter */
+static void testReading ( void )
+{
+  meas_consts_t k;
+  meas_result_t r;
+  double d_ref, m_ref, d_true, m_true;
+  uint32 d_cnt;
+  uint16 m_cnt;
+
+  setupGauge ( );
+  startScenario ( 6, GM_CPS, HE3_CPS );
+  measurePulses ( LINE3, 60, &m_cnt, &d_cnt, CAL_DEPTH );
+  loadMeasConsts ( CAL_DEPTH, &k );
+  calcMoistureDensity ( d_cnt, m_cnt, &k, &r );
+  referenceResult ( d_cnt, m_cnt, &d_ref, &m_ref );
+  referenceResult ( GM_CPS * 3.75, HE3_CPS * 3.75, &d_true, &m_true );
+  CHECK_NEAR ( r.density, d_ref, 0.05 );
+  CHECK_NEAR ( r.moisture, m_ref, 0.05 );
+  CHECK_NEAR ( r.density, d_true, 20 );
+  CHECK_NEAR ( r.moisture, m_true, 20 );
+}
+
+/* simulated seconds per host second of a 60s reading, and the spread of
+   the float readings against the double reference over many seeds */
+static void bench ( void )
+{
+  meas_consts_t k;
+  meas_result_t r;
+  double t0, t, d_ref, m_ref, d_true, m_true, err, max_d = 0, max_m = 0, sum_d = 0, sum_dd = 0;
+  uint32 d_cnt, i, runs = 200;
+  uint16 m_cnt;
+
+  setupGauge ( );
+  loadMeasConsts ( CAL_DEPTH, &k );
+  referenceResult ( GM_CPS * 3.75, HE3_CPS * 3.75, &d_true, &m_true );
+  t0 = hostSeconds ( );
+  for ( i = 0; i < runs; i++ )
+  {
+    startScenario ( 1000 + i, GM_CPS, HE3_CPS );
+    measurePulses ( LINE3, 60, &m_cnt, &d_cnt, CAL_DEPTH );
+    calcMoistureDensity ( d_cnt, m_cnt, &k, &r );
+    referenceResult ( d_cnt, m_cnt, &d_ref, &m_ref );
+    err   = fabs ( r.density - d_ref );
+    max_d = ( err > max_d ) ? err : max_d;
+    err   = fabs ( r.moisture - m_ref );
+    max_m = ( err > max_m ) ? err : max_m;
+    sum_d  += r.density - d_true;
+    sum_dd += ( r.density - d_true ) * ( r.density - d_true );
+  }
+  t = hostSeconds ( ) - t0;
+  printf ( "%u readings of 60s at %.0f/%.0f cps: %.2f s host, %.0fx real time, %.0f pulses/s\n",
+           runs, GM_CPS, HE3_CPS, t, runs * 60.0 / t, runs * 60.0 * ( GM_CPS + HE3_CPS ) / t );
+  printf ( "float vs double on the same counts: max %.2e KG/M3 density, %.2e KG/M3 moisture\n", max_d, max_m );
+  printf ( "density vs true %.1f KG/M3: bias %+.2f, SD %.2f KG/M3\n", d_true,
+           sum_d / runs, sqrt ( sum_dd / runs - ( sum_d / runs ) * ( sum_d / runs ) ) );
+}
+
+int main ( int argc, char ** argv )
+{
+  initPulseCntStrt ( );
+  if ( ( argc > 1 ) && ( strcmp ( argv[1], "bench" ) == 0 ) )
+  {
+    bench ( );
+    return 0;
+  }
+  testFieldCount ( );
+  testDeterministic ( );
+  testKeypad ( );
+  testPrecisionStop ( );
+  testStandardCount ( );
+  testReading ( );
+  return hostTestEnd ( "test_count_chain" );
+}
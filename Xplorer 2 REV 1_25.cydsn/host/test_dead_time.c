@@ -0,0 +1,167 @@
+/* ========================================
+ *
+ * Host test of the dead time correction stage in PulseCounter.c against
+ * synthetic Poisson streams from tubes with a simulated dead time. "bench"
+ * as the first argument sweeps the true rate and reports how far each
+ * model extends the usable count rate range.
+ *
+ * ========================================
+*/
+#include <string.h>
+#include "Globals.h"
+#include "DataStructs.h"
+#include "PulseCounter.h"
+#include "psoc_sim.h"
+#include "host_test.h"
+
+#define TAU_US          100.0           // dead time of the simulated GM tube
+#define USABLE_BIAS     0.01            // a rate is usable while the count is within 1%
+
+/* one count of the GM tube at a true rate, returns the raw counts */
+static uint32 countAt ( uint64 seed, double cps, uint8 model, float secs )
+{
+  simReset ( seed );
+  simSetRate ( PROBE_GM_COUNT, cps );
+  simSetDeadTime ( PROBE_GM_COUNT, TAU_US * 1.0e-6, model );
+  resetPulseTimers ( );
+  PulseCntStrt ( secs );
+  while ( !checkCountDone ( ) )
+  {
+    CyDelay ( 250 );
+  }
+  return getGMPulseCounts ( );
+}
+
+static void setDeadTime ( uint8 model, float tau_gm, float tau_he3 )
+{
+  eepromData.DT_MODEL   = model;
+  eepromData.DT_TAU_GM  = tau_gm;
+  eepromData.DT_TAU_HE3 = tau_he3;
+}
+
+/* the inverse models give back the rate the forward models produce */
+static void testInverse ( void )
+{
+  double n, tau = TAU_US * 1.0e-6;
+
+  for ( n = 100; n < 9000; n *= 1.5 )
+  {
+    CHECK_NEAR ( deadTimeTrueRate ( n / ( 1.0 + n * tau ), tau, DEAD_TIME_NON_PARALYZABLE ), n, n * 1e-5 );
+    CHECK_NEAR ( deadTimeTrueRate ( n * exp ( -n * tau ), tau, DEAD_TIME_PARALYZABLE ), n, n * 1e-4 );
+  }
+  CHECK ( deadTimeTrueRate ( 5000, tau, DEAD_TIME_OFF ) == 5000 );
+  CHECK ( deadTimeTrueRate ( 0, tau, DEAD_TIME_PARALYZABLE ) == 0 );
+  CHECK_NEAR ( deadTimeTrueRate ( 4000, tau, DEAD_TIME_PARALYZABLE ), 1.0 / tau, 1e-3 );  // past the peak
+}
+
+/* settings that aren't usable leave the counts alone */
+static void testUnset ( void )
+{
+  setDeadTime ( DEAD_TIME_OFF, TAU_US, TAU_US );
+  CHECK ( deadTimeCorrect ( 300000, 60000, PROBE_GM_COUNT ) == 300000 );
+  setDeadTime ( 7, TAU_US, TAU_US );
+  CHECK ( deadTimeCorrect ( 300000, 60000, PROBE_GM_COUNT ) == 300000 );
+  setDeadTime ( DEAD_TIME_NON_PARALYZABLE, NAN, NAN );
+  CHECK ( deadTimeCorrect ( 300000, 60000, PROBE_GM_COUNT ) == 300000 );
+  setDeadTime ( DEAD_TIME_NON_PARALYZABLE, DEAD_TIME_MAX_US + 1, 0 );
+  CHECK ( deadTimeCorrect ( 300000, 60000, PROBE_GM_COUNT ) == 300000 );
+  CHECK ( deadTimeCorrect ( 300000, 60000, PROBE_HE3_COUNT ) == 300000 );
+  setDeadTime ( DEAD_TIME_NON_PARALYZABLE, TAU_US, 0 );
+  CHECK ( deadTimeCorrect ( 300000, 0, PROBE_GM_COUNT ) == 300000 );
+  CHECK ( deadTimeCorrect ( 300000, 60000, PROBE_HE3_COUNT ) == 300000 );
+  CHECK ( deadTimeCorrect ( 300000, 60000, PROBE_GM_COUNT ) > 300000 );
+}
+
+/* counts from a dead time limited tube come back to the true counts,
+   within the Poisson scatter, while the raw counts are well short */
+static void testPoisson ( uint8 model, uint8 sim_model )
+{
+  static const double rates[] = { 1000, 3000, 6000 };
+  double expect, tol;
+  uint32 raw, fixed;
+  uint8 i;
+
+  setDeadTime ( model, TAU_US, TAU_US );
+  for ( i = 0; i < sizeof(rates) / sizeof(rates[0]); i++ )
+  {
+    raw    = countAt ( 10 + i, rates[i], sim_model, 60 );
+    fixed  = deadTimeCorrect ( raw, 60000, PROBE_GM_COUNT );
+    expect = rates[i] * 60;
+    tol    = 5 * sqrt ( expect ) * ( (double)fixed / raw );  // scatter grows with the correction
+    CHECK_NEAR ( fixed, expect, tol );
+    CHECK ( expect - raw > 5 * sqrt ( expect ) );
+  }
+}
+
+/* the highest true rate up to which counts stay within USABLE_BIAS, raw
+   and corrected. Each point sums about 10^6 counts so the scatter (0.1%)
+   is well below the bias being judged. */
+static void benchRange ( const char * name, uint8 model, uint8 sim_model )
+{
+  double cps, expect, raw_limit = 0, fix_limit = 0;
+  uint32 raw, k, runs;
+  uint64 raw_sum, fix_sum;
+  uint8 raw_ok = TRUE, fix_ok = TRUE;
+
+  setDeadTime ( model, TAU_US, TAU_US );
+  for ( cps = 50; ( cps <= 12000 ) && ( raw_ok || fix_ok ); cps *= 1.1 )
+  {
+    runs = (uint32)ceil ( 1.0e6 / ( cps * 240 ) );
+    raw_sum = fix_sum = 0;
+    for ( k = 0; k < runs; k++ )
+    {
+      raw = countAt ( 100 + k, cps, sim_model, 240 );
+      raw_sum += raw;
+      fix_sum += deadTimeCorrect ( raw, 240000, PROBE_GM_COUNT );
+    }
+    expect = cps * 240 * runs;
+    raw_ok = raw_ok && ( fabs ( raw_sum / expect - 1.0 ) < USABLE_BIAS );
+    fix_ok = fix_ok && ( fabs ( fix_sum / expect - 1.0 ) < USABLE_BIAS );
+    raw_limit = raw_ok ? cps : raw_limit;
+    fix_limit = fix_ok ? cps : fix_limit;
+  }
+  printf ( "%-16s tau %.0f us: within %.0f%% up to %5.0f cps raw, %5.0f cps corrected (%.0fx)\n",
+           name, TAU_US, USABLE_BIAS * 100, raw_limit, fix_limit, fix_limit / raw_limit );
+}
+
+static void bench ( void )
+{
+  volatile uint32 sink = 0;
+  uint32 i, calls = 1000000;
+  double t0, t_np, t_p;
+
+  benchRange ( "non-paralyzable", DEAD_TIME_NON_PARALYZABLE, SIM_DEAD_NON_PARALYZABLE );
+  benchRange ( "paralyzable", DEAD_TIME_PARALYZABLE, SIM_DEAD_PARALYZABLE );
+
+  setDeadTime ( DEAD_TIME_NON_PARALYZABLE, TAU_US, TAU_US );
+  t0 = hostSeconds ( );
+  for ( i = 0; i < calls; i++ )
+  {
+    sink += deadTimeCorrect ( 200000 + ( i & 0xFFFF ), 60000, PROBE_GM_COUNT );
+  }
+  t_np = hostSeconds ( ) - t0;
+  setDeadTime ( DEAD_TIME_PARALYZABLE, TAU_US, TAU_US );
+  t0 = hostSeconds ( );
+  for ( i = 0; i < calls; i++ )
+  {
+    sink += deadTimeCorrect ( 200000 + ( i & 0xFFFF ), 60000, PROBE_GM_COUNT );
+  }
+  t_p = hostSeconds ( ) - t0;
+  printf ( "deadTimeCorrect: %.1f ns non-paralyzable, %.1f ns paralyzable on the host\n",
+           t_np * 1e9 / calls, t_p * 1e9 / calls );
+}
+
+int main ( int argc, char ** argv )
+{
+  initPulseCntStrt ( );
+  if ( ( argc > 1 ) && ( strcmp ( argv[1], "bench" ) == 0 ) )
+  {
+    bench ( );
+    return 0;
+  }
+  testInverse ( );
+  testUnset ( );
+  testPoisson ( DEAD_TIME_NON_PARALYZABLE, SIM_DEAD_NON_PARALYZABLE );
+  testPoisson ( DEAD_TIME_PARALYZABLE, SIM_DEAD_PARALYZABLE );
+  return hostTestEnd ( "test_dead_time" );
+}
@@ -0,0 +1,372 @@
+/* ========================================
+ *
+ * Host test of the time-binned pulse capture in PulseCounter.c, run over
+ * the simulated counters and one shot. "bench" as the first argument
+ * times the ms tick and the ring buffer reads instead.
+ *
+ * ========================================
+*/
+#include <string.h>
+#include "Globals.h"
+#include "PulseCounter.h"
+#include "psoc_sim.h"
+#include "host_test.h"
+
+/* run a count to its end, polling every 250ms like measurePulses */
+static void runCount ( float secs, uint16 * seen, uint32 * polled_gm, uint32 * polled_he3 )
+{
+  pulse_bin_t bins[16];
+  uint16 n, i;
+
+  resetPulseTimers ( );
+  PulseCntStrt ( secs );
+  while ( !checkCountDone ( ) )
+  {
+    CyDelay ( 250 );
+    if ( seen != NULL )
+    {
+      while ( ( n = readNewPulseBins ( seen, bins, 16 ) ) > 0 )
+      {
+        for ( i = 0; i < n; i++ )
+        {
+          *polled_gm  += bins[i].gm;
+          *polled_he3 += bins[i].he3;
+        }
+      }
+    }
+  }
+}
+
+static void sumBins ( uint32 * gm, uint32 * he3, uint32 * ms, uint16 * n )
+{
+  static pulse_bin_t bins[PULSE_BIN_DEPTH];
+  uint16 i;
+
+  *n = readPulseBins ( bins, PULSE_BIN_DEPTH );
+  *gm = *he3 = *ms = 0;
+  for ( i = 0; i < *n; i++ )
+  {
+    *gm  += bins[i].gm;
+    *he3 += bins[i].he3;
+    *ms  += bins[i].ms;
+  }
+}
+
+/* bins of a short count hold the whole count and sum to the totals */
+static void testShortCount ( void )
+{
+  uint32 gm, he3, ms, edge_gm, edge_he3;
+  uint16 n;
+
+  simReset ( 1 );
+  simSetRate ( PROBE_GM_COUNT, 3000 );
+  simSetRate ( PROBE_HE3_COUNT, 300 );
+  setPulseBinCapture ( 250 );
+  runCount ( 7.5, NULL, NULL, NULL );
+
+  CHECK ( getGMPulseCounts ( ) == simDelivered ( PROBE_GM_COUNT ) );
+  CHECK ( getHEPulseCounts ( ) == simDelivered ( PROBE_HE3_COUNT ) );
+  CHECK ( getPulseBinTotal ( ) == 30 );
+  sumBins ( &gm, &he3, &ms, &n );
+  CHECK ( n == 30 );
+  CHECK ( gm == getGMPulseCounts ( ) );
+  CHECK ( he3 == getHEPulseCounts ( ) );
+  CHECK ( ms == 7500 );
+  CHECK ( getPulseBinEdge ( &edge_gm, &edge_he3 ) == 7500 );
+  CHECK ( edge_gm == getGMPulseCounts ( ) );
+  CHECK ( edge_he3 == getHEPulseCounts ( ) );
+  CHECK_NEAR ( gm / 7.5, 3000, 5 * sqrt ( 3000 / 7.5 ) );
+}
+
+/* a bin length that doesn't divide the count leaves a short last bin */
+static void testPartialBin ( void )
+{
+  static pulse_bin_t bins[PULSE_BIN_DEPTH];
+  uint32 gm, he3, ms;
+  uint16 n;
+
+  simReset ( 2 );
+  simSetRate ( PROBE_GM_COUNT, 2000 );
+  simSetRate ( PROBE_HE3_COUNT, 200 );
+  setPulseBinCapture ( 400 );
+  runCount ( 7.5, NULL, NULL, NULL );
+
+  sumBins ( &gm, &he3, &ms, &n );
+  CHECK ( n == 19 );
+  CHECK ( ms == 7500 );
+  CHECK ( gm == getGMPulseCounts ( ) );
+  readPulseBins ( bins, PULSE_BIN_DEPTH );
+  CHECK ( bins[0].ms == 400 );
+  CHECK ( bins[n - 1].ms == 300 );
+  setPulseBinCapture ( PULSE_BIN_MS_DEFAULT );
+}
+
+/* a 60s count overruns the ring, the edge totals and a reader polling
+   every 250ms still see every count */
+static void testRingOverrun ( void )
+{
+  uint32 gm, he3, ms, edge_gm, edge_he3, polled_gm = 0, polled_he3 = 0;
+  uint16 n, seen = 0;
+
+  simReset ( 3 );
+  simSetRate ( PROBE_GM_COUNT, 8000 );
+  simSetRate ( PROBE_HE3_COUNT, 500 );
+  setPulseBinCapture ( 250 );
+  runCount ( 60, &seen, &polled_gm, &polled_he3 );
+
+  CHECK ( getPulseBinTotal ( ) == 240 );
+  sumBins ( &gm, &he3, &ms, &n );
+  CHECK ( n == PULSE_BIN_DEPTH );
+  CHECK ( ms == PULSE_BIN_DEPTH * 250 );
+  CHECK ( gm < getGMPulseCounts ( ) );
+  CHECK ( getPulseBinEdge ( &edge_gm, &edge_he3 ) == 60000 );
+  CHECK ( edge_gm == getGMPulseCounts ( ) );
+  CHECK ( edge_he3 == getHEPulseCounts ( ) );
+  CHECK ( polled_gm == getGMPulseCounts ( ) );
+  CHECK ( polled_he3 == getHEPulseCounts ( ) );
+  CHECK ( seen == 240 );
+}
+
+/* a reader that falls behind skips what the ring lost and says so */
+static void testSlowReader ( void )
+{
+  pulse_bin_t bins[PULSE_BIN_DEPTH];
+  uint16 seen = 0, n;
+
+  simReset ( 4 );
+  simSetRate ( PROBE_GM_COUNT, 1000 );
+  simSetRate ( PROBE_HE3_COUNT, 100 );
+  runCount ( 60, NULL, NULL, NULL );
+
+  n = readNewPulseBins ( &seen, bins, PULSE_BIN_DEPTH );
+  CHECK ( n == PULSE_BIN_DEPTH );
+  CHECK ( seen == 240 );
+  CHECK ( readNewPulseBins ( &seen, bins, PULSE_BIN_DEPTH ) == 0 );
+}
+
+/* 8 bit counters refuse the wide reload, the 200 count reload still
+   counts every pulse at 50k cps */
+static void testNarrowCounters ( void )
+{
+  uint32 gm, he3, ms;
+  uint16 n;
+
+  simReset ( 5 );
+  simSetCounterBits ( 8 );
+  CHECK ( setPulseReload ( PULSE_COUNTER_RELOAD_WIDE ) == FALSE );
+  CHECK ( getPulseReload ( ) == PULSE_COUNTER_RELOAD );
+  simSetRate ( PROBE_GM_COUNT, 50000 );
+  simSetRate ( PROBE_HE3_COUNT, 400 );
+  runCount ( 7.5, NULL, NULL, NULL );
+
+  CHECK ( getGMPulseCounts ( ) == simDelivered ( PROBE_GM_COUNT ) );
+  sumBins ( &gm, &he3, &ms, &n );
+  CHECK ( gm == getGMPulseCounts ( ) );
+  CHECK ( he3 == getHEPulseCounts ( ) );
+
+  simSetCounterBits ( 16 );
+  CHECK ( setPulseReload ( PULSE_COUNTER_RELOAD_WIDE ) == TRUE );
+}
+
+/* stopping early closes no more bins */
+static void testStopEarly ( void )
+{
+  uint16 total;
+
+  simReset ( 6 );
+  simSetRate ( PROBE_GM_COUNT, 3000 );
+  simSetRate ( PROBE_HE3_COUNT, 300 );
+  resetPulseTimers ( );
+  PulseCntStrt ( 60 );
+  CyDelay ( 5000 );
+  stop_ONE_SHOT_Early ( );
+  total = getPulseBinTotal ( );
+  CHECK ( total == 20 );
+  CyDelay ( 5000 );
+  CHECK ( getPulseBinTotal ( ) == total );
+  CHECK ( !checkCountDone ( ) );
+}
+
+/* a Global_ID() section holds every ISR, the ms tick included: the reload
+   wraps lost in it are still reported, and the count is exactly that many
+   reloads short */
+static void maskedCount ( float secs, uint32 mask_ms, pulse_isr_stats_t * isr )
+{
+  resetPulseTimers ( );
+  PulseCntStrt ( secs );
+  CyDelay ( 1000 );
+  simMaskIsrs ( mask_ms );
+  while ( !checkCountDone ( ) )
+  {
+    CyDelay ( 250 );
+  }
+  getPulseIsrStats ( isr );
+}
+
+static void testMaskedReloads ( void )
+{
+  pulse_isr_stats_t isr;
+  uint32 missed;
+
+  CHECK ( setPulseReload ( PULSE_COUNTER_RELOAD ) == TRUE );
+
+  simReset ( 11 );
+  simSetRate ( PROBE_GM_COUNT, 100000 );
+  simSetRate ( PROBE_HE3_COUNT, 300 );
+  maskedCount ( 5, 0, &isr );
+  CHECK ( getMissedReloads ( &isr, PROBE_GM_COUNT ) == 0 );
+  CHECK ( getGMPulseCounts ( ) == simDelivered ( PROBE_GM_COUNT ) );
+  CHECK ( checkPulseIntegrity ( &isr, PROBE_HE3_COUNT ) );
+
+  simReset ( 11 );
+  simSetRate ( PROBE_GM_COUNT, 100000 );
+  simSetRate ( PROBE_HE3_COUNT, 300 );
+  maskedCount ( 5, 50, &isr );
+  missed = getMissedReloads ( &isr, PROBE_GM_COUNT );
+  CHECK ( missed >= 20 );
+  CHECK ( getGMPulseCounts ( ) + missed * PULSE_COUNTER_RELOAD == simDelivered ( PROBE_GM_COUNT ) );
+  CHECK ( !checkPulseIntegrity ( &isr, PROBE_GM_COUNT ) );
+  CHECK ( getMissedReloads ( &isr, PROBE_HE3_COUNT ) == 0 );
+  CHECK ( getHEPulseCounts ( ) == simDelivered ( PROBE_HE3_COUNT ) );
+
+  CHECK ( setPulseReload ( PULSE_COUNTER_RELOAD_WIDE ) == TRUE );
+}
+
+/* the masked section is timed in us whatever the rate: 100ms is reported
+   and harmless at 20k cps with the wide reload, 2s is worth 40000 of the
+   50000 counts of a reload and warned about before one is lost */
+static void testIsrLatency ( void )
+{
+  pulse_isr_stats_t isr;
+
+  simReset ( 12 );
+  simSetRate ( PROBE_GM_COUNT, 20000 );
+  simSetRate ( PROBE_HE3_COUNT, 300 );
+  maskedCount ( 10, 0, &isr );
+  CHECK ( getWorstIsrLatencyUs ( &isr ) == 0 );
+  CHECK ( checkPulseIntegrity ( &isr, PROBE_GM_COUNT ) );
+
+  simReset ( 12 );
+  simSetRate ( PROBE_GM_COUNT, 20000 );
+  simSetRate ( PROBE_HE3_COUNT, 300 );
+  maskedCount ( 10, 100, &isr );
+  CHECK ( getWorstIsrLatencyUs ( &isr ) == 99000 );
+  CHECK ( checkPulseIntegrity ( &isr, PROBE_GM_COUNT ) );
+
+  simReset ( 12 );
+  simSetRate ( PROBE_GM_COUNT, 20000 );
+  simSetRate ( PROBE_HE3_COUNT, 300 );
+  maskedCount ( 10, 2000, &isr );
+  CHECK_NEAR ( getWorstIsrLatencyUs ( &isr ), 1999000, 1000 );     // the one shot times it to 1ms
+  CHECK ( getMissedReloads ( &isr, PROBE_GM_COUNT ) == 0 );
+  CHECK ( !checkPulseIntegrity ( &isr, PROBE_GM_COUNT ) );
+  CHECK ( checkPulseIntegrity ( &isr, PROBE_HE3_COUNT ) );
+}
+
+/* the dispersion is judged only once there are enough bins: a short count
+   through a saturated tube is left to the other checks, a long one is
+   flagged, and a clean long count is not */
+static uint8 qualityCount ( float secs )
+{
+  resetPulseTimers ( );
+  PulseCntStrt ( secs );
+  while ( !checkCountDone ( ) )
+  {
+    CyDelay ( 250 );
+    pulseQualityUpdate ( );
+  }
+  return getPulseQuality ( );
+}
+
+static void testDispersion ( void )
+{
+  uint8 q;
+
+  simReset ( 9 );
+  simSetRate ( PROBE_GM_COUNT, 10000 );
+  simSetRate ( PROBE_HE3_COUNT, 300 );
+  simSetDeadTime ( PROBE_GM_COUNT, 50e-6, SIM_DEAD_NON_PARALYZABLE );
+  setPulseBinCapture ( 250 );
+  q = qualityCount ( 15 );
+  CHECK ( !( PQ_FLAGS ( q, PROBE_GM_COUNT ) & PQ_NONLINEAR ) );
+  q = qualityCount ( 60 );
+  CHECK ( PQ_FLAGS ( q, PROBE_GM_COUNT ) & PQ_NONLINEAR );
+  CHECK ( !( PQ_FLAGS ( q, PROBE_HE3_COUNT ) & PQ_NONLINEAR ) );
+
+  simReset ( 10 );
+  simSetRate ( PROBE_GM_COUNT, 10000 );
+  simSetRate ( PROBE_HE3_COUNT, 300 );
+  CHECK ( qualityCount ( 60 ) == 0 );
+}
+
+/* host cost of the capture: the ms tick ISR work with and without
+   binning, a full ring read, and a simulated 240s count end to end */
+static double benchTicks ( uint16 bin_ms, uint32 ticks )
+{
+  uint32 i;
+  double t0;
+
+  simReset ( 7 );
+  setPulseBinCapture ( bin_ms );
+  resetPulseTimers ( );
+  PulseCntStrt ( 240 );
+  t0 = hostSeconds ( );
+  for ( i = 0; i < ticks; i++ )
+  {
+    pulseBinTick ( );
+  }
+  return hostSeconds ( ) - t0;
+}
+
+static void bench ( void )
+{
+  static pulse_bin_t bins[PULSE_BIN_DEPTH];
+  volatile uint32 sink = 0;
+  uint32 i, ticks = 10000000, reads = 100000;
+  double t0, t_bins, t_plain, t_read, t_count;
+
+  t_plain = benchTicks ( 0, ticks );
+  t_bins  = benchTicks ( 250, ticks );
+
+  t0 = hostSeconds ( );
+  for ( i = 0; i < reads; i++ )
+  {
+    sink += readPulseBins ( bins, PULSE_BIN_DEPTH );
+  }
+  t_read = hostSeconds ( ) - t0;
+
+  simReset ( 8 );
+  simSetRate ( PROBE_GM_COUNT, 10000 );
+  simSetRate ( PROBE_HE3_COUNT, 500 );
+  setPulseBinCapture ( 250 );
+  t0 = hostSeconds ( );
+  runCount ( 240, NULL, NULL, NULL );
+  t_count = hostSeconds ( ) - t0;
+  setPulseBinCapture ( PULSE_BIN_MS_DEFAULT );
+
+  printf ( "pulseBinTick: %.1f ns without bins, %.1f ns with 250ms bins\n",
+           t_plain * 1e9 / ticks, t_bins * 1e9 / ticks );
+  printf ( "full ring read (%u bins): %.2f us\n", PULSE_BIN_DEPTH, t_read * 1e6 / reads );
+  printf ( "simulated 240s count at 10k cps: %.3f s host (%.0fx real time)\n",
+           t_count, 240.0 / t_count );
+}
+
+int main ( int argc, char ** argv )
+{
+  initPulseCntStrt ( );
+  if ( ( argc > 1 ) && ( strcmp ( argv[1], "bench" ) == 0 ) )
+  {
+    bench ( );
+    return 0;
+  }
+  testShortCount ( );
+  testPartialBin ( );
+  testRingOverrun ( );
+  testSlowReader ( );
+  testNarrowCounters ( );
+  testStopEarly ( );
+  testMaskedReloads ( );
+  testIsrLatency ( );
+  testDispersion ( );
+  return hostTestEnd ( "test_pulse_bins" );
+}
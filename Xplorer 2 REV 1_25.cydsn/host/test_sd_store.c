@@ -0,0 +1,406 @@
+/* ========================================
+ *
+ * Host test of the SD sector cache and the journal project store in
+ * SDcard.c and ProjectData.c, run over the RAM disk in sim/ramdisk.c. The
+ * RAM disk counts what would reach the card and can cut the power part
+ * way through a write. "bench" as the first argument counts the card
+ * calls of the read pass of a 100 station USB export.
+ *
+ * ========================================
+*/
+#include <string.h>
+#include "Globals.h"
+#include "SDcard.h"
+#include "ProjectData.h"
+#include "ramdisk.h"
+#include "host_test.h"
+
+static void makeStation ( station_data_t * st, uint16 i )
+{
+  memset ( st, 0, sizeof(*st) );
+  snprintf ( st->name, PROJ_NAME_LENGTH, "S%u", i );
+  st->depth         = 6;
+  st->density_count = 1000 + i;
+  st->density       = 120.0 + i;
+}
+
+static void makeProject ( char * name, uint16 n )
+{
+  station_data_t st;
+  uint16 i;
+
+  SD_CreateProjectSimpleFile ( name );
+  for ( i = 0; i < n; i++ )
+  {
+    makeStation ( &st, i );
+    writeStation ( name, i, &st );
+    incrementStationNumber ( name );
+  }
+}
+
+/* a write past the end of the cached sector goes to the card and the
+   slot must not serve the old length or bytes afterwards */
+static void testCacheHole ( void )
+{
+  uint8 init[100], buf[400];
+  FS_FILE * file;
+  int i;
+
+  ramdiskReset ( );
+  for ( i = 0; i < 100; i++ )
+  {
+    init[i] = i;
+  }
+  ramdiskPut ( "HOLE.BIN", init, sizeof(init) );
+  file = FS_FOpen ( "HOLE.BIN", "r+" );
+  CHECK ( SDcacheWrite ( file, 10, "abc", 3 ) == 0 );
+  CHECK ( SDcacheWrite ( file, 300, "xyz", 3 ) == 0 );
+  CHECK ( SDcacheRead ( file, 300, (char*)buf, 3 ) == 0 );
+  CHECK ( memcmp ( buf, "xyz", 3 ) == 0 );
+  CHECK ( SDcacheRead ( file, 10, (char*)buf, 3 ) == 0 );
+  CHECK ( memcmp ( buf, "abc", 3 ) == 0 );
+  SDcacheClose ( file );
+  FS_FClose ( file );
+  CHECK ( ramdiskSize ( "HOLE.BIN" ) == 303 );
+  ramdiskGet ( "HOLE.BIN", buf, 303 );
+  CHECK ( memcmp ( buf + 10, "abc", 3 ) == 0 );
+  CHECK ( ( buf[99] == 99 ) && ( buf[100] == 0 ) && ( buf[299] == 0 ) );
+  CHECK ( memcmp ( buf + 300, "xyz", 3 ) == 0 );
+}
+
+/* small sequential writes gather into one write per sector */
+static void testCacheGathers ( void )
+{
+  sd_cache_stats_t io;
+  ramdisk_stats_t rd;
+  FS_FILE * file;
+  char rec[16];
+  uint16 i;
+
+  ramdiskReset ( );
+  file = FS_FOpen ( "SEQ.BIN", "wb+" );
+  getSDcacheStats ( &io, TRUE );
+  ramdiskStats ( &rd, TRUE );
+  for ( i = 0; i < 256; i++ )
+  {
+    memset ( rec, i, sizeof(rec) );
+    SDcacheWrite ( file, i * sizeof(rec), rec, sizeof(rec) );
+  }
+  SDcacheClose ( file );
+  FS_FClose ( file );
+  getSDcacheStats ( &io, TRUE );
+  ramdiskStats ( &rd, TRUE );
+  CHECK ( io.writes == 256 );
+  CHECK ( rd.writes == 8 );             // 4096 bytes, 512 per sector
+  CHECK ( ramdiskSize ( "SEQ.BIN" ) == 4096 );
+}
+
+/* SDstop writes back what the cache holds and syncs the volume */
+static void testStopFlushes ( void )
+{
+  ramdisk_stats_t rd;
+  FS_FILE * file;
+
+  ramdiskReset ( );
+  SDstart ( );
+  file = FS_FOpen ( "STOP.BIN", "wb+" );
+  SDcacheWrite ( file, 0, "abcd", 4 );
+  CHECK ( ramdiskSize ( "STOP.BIN" ) == 0 );
+  ramdiskStats ( &rd, TRUE );
+  SDstop ( null );
+  ramdiskStats ( &rd, TRUE );
+  CHECK ( ramdiskSize ( "STOP.BIN" ) == 4 );
+  CHECK ( rd.syncs == 1 );
+  SDcacheClose ( file );
+  FS_FClose ( file );
+  SDunmount ( );
+}
+
+/* journal: append, read back and rename a station */
+static void testJournal ( void )
+{
+  station_data_t st;
+  char name[PROJ_NAME_LENGTH];
+  uint16 i;
+  uint8 ok = TRUE;
+
+  ramdiskReset ( );
+  makeProject ( "JOUR", 20 );
+  CHECK ( getProjectFormat ( "JOUR" ) == PROJ_FORMAT_LOG );
+  CHECK ( getStationNumber ( "JOUR" ) == 20 );
+  CHECK ( ramdiskSize ( "Project\\JOUR" ) == (int32)PROJ_LOG_OFFSET(20) );
+  CHECK ( writeStationName ( "JOUR", "RENAMED", 7 ) == 1 );
+  SDunmount ( );
+  for ( i = 0; i < 20; i++ )
+  {
+    ok &= ( readStation ( "JOUR", i, &st ) == 0 ) && ( st.density_count == 1000 + i );
+  }
+  CHECK ( ok );
+  getStationName ( "JOUR", name, 7 );
+  CHECK ( strcmp ( name, "RENAMED" ) == 0 );
+  // the depths of a sweep keep its sweep_id, the browse directory shows it
+  makeStation ( &st, 20 );
+  st.depth    = 8;
+  st.sweep_id = 21;
+  CHECK ( writeStation ( "JOUR", 20, &st ) && incrementStationNumber ( "JOUR" ) );
+  SDunmount ( );
+  CHECK ( ( readStation ( "JOUR", 20, &st ) == 0 ) && ( st.sweep_id == 21 ) && ( st.depth == 8 ) );
+  CHECK ( ( readStation ( "JOUR", 19, &st ) == 0 ) && ( st.sweep_id == 0 ) );
+  CHECK ( loadStationDir ( "JOUR", 20 )->entry[20].sweep_id == 21 );
+  SDunmount ( );
+}
+
+/* a power cut at every byte of a rename leaves station 3 either as it
+   was or renamed, and every other station whole */
+static void testTornRewrite ( void )
+{
+  station_data_t st;
+  ramdisk_stats_t rd;
+  uint32 total, cut;
+  uint16 i, old = 0, renamed = 0, lost = 0, others = 0;
+  proj_session_stats_t ps;
+
+  ramdiskReset ( );
+  makeProject ( "TORN", 10 );
+  ramdiskStats ( &rd, TRUE );
+  writeStationName ( "TORN", "NEW", 3 );
+  ramdiskStats ( &rd, TRUE );
+  total = rd.write_bytes;
+  CHECK ( total >= 2 * sizeof(proj_log_record_t) );
+
+  getProjSessionStats ( &ps, TRUE );
+  for ( cut = 0; cut <= total; cut++ )
+  {
+    ramdiskReset ( );
+    makeProject ( "TORN", 10 );
+    ramdiskCutAfter ( cut );
+    writeStationName ( "TORN", "NEW", 3 );
+    ramdiskPowerCycle ( );
+    SDunmount ( );
+    if ( getStationNumber ( "TORN" ) != 10 )
+    {
+      others++;
+      continue;
+    }
+    for ( i = 0; i < 10; i++ )
+    {
+      if ( readStation ( "TORN", i, &st ) != 0 )
+      {
+        if ( i == 3 )
+        {
+          lost++;
+        }
+        else
+        {
+          others++;
+        }
+        continue;
+      }
+      if ( i == 3 )
+      {
+        if ( strcmp ( st.name, "S3" ) == 0 )
+        {
+          old++;
+        }
+        else if ( strcmp ( st.name, "NEW" ) == 0 )
+        {
+          renamed++;
+        }
+        else
+        {
+          lost++;
+        }
+      }
+      else if ( st.density_count != 1000 + i )
+      {
+        others++;
+      }
+    }
+    SDunmount ( );
+  }
+  getProjSessionStats ( &ps, TRUE );
+  printf ( "  rename of one station, %u bytes written: %u cuts keep the old record, %u the new one\n",
+           total, old, renamed );
+  CHECK ( lost == 0 );
+  CHECK ( others == 0 );
+  CHECK ( old + renamed == total + 1 );
+  CHECK ( ( old > 0 ) && ( renamed > 0 ) );
+  CHECK ( ps.recovered > 0 );
+}
+
+/* a name too long for the catalog doesn't force a rebuild on each mount,
+   and a rebuild keeps the export marks of unchanged projects */
+static void testCatalog ( void )
+{
+  proj_session_stats_t ps;
+  proj_catalog_entry_t entry;
+  uint8 junk[8] = { 0 };
+  uint16 i;
+
+  ramdiskReset ( );
+  makeProject ( "ALPHA", 2 );
+  makeProject ( "BRAVO", 3 );
+  makeProject ( "CHARLIE", 1 );
+  catalogMarkExported ( "BRAVO" );
+  ramdiskPut ( "Project\\A_NAME_TOO_LONG_FOR_IT", junk, sizeof(junk) );
+  SDunmount ( );
+  getProjSessionStats ( &ps, TRUE );
+  for ( i = 0; i < 3; i++ )
+  {
+    CHECK ( catalogGetEntry ( 1, &entry ) == 0 );
+    SDunmount ( );
+  }
+  getProjSessionStats ( &ps, TRUE );
+  CHECK ( ps.catalog_rebuilds == 0 );
+
+  makeProject ( "DELTA", 1 );
+  catalogRemove ( "DELTA" );            // the catalog no longer matches the directory
+  SDunmount ( );
+  getProjSessionStats ( &ps, TRUE );
+  CHECK ( catalogGetEntry ( 2, &entry ) == 0 );
+  getProjSessionStats ( &ps, TRUE );
+  CHECK ( ps.catalog_rebuilds == 1 );
+  CHECK ( strcmp ( entry.name, "BRAVO" ) == 0 );
+  CHECK ( entry.flags & CATALOG_EXPORTED );
+  CHECK ( ( catalogGetEntry ( 1, &entry ) == 0 ) && !( entry.flags & CATALOG_EXPORTED ) );
+  CHECK ( ( catalogGetEntry ( 4, &entry ) == 0 ) && ( strcmp ( entry.name, "DELTA" ) == 0 ) );
+  CHECK ( ramdiskSize ( CATALOG_OLD_FILE ) < 0 );
+  SDunmount ( );
+}
+
+/* a card pulled while mounted is unmounted by the next start, and a
+   store the card refuses is reported and not counted */
+static void testCardLoss ( void )
+{
+  sd_mount_stats_t ms;
+  station_data_t st;
+
+  ramdiskReset ( );
+  makeProject ( "LOSS", 4 );
+  SDstart ( );
+  getSDmountStats ( &ms, TRUE );
+  ramdiskSetCard ( FALSE );
+  SD_Wake ( );
+  getSDmountStats ( &ms, TRUE );
+  CHECK ( ms.unmounts == 1 );
+  ramdiskSetCard ( TRUE );
+  SDstop ( null );
+  CHECK ( getStationNumber ( "LOSS" ) == 4 );
+
+  makeStation ( &st, 4 );
+  ramdiskCutAfter ( 0 );
+  CHECK ( writeStation ( "LOSS", 4, &st ) == 1 );    // held in the cache
+  CHECK ( incrementStationNumber ( "LOSS" ) == 0 );
+  CHECK ( getStationNumber ( "LOSS" ) == 4 );
+  ramdiskPowerCycle ( );
+  SDunmount ( );
+  CHECK ( writeStation ( "LOSS", 4, &st ) == 1 );
+  CHECK ( incrementStationNumber ( "LOSS" ) == 5 );
+  SDunmount ( );
+  CHECK ( getStationNumber ( "LOSS" ) == 5 );
+  SDunmount ( );
+}
+
+/* a held reference keeps the card mounted however long it sits idle, the
+   last stop starts the idle time, and a stop with no start is counted */
+static void testIdleRefs ( void )
+{
+  sd_mount_stats_t ms;
+
+  ramdiskReset ( );
+  SDunmount ( );
+  getSDmountStats ( &ms, TRUE );
+  SDstart ( );
+  SDstart ( );
+  msTimer += SD_IDLE_UNMOUNT_MS + 1;
+  SDidle ( );
+  CHECK ( sdOpened == ON );
+  SDstop ( null );
+  msTimer += SD_IDLE_UNMOUNT_MS + 1;
+  SDidle ( );
+  CHECK ( sdOpened == ON );
+  SDstop ( null );
+  SDidle ( );
+  CHECK ( sdOpened == ON );
+  msTimer += SD_IDLE_UNMOUNT_MS + 1;
+  SDidle ( );
+  CHECK ( sdOpened == OFF );
+  SDstop ( null );
+  getSDmountStats ( &ms, TRUE );
+  CHECK ( ms.mounts == 1 );
+  CHECK ( ms.unmounts == 1 );
+  CHECK ( ms.unpaired == 1 );
+}
+
+/* the reads USB_write_file makes: the count, the session handle and one
+   readStation per station. per_call closes the project after every
+   helper, which is what each helper did before the project session. */
+static void exportPass ( char * project, uint8 per_call, ramdisk_stats_t * rd )
+{
+  station_data_t st;
+  uint16 i, n;
+
+  SDunmount ( );
+  ramdiskStats ( rd, TRUE );
+  n = getStationNumber ( project );
+  if ( per_call )
+  {
+    projSessionClose ( );
+  }
+  projSessionGet ( project );
+  for ( i = 0; i < n; i++ )
+  {
+    if ( per_call )
+    {
+      projSessionClose ( );
+    }
+    readStation ( project, i, &st );
+  }
+  SDunmount ( );
+  ramdiskStats ( rd, TRUE );
+}
+
+static void testExportOpens ( void )
+{
+  ramdisk_stats_t rd;
+
+  ramdiskReset ( );
+  makeProject ( "EXPORT", 100 );
+  exportPass ( "EXPORT", FALSE, &rd );
+  CHECK ( rd.opens == 1 );
+  CHECK ( rd.reads <= 1 + 100 * sizeof(proj_log_record_t) / SD_CACHE_SECTOR + 5 );  // the sectors once, plus the mount checks
+}
+
+static void bench ( void )
+{
+  ramdisk_stats_t before, after;
+
+  ramdiskReset ( );
+  makeProject ( "EXPORT", 100 );
+  exportPass ( "EXPORT", TRUE, &before );
+  exportPass ( "EXPORT", FALSE, &after );
+  printf ( "100 station export, card calls per pass:  opens  reads  bytes read  seeks\n" );
+  printf ( "  open per helper call                  %6u %6u %11u %6u\n", before.opens, before.reads,
+           before.read_bytes, before.seeks );
+  printf ( "  project session                       %6u %6u %11u %6u\n", after.opens, after.reads,
+           after.read_bytes, after.seeks );
+}
+
+int main ( int argc, char ** argv )
+{
+  if ( ( argc > 1 ) && ( strcmp ( argv[1], "bench" ) == 0 ) )
+  {
+    bench ( );
+    return 0;
+  }
+  testCacheHole ( );
+  testCacheGathers ( );
+  testStopFlushes ( );
+  testJournal ( );
+  testTornRewrite ( );
+  testCatalog ( );
+  testExportOpens ( );
+  testCardLoss ( );
+  testIdleRefs ( );
+  return hostTestEnd ( "test_sd_store" );
+}
@@ -0,0 +1,201 @@
+/* ========================================
+ *
+ * Monte-Carlo harness for the early stop of the stat and drift tests in
+ * Tests.c. Synthetic gauges with a known count scatter or drift are run
+ * through statSequentialStop and driftSequentialStop, count by count as
+ * stat_test and drift_test do, and the pass/fail outcome is compared with
+ * the full 20 or 5 count series on the same counts.
+ *
+ * ========================================
+*/
+#include <string.h>
+#include "Globals.h"
+#include "Tests.h"
+#include "psoc_sim.h"
+#include "host_test.h"
+
+#define STAT_COUNTS     20              // as in Tests.c
+#define DRIFT_COUNTS    5
+#define DRIFT_D_LIMIT   0.5
+#define DRIFT_M_LIMIT   1.0
+#define D_MEAN          2500.0          // counts per 3.75s, typical for the stat block
+#define M_MEAN          600.0
+#define TRIALS          20000
+
+typedef struct
+{
+  double fail;                          // fraction of trials with a fail outcome
+  double early;                         // fraction stopped before the full series
+  double counts;                        // mean counts taken
+} seq_rates_t;
+
+static uint32 drawCount ( double mean, double sd )
+{
+  return (uint32)floor ( mean + sd * simNormal ( ) + 0.5 );
+}
+
+static BOOL statRatiosOk ( const run_stats_t * d, const run_stats_t * m )
+{
+  double dr = runStatsSD ( d ) / sqrt ( d->mean ), mr = runStatsSD ( m ) / sqrt ( m->mean );
+  return ( dr >= RATIO_LOWER ) && ( dr <= RATIO_UPPER ) && ( mr >= RATIO_LOWER ) && ( mr <= RATIO_UPPER );
+}
+
+/* stat test of a gauge whose count SD is ratio * sqrt(mean) on both tubes */
+static void statTrials ( double d_ratio, double m_ratio, seq_rates_t * seq, seq_rates_t * full )
+{
+  uint32 d[STAT_COUNTS], m[STAT_COUNTS], t;
+  run_stats_t ds, ms;
+  uint8 i, n;
+
+  memset ( seq, 0, sizeof(*seq) );
+  memset ( full, 0, sizeof(*full) );
+  for ( t = 0; t < TRIALS; t++ )
+  {
+    for ( i = 0; i < STAT_COUNTS; i++ )
+    {
+      d[i] = drawCount ( D_MEAN, d_ratio * sqrt ( D_MEAN ) );
+      m[i] = drawCount ( M_MEAN, m_ratio * sqrt ( M_MEAN ) );
+    }
+    runStatsReset ( &ds );
+    runStatsReset ( &ms );
+    for ( n = 0; n < STAT_COUNTS; )
+    {
+      runStatsAdd ( &ds, d[n] );
+      runStatsAdd ( &ms, m[n] );
+      n++;
+      if ( statSequentialStop ( &ds, &ms ) != SEQ_CONTINUE )
+      {
+        break;
+      }
+    }
+    seq->fail   += !statRatiosOk ( &ds, &ms );
+    seq->early  += ( n < STAT_COUNTS );
+    seq->counts += n;
+    for ( ; n < STAT_COUNTS; n++ )
+    {
+      runStatsAdd ( &ds, d[n] );
+      runStatsAdd ( &ms, m[n] );
+    }
+    full->fail   += !statRatiosOk ( &ds, &ms );
+    full->counts += STAT_COUNTS;
+  }
+  seq->fail  /= TRIALS;  seq->early  /= TRIALS;  seq->counts  /= TRIALS;
+  full->fail /= TRIALS;  full->counts /= TRIALS;
+}
+
+static double driftPercent ( uint32 stat_avg, const run_stats_t * s )
+{
+  double avg = (uint32)( s->mean + 0.5 );  // drift_test averages in integers
+  return 100.0 * fabs ( stat_avg - avg ) / ( ( stat_avg + avg ) / 2.0 );
+}
+
+/* drift test of a gauge whose counts moved by d_drift and m_drift % since
+   its stat test */
+static void driftTrials ( double d_drift, double m_drift, seq_rates_t * seq, seq_rates_t * full )
+{
+  uint32 d[DRIFT_COUNTS], m[DRIFT_COUNTS], d_stat, m_stat, t;
+  run_stats_t ds, ms;
+  uint8 i, n;
+
+  memset ( seq, 0, sizeof(*seq) );
+  memset ( full, 0, sizeof(*full) );
+  for ( t = 0; t < TRIALS; t++ )
+  {
+    d_stat = drawCount ( D_MEAN, sqrt ( D_MEAN / 16 / STAT_COUNTS ) );  // 20 counts of 60s / 16
+    m_stat = drawCount ( M_MEAN, sqrt ( M_MEAN / 16 / STAT_COUNTS ) );
+    for ( i = 0; i < DRIFT_COUNTS; i++ )
+    {
+      d[i] = drawCount ( D_MEAN * ( 1 + d_drift / 100 ), sqrt ( D_MEAN / 64 ) );  // 240s / 64
+      m[i] = drawCount ( M_MEAN * ( 1 + m_drift / 100 ), sqrt ( M_MEAN / 64 ) );
+    }
+    runStatsReset ( &ds );
+    runStatsReset ( &ms );
+    for ( n = 0; n < DRIFT_COUNTS; )
+    {
+      runStatsAdd ( &ds, d[n] );
+      runStatsAdd ( &ms, m[n] );
+      n++;
+      if ( driftSequentialStop ( &ds, &ms, d_stat, m_stat ) != SEQ_CONTINUE )
+      {
+        break;
+      }
+    }
+    seq->fail   += ( driftPercent ( d_stat, &ds ) > DRIFT_D_LIMIT ) || ( driftPercent ( m_stat, &ms ) > DRIFT_M_LIMIT );
+    seq->early  += ( n < DRIFT_COUNTS );
+    seq->counts += n;
+    for ( ; n < DRIFT_COUNTS; n++ )
+    {
+      runStatsAdd ( &ds, d[n] );
+      runStatsAdd ( &ms, m[n] );
+    }
+    full->fail   += ( driftPercent ( d_stat, &ds ) > DRIFT_D_LIMIT ) || ( driftPercent ( m_stat, &ms ) > DRIFT_M_LIMIT );
+    full->counts += DRIFT_COUNTS;
+  }
+  seq->fail  /= TRIALS;  seq->early  /= TRIALS;  seq->counts  /= TRIALS;
+  full->fail /= TRIALS;  full->counts /= TRIALS;
+}
+
+static void report ( const char * test, const char * gauge, BOOL good, const seq_rates_t * seq, const seq_rates_t * full )
+{
+  printf ( "  %-5s %-24s %s %5.1f%% sequential %5.1f%% full, %4.1f%% early, %4.1f counts\n", test, gauge,
+           good ? "false fail" : "false pass", 100 * ( good ? seq->fail : 1 - seq->fail ),
+           100 * ( good ? full->fail : 1 - full->fail ), 100 * seq->early, seq->counts );
+}
+
+/* early stops may not turn noticeably more good gauges into failures, or
+   bad gauges into passes, than the full series does */
+static void testStat ( void )
+{
+  seq_rates_t seq, full;
+
+  simSeed ( 1 );
+  statTrials ( 0.25, 0.25, &seq, &full );
+  report ( "stat", "Poisson (ratio 0.25)", TRUE, &seq, &full );
+  CHECK ( seq.fail <= full.fail + 0.01 );
+  CHECK ( seq.counts < STAT_COUNTS );
+
+  statTrials ( 0.45, 0.25, &seq, &full );
+  report ( "stat", "density ratio 0.45", FALSE, &seq, &full );
+  CHECK ( 1 - seq.fail <= ( 1 - full.fail ) + 0.01 );
+  CHECK ( seq.counts < STAT_COUNTS );
+
+  statTrials ( 0.25, 0.10, &seq, &full );
+  report ( "stat", "moisture ratio 0.10", FALSE, &seq, &full );
+  CHECK ( 1 - seq.fail <= ( 1 - full.fail ) + 0.01 );
+
+  statTrials ( 0.38, 0.25, &seq, &full );
+  report ( "stat", "density ratio 0.38", FALSE, &seq, &full );
+  CHECK ( 1 - seq.fail <= ( 1 - full.fail ) + 0.05 );
+}
+
+static void testDrift ( void )
+{
+  seq_rates_t seq, full;
+
+  simSeed ( 2 );
+  driftTrials ( 0, 0, &seq, &full );
+  report ( "drift", "no drift", TRUE, &seq, &full );
+  CHECK ( seq.fail <= full.fail + 0.01 );
+
+  driftTrials ( 1.5, 0, &seq, &full );
+  report ( "drift", "density +1.5%", FALSE, &seq, &full );
+  CHECK ( 1 - seq.fail <= ( 1 - full.fail ) + 0.01 );
+  CHECK ( seq.counts < DRIFT_COUNTS );
+
+  driftTrials ( 0, -3.0, &seq, &full );
+  report ( "drift", "moisture -3%", FALSE, &seq, &full );
+  CHECK ( 1 - seq.fail <= ( 1 - full.fail ) + 0.01 );
+  CHECK ( seq.counts < DRIFT_COUNTS );
+
+  driftTrials ( 0.8, 0, &seq, &full );
+  report ( "drift", "density +0.8%", FALSE, &seq, &full );
+  CHECK ( 1 - seq.fail <= ( 1 - full.fail ) + 0.05 );
+}
+
+int main ( void )
+{
+  printf ( "%u trials each:\n", TRIALS );
+  testStat ( );
+  testDrift ( );
+  return hostTestEnd ( "test_seq_tests" );
+}
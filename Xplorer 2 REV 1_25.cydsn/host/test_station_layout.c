@@ -0,0 +1,24 @@
+/* ========================================
+ *
+ * Host check that the station layout of fixed project files and BLE
+ * packets stays the one shipped in REV 1.25 firmware
+ *
+ * ========================================
+*/
+#include "Globals.h"
+#include "ProjectData.h"
+#include "host_test.h"
+
+int main ( void )
+{
+  CHECK ( sizeof(GPSDATA) == 13 );
+  CHECK ( offsetof(station_data_t,gps_read) == 80 );
+  CHECK ( STATION_FIXED_SIZE == 101 );
+  CHECK ( offsetof(project_data_t,station_number) == 3 );
+  CHECK ( offsetof(project_data_t,station[0]) == 5 );
+  CHECK ( offsetof(project_data_t,station[1]) == 5 + 101 );
+  CHECK ( sizeof(project_data_t) == 5 + 101 * MAX_STATIONS );
+  CHECK ( offsetof(proj_log_record_t,station) == 4 );
+  CHECK ( sizeof(proj_log_record_t) == 4 + sizeof(station_data_t) + 2 );
+  return hostTestEnd ( "test_station_layout" );
+}
@@ -154,7 +154,7 @@ typedef struct eepromData_s
   uint16_t     dr_moist_avg       ;         // 2 BYTES  
   uint32_t     dr_dense_per       ;         // 4 BYTES
   uint32_t     dr_moist_per       ;         // 4 BYTES
-  uint16_t     st_pass_fail       ;         // 1 BYTES set if first stat test of self diag test fails
+  uint16_t     st_pass_fail       ;         // 2 BYTES low byte set if the last stat test failed, high byte the 60s counts it took
   uint32_t     d_temp             ;         // 4 BYTES gauge temp before drift test
   uint32_t     d_volts            ;         // 4 BYTES high voltage 
   date_time_t  diag_test_date     ;         // 4 BYTES time/date stamp
@@ -173,7 +173,13 @@ typedef struct eepromData_s
   uint32_t     SERIAL_NUM_HI      ;         // If serial number is greater thant 65535
   uint32_t      GaugeType;                  // which gauge is it?
   uint8_t      SHUT_DOWN_TIME_HOURS  ;
-  uint8        temp_2[35]         ;         // future use - make all changes here
+  uint16_t     COUNT_RSE          ;         // 2 bytes target relative std. error for adaptive counts, 0.01% units
+  uint8        DT_MODEL           ;         // 1 byte  dead time correction, 0 off, 1 non-paralyzable, 2 paralyzable
+  float        DT_TAU_GM          ;         // 4 bytes GM tube dead time in us
+  float        DT_TAU_HE3         ;         // 4 bytes He3 tube dead time in us
+  uint8        dr_counts_used     ;         // 1 byte  240s counts the last drift test needed
+  uint8        GPS_MAX_AGE        ;         // 1 byte  oldest GPS fix a reading takes, seconds
+  uint8        temp_2[22]         ;         // future use - make all changes here
 
  } EEPROM_DATA_t; ;
 
@@ -56,7 +56,7 @@ typedef signed long         INT32;             // other name for signed 32-bit i
 
 typedef long double         DOUBLE_FLOAT;       // this is double 64 bit floating point 
 
-typedef unsigned long       uint32_t;           // other name for unsigned 32-bit integer
+#include <stdint.h>                             // uint32_t, unsigned long on the target's newlib
 typedef float               fp32_t;
 typedef long double         fp64_t;
 //typedef unsigned int        uint16_t;
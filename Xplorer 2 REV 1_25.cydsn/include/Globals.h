@@ -47,8 +47,8 @@
 
 #define DEL_SIG 1
    
-#define MAX_PROJECTS    10
-#define MAX_STATIONS    100
+#define MAX_PROJECTS    500     // catalog capacity
+#define MAX_STATIONS    100     // fixed layout projects, journals grow
 #define PROJ_NAME_LENGTH 15  
 
 #define PASS  1
@@ -79,6 +79,7 @@
 
 #define     MANUAL 0                   // definitions for shutdown mode
 #define     AUTO 1
+#define     SHUT_DOWN_WAIT_MS 3000     // longest a power off waits for the main context to unmount the SD card
 #define     NICAD 0                    // definitions for battery selection    
 #define     ALK   1
 #define     ACCESS_CODE     4659       //num to access entering cal values
@@ -213,9 +214,9 @@ extern struct features_struct
   uint16_t chi_sq_mode           : 1; // 10 0: Chi squared test enabled, 1 chi test disabled
   uint16_t gps_on                : 1; // 11 0: GPS disabled, 1 GPS enabled
   uint16_t soil_air_voids_on     : 1; // 12 0: Soil Air Voids Disabled, 1 Enabled
-  uint16_t temp_13               : 1; // 13 
-  uint16_t temp_14               : 1; // 14
-  uint16_t temp_15               : 1; // 15
+  uint16_t adaptive_count        : 1; // 13 0: fixed count time, 1: stop when the COUNT_RSE precision is reached
+  uint16_t std_early_accept      : 1; // 14 0: full 240s standard, 1: accept the standard once it is settled
+  uint16_t auto_start            : 1; // 15 0: START key only, 1: count starts when the rod is placed (needs auto_depth)
 } Features;
 
 extern union 
@@ -299,6 +300,10 @@ typedef struct
    uint8  fix;
 } GPSDATA;
 
+#define GPS_MAX_AGE_DEFAULT   5         // s, oldest fix a reading takes when GPS_MAX_AGE is not set
+#define GPS_MAX_AGE_LIMIT     60
+#define GPS_AGE_NONE          0xFFFF    // station gps_age when no fix was taken
+
 extern uint8_t usb_start;
 extern uint8_t global_special_key_flag;
 extern volatile uint32 msTimer;
@@ -392,6 +397,8 @@ extern void wait_for_serial(void);
 extern void general_purpose_test(void);
 extern void stand_test(void);
 extern void set_count_time(void);
+extern void set_precision_mode(void);
+extern void gps_settings(void);
 extern void set_depth_manual(void);
 extern void recall(void);
 extern void special_cal(void);
@@ -404,6 +411,10 @@ extern void monitor_batt(void);
 extern void memory_reset(void);
 extern void auto_initialization(void);
 extern void shut_down_text(void);
+extern void auto_shut_down(void);
+extern void requestShutDown(uint8 mode);
+extern void serviceShutDown(void);
+extern void checkShutDownWait(void);
 extern void nomograph(void);
 extern Bool check_temp(Bool display);
 extern Bool check_high_voltage(Bool display);
@@ -463,10 +474,12 @@ extern void  scan_keys ( void );
 extern uint8 checkCountDone ( void );
 extern void clearGPSData ( );
 extern void parseGPSString();
+extern uint8 gpsGetSnapshot ( GPSDATA * fix, uint32 * age_ms );
 extern void FirmwareMenu ( );
 extern void soilvoids_menu () ;
 extern void initDepthVoltages (void);
 extern void  convertRTCtoAlfatTime ( date_time_t date );
 void idle_shutdown(void) ;
+void dead_time_settings(void) ;
 
 #endif /* endif !GLOBALS_H for "if we haven't included this file already..."    */
@@ -25,6 +25,76 @@
 #ifndef MEASUREMENT_H
 #define MEASUREMENT_H
 
+#include "Globals.h"
+#include "ProjectData.h"
+
+/* Density terms of one cal depth, worked out from A, B and C whenever
+   they change so a reading needs a single logf. Cal consts in GCC. */
+typedef struct
+{
+  float     lnA;            // ln ( A )
+  float     invB;           // 1 / B
+  float     C;
+} cal_terms_t;
+
+/* Constants a reading at one depth needs, cal consts in GCC */
+typedef struct
+{
+  float     lnA, invB, Cd;  // density terms, see cal_terms_t
+  float     E, invF;        // moisture constants, 1 / F
+  uint16_t  d_stand;        // density standard count
+  uint16_t  m_stand;        // moisture standard count
+} meas_consts_t;
+
+/* Results of one density/moisture calculation, densities in KG/M3 */
+typedef struct
+{
+  float cr;                 // density count ratio
+  float mcr;                // moisture count ratio
+  float density;            // wet density incl. density offset
+  float moisture;
+  float dry_dens;
+  float moist_percent;
+  float pr_percent;
+} meas_result_t;
+
+/* Offsets and targets a calculation applies, densities in KG/M3 */
+typedef struct
+{
+  uint8_t   mask;           // DENSITY_, MOISTURE_ and TRENCH_OFFSET_BIT in use
+  float     d_offset;       // density offset
+  float     k_value;        // moisture offset
+  float     t_offset;       // trench offset, moisture counts
+  float     proctor;
+  float     marshall;
+} meas_offsets_t;
+
+/* Post count phase of the last measurement, ms after the count ended */
+typedef struct
+{
+  uint32_t result_ms;       // result screen up
+  uint32_t nv_ms;           // time spent on the EEPROM writes
+  uint32_t store_ms;        // time spent storing the station to the project
+  uint32_t ble_ms;          // time spent sending both BLE messages
+  uint32_t done_ms;         // all queued jobs finished
+} post_timing_t;
+
+extern post_timing_t post_timing;
+
+const cal_terms_t * getCalTerms ( uint8_t depth );
+float   calDensityGcc ( const meas_consts_t * k, float cr );
+float   calSpecialB ( uint8_t depth, float cr, float density_gcc );
+uint8_t loadMeasConsts ( uint8_t depth, meas_consts_t * k );
+void    calcMoistureDensity ( uint32_t density_cnt, uint16_t moisture_cnt, const meas_consts_t * k, meas_result_t * r );
+void    getActiveOffsets ( meas_offsets_t * o );
+void    calcWithOffsets ( uint32_t density_cnt, uint16_t moisture_cnt, const meas_consts_t * k, const meas_offsets_t * o, meas_result_t * r );
+uint8_t recomputeStation ( station_data_t * station_d );
+void    setStationOffsets ( station_data_t * station_d );
+uint8_t measureRolling ( void );
+uint8_t measureSweep ( void );
+uint8_t checkAutoStart ( uint8_t depth );
+void    postCountTimingReport ( void );
+
 
 #endif
 
@@ -0,0 +1,70 @@
+/******************************************************************************
+ *                                                                            
+ *  InstroTek, Inc. 2010                  
+ *  5908 Triangle Dr.
+ *  Raleigh,NC 27617
+ *  www.instrotek.com  (919) 875-8371                                         
+ *                                                                               
+ *           File Name:  Profiler.h
+ *  Originating Author:  
+ *       Creation Date:  
+ *
+ ******************************************************************************/ 
+ 
+ /*--------------------------------------------------------------------------*/
+/*---------------------------[  Revision History  ]--------------------------*/
+/*---------------------------------------------------------------------------*/
+/*
+ *  when?       who?    what?
+ *  ----------- ------- ------------------------------------------------------
+ *  
+ *
+ *---------------------------------------------------------------------------*/
+
+/*  If we haven't included this file already.... */
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "Globals.h"
+
+#define PROF_RING_DEPTH   64            // readings kept in the SD ring file
+#define PROF_FILE         "\\PROFILE.BIN"
+
+/* Phases of a reading, timed with msTimer */
+typedef enum
+{
+  PROF_DEPTH = 0,                       // depth detect / manual depth entry
+  PROF_PROJECT,                         // project checks and station name
+  PROF_RTC,
+  PROF_COUNT,
+  PROF_CALC,
+  PROF_GPS,
+  PROF_EEPROM,
+  PROF_SD,                              // station written to the project
+  PROF_BLE,
+  PROF_DISPLAY,                         // first result screen
+  PROF_PHASES
+} prof_phase_t;
+
+/* One reading in the ring file */
+typedef struct
+{
+  date_time_t date;                     // when the reading was started
+  uint8       depth;
+  uint32      ms[PROF_PHASES];          // time spent in each phase
+  uint32      total_ms;                 // start of the reading to profCommit
+} prof_record_t;
+
+extern const char * const prof_phase_names[PROF_PHASES];
+
+void   profStart ( void );
+void   profBegin ( prof_phase_t phase );
+void   profEnd ( prof_phase_t phase );
+void   profAdd ( prof_phase_t phase, uint32 ms );
+void   profSetInfo ( date_time_t date, uint8 depth );
+uint8  profCommit ( void );
+uint16 profRead ( uint16 age, prof_record_t * rec );
+void   profViewLog ( void );
+void   profExportToUSB ( void );
+
+#endif
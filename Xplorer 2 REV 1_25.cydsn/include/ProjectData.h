@@ -17,6 +17,34 @@
 
   
 #define PROJECT_NOT_VALID 0  
+#define PROJ_SESSION_IDLE_MS  30000     // an unused project session is closed after this
+#define PROJ_SESSIONS         2         // projects kept open at once
+
+#define PROJ_FORMAT_FIXED     1         // project_data_t, stations at fixed offsets
+#define PROJ_FORMAT_LOG       2         // header then appended station records
+#define PROJ_LOG_MAGIC        0x474C5058  // "XPLG"
+#define PROJ_LOG_VERSION      4         // 2: records carry the station fields past STATION_FIXED_SIZE, 3: rewrite slot, 4: sweep_id
+#define PROJ_LOG_REC_TAG      0x5352    // "RS"
+#define PROJ_LOG_MAX_STATIONS 65000     // record index is 16 bit, otherwise bounded by the card
+#define PROJ_LOG_SLOT_OFFSET  sizeof(proj_log_header_t)  // record being rewritten, tag 0 when none
+#define PROJ_LOG_OFFSET(i)    ( sizeof(proj_log_header_t) + ( (uint32_t)( i ) + 1 ) * sizeof(proj_log_record_t) )
+#define PROJ_FIELD_AUTO       0         // project wide fields, see projFieldOffset
+#define PROJ_FIELD_AUTO_START 1
+#define STATION_DIR_ENTRIES   100       // stations held by the browse directory
+#define PROJ_DELETE_ALL       0         // deleteProjectsBy policies
+#define PROJ_DELETE_OLDER     1
+#define PROJ_DELETE_EXPORTED  2
+
+#define CATALOG_NAME          "CATALOG.IDX"
+#define CATALOG_FILE          "\\Project\\" CATALOG_NAME
+#define CATALOG_OLD_NAME      "CATALOG.OLD"  // the catalog being replaced by a rebuild
+#define CATALOG_OLD_FILE      "\\Project\\" CATALOG_OLD_NAME
+#define CATALOG_MAGIC         0x54435058  // "XPCT"
+#define CATALOG_VERSION       2
+#define CATALOG_MOVE_ENTRIES  8         // entries moved per read/write when inserting
+#define CATALOG_EXPORTED      0x01      // entry flags
+#define CATALOG_DELETED       0x02      // only set while deleteProjectsBy runs
+#define CATALOG_OFFSET(i)     ( sizeof(proj_catalog_header_t) + (uint32_t)( i ) * sizeof(proj_catalog_entry_t) )
   
 ////////////////////////Memory locations for project storage////////////////////
 #pragma pack(1)  
@@ -44,8 +72,16 @@ typedef struct station_data_s
   float      bottom_den     ;     //                                          4 bytes 61
   GPSDATA    gps_read       ;     //                                         19 bytes 65
   float      battery_voltage[2];
+  // fixed files and BLE stop here, see STATION_FIXED_SIZE; only journal records hold the rest
+  float      count_time     ;     // actual count time in seconds             4 bytes
+  float      count_rse      ;     // achieved relative std. error in %        4 bytes
+  uint16_t   gps_age        ;     // age of gps_read in 0.1s, GPS_AGE_NONE    2 bytes
+  uint8_t    count_quality  ;     // PQ_xxx flags, GM low nibble, He3 high    1 byte
+  uint16_t   sweep_id       ;     // sweep of its depth, 0 none, measureSweep  2 bytes
 } station_data_t;                                                      
 
+#define STATION_FIXED_SIZE    offsetof(station_data_t,count_time)  // station layout shipped in fixed files and BLE packets
+
 
 #pragma pack(1)  
 typedef struct 
@@ -53,10 +89,60 @@ typedef struct
   uint16_t    station_auto_start     ;     // if auto numbering, start here
   uint8_t     station_auto           ;     // auto number enabled 
   uint16_t    station_number         ;     // total number of stations within project, will also tell station index
-  station_data_t  station[MAX_STATIONS] ;    // station data
+  uint8_t     station[MAX_STATIONS][STATION_FIXED_SIZE] ;    // station data, the leading STATION_FIXED_SIZE bytes of station_data_t
 } project_data_t;
 
 
+/* Journal project: this header, the rewrite slot, then one record per
+   station in index order. A record is only counted once it is whole and its
+   CRC checks. A record is rewritten through the slot, so a power cut in the
+   middle of it is finished on the next mount. */
+#pragma pack(1)  
+typedef struct 
+{
+  uint32_t    magic                  ;     // PROJ_LOG_MAGIC
+  uint16_t    version                ;     // PROJ_LOG_VERSION
+  uint16_t    header_size            ;     // sizeof(proj_log_header_t)
+  uint16_t    record_size            ;     // sizeof(proj_log_record_t)
+  uint16_t    station_auto_start     ;     // if auto numbering, start here
+  uint8_t     station_auto           ;     // auto number enabled 
+  uint8_t     reserved[5]            ;
+} proj_log_header_t;
+
+
+#pragma pack(1)  
+typedef struct 
+{
+  uint16_t        tag                ;     // PROJ_LOG_REC_TAG
+  uint16_t        index              ;     // station index
+  station_data_t  station            ;
+  uint16_t        crc                ;     // CRC-16/CCITT of everything above
+} proj_log_record_t;
+
+
+/* Project catalog: this header, then one entry per project in name order */
+#pragma pack(1)  
+typedef struct 
+{
+  uint32_t    magic                  ;     // CATALOG_MAGIC
+  uint16_t    version                ;     // CATALOG_VERSION
+  uint16_t    entry_size             ;     // sizeof(proj_catalog_entry_t)
+  uint16_t    count                  ;     // number of entries
+} proj_catalog_header_t;
+
+
+#pragma pack(1)  
+typedef struct 
+{
+  char        name[PROJ_NAME_LENGTH] ;     // project file name
+  uint16_t    stations               ;     // stations stored
+  uint32_t    modified               ;     // FAT time stamp of the last write
+  uint32_t    size                   ;     // file size in bytes
+  date_time_t last_date              ;     // date of the last station, zero if empty
+  uint8_t     flags                  ;     // CATALOG_xxx
+} proj_catalog_entry_t;
+
+
 /*---------------------------------------------------------------------------*/
 /*----------------------[  Global Function Prototypes  ]---------------------*/
 /*---------------------------------------------------------------------------*/
@@ -72,7 +158,7 @@ void      setStationAutoNumber ( char* project, char flag );
 uint16    resetProjectStorage ( void );
 int32     readStation (char* project, uint16_t index_station, station_data_t * station   );
 uint16_t  incrementStationNumber ( char* project   );
-void      writeStation ( char* project, uint16_t index_station, station_data_t * station_n );
+uint8     writeStation ( char* project, uint16_t index_station, station_data_t * station_n );
 
 uint16_t  clearProject  ( char * project_name  );
 void      setActiveProjectEE ( char * proj );
@@ -81,6 +167,51 @@ int32     getStationName (  char* project, char * name, uint16_t index_station )
 void      writeAutoStationStart ( char* project,  uint16_t auto_start_num );
 uint16    getAutoStationStart ( char* project  );
 
+/* project session, one open handle shared by the helpers above */
+typedef struct
+{
+  uint16_t  opens;                      // FAT opens of a project file
+  uint16_t  reuses;                     // helper calls served by the open handle
+  uint16_t  recovered;                  // journals cut back to their last whole record
+  uint16_t  catalog_rebuilds;           // catalogs written again from a directory scan
+} proj_session_stats_t;
+
+/* station directory, a window of one project kept in RAM for browsing */
+typedef struct
+{
+  char        name[PROJ_NAME_LENGTH];
+  uint16_t    depth;
+  uint16_t    sweep_id;
+  date_time_t date;
+} station_dir_entry_t;
+
+typedef struct
+{
+  char        project[PROJ_NAME_LENGTH];
+  uint16_t    total;                    // stations in the project
+  uint16_t    first;                    // station held in entry[0]
+  uint16_t    count;                    // entries loaded
+  uint8_t     valid;
+  station_dir_entry_t entry[STATION_DIR_ENTRIES];
+} station_dir_t;
+
+FS_FILE * projSessionGet ( char* project );
+void      projSessionClose ( void );
+void      projSessionIdle ( void );
+void      getProjSessionStats ( proj_session_stats_t * stats, uint8 reset );
+uint8     getProjectFormat ( char* project );
+int32     projLogInit ( FS_FILE * file );
+const station_dir_t * loadStationDir ( char* project, uint16_t first );
+uint8     projectHasRoom ( char* project );
+void      stationDirInvalidate ( void );
+int32     catalogGetEntry ( uint16_t index, proj_catalog_entry_t * entry );
+int32     catalogGetName ( uint16_t index, char * project );
+int32     catalogUpdate ( char * project );
+void      catalogRemove ( char * project );
+void      catalogClose ( void );
+void      catalogMarkExported ( char * project );
+uint16_t  deleteProjectsBy ( uint8 policy, uint16 days );
+
 #endif 
 
 /* [] END OF FILE */
@@ -0,0 +1,106 @@
+/******************************************************************************
+ *
+ *  InstroTek, Inc. 2010
+ *  5908 Triangle Dr.
+ *  Raleigh,NC 27617
+ *  www.instrotek.com  (919) 875-8371
+ *
+ *           File Name:  PulseCounter.h
+ *  Originating Author:
+ *       Creation Date:
+ *
+ ******************************************************************************/
+
+ /*--------------------------------------------------------------------------*/
+/*---------------------------[  Revision History  ]--------------------------*/
+/*---------------------------------------------------------------------------*/
+/*
+ *  when?       who?    what?
+ *  ----------- ------- ------------------------------------------------------
+ *
+ *
+ *---------------------------------------------------------------------------*/
+
+/*  If we haven't included this file already.... */
+#ifndef PULSECOUNTER_H
+#define PULSECOUNTER_H
+
+#include "Globals.h"
+
+#define PULSE_COUNTER_RELOAD   200      // Counter_GM / Counter_HE3 reload value
+#define PULSE_COUNTER_RELOAD_WIDE  50000  // reload used when the counters are 16 bit or wider
+#define PULSE_BIN_MS_DEFAULT   250      // default sub-interval length
+#define PULSE_BIN_DEPTH        128      // ring buffer length, 32s of 250ms bins
+
+#define DEAD_TIME_OFF          0        // DT_MODEL values
+#define DEAD_TIME_NON_PARALYZABLE  1
+#define DEAD_TIME_PARALYZABLE  2
+#define DEAD_TIME_MAX_US       1000.0   // larger taus are treated as not set
+
+/* One sub-interval of a count. The last bin of a count may be shorter
+   than the programmed bin length, so the length is kept with the counts. */
+typedef struct
+{
+  uint32 gm;                            // density tube counts in this bin
+  uint32 he3;                           // moisture tube counts in this bin
+  uint16 ms;                            // length of this bin in ms
+} pulse_bin_t;
+
+void   initPulseCntStrt ( void );
+void   PulseCntStrt ( float timeSec );
+void   stop_ONE_SHOT_Early ( void );
+void   resetPulseTimers ( void );
+uint8  checkCountDone ( void );
+uint32 getGMPulseCounts ( void );
+uint32 getHEPulseCounts ( void );
+
+void   setPulseBinCapture ( uint16 bin_ms );
+void   pulseBinTick ( void );
+uint16 getPulseBinTotal ( void );
+uint32 getPulseBinEdge ( uint32 * gm, uint32 * he3 );
+uint16 readPulseBins ( pulse_bin_t * bins, uint16 max_bins );
+uint16 readNewPulseBins ( uint16 * seen, pulse_bin_t * bins, uint16 max_bins );
+
+/* Reload interrupt bookkeeping for the last count. The wraps of the tube
+   counters are counted in hardware by Counter_GM_WRAP / Counter_HE3_WRAP,
+   which masking the interrupts cannot stop, so a reload lost while the
+   interrupts were masked shows up as expected > serviced. Every ms tick
+   of the count is timed against SysTick and the one shot, so the longest
+   the interrupts were held off is known in us whatever the count rate. */
+typedef struct
+{
+  uint32 serviced[2];                   // reload ISRs run, GM and He3
+  uint32 expected[2];                   // counter wraps counted in hardware
+  uint32 counts[2];                     // counts so far
+  uint32 worst_us;                      // longest the ms tick was held off
+  uint32 ms;                            // count time the figures cover
+  uint16 reload;                        // counts per reload interrupt
+} pulse_isr_stats_t;
+
+#define PULSE_LATE_DIVISOR     2        // a masked section worth reload / 2 counts is too close to losing one
+
+uint8  setPulseReload ( uint16 reload );
+uint16 getPulseReload ( void );
+void   getPulseIsrStats ( pulse_isr_stats_t * stats );
+uint32 getPulseIsrRate ( const pulse_isr_stats_t * stats, uint8 tube );
+uint32 getMissedReloads ( const pulse_isr_stats_t * stats, uint8 tube );
+uint32 getWorstIsrLatencyUs ( const pulse_isr_stats_t * stats );
+uint8  checkPulseIntegrity ( const pulse_isr_stats_t * stats, uint8 tube );
+
+uint32 deadTimeCorrect ( uint32 counts, uint32 ms, uint8 tube );
+float  deadTimeTrueRate ( float rate, float tau_s, uint8 model );
+
+/* Count quality, checked bin by bin while a count runs. The GM flags sit
+   in the low nibble, the He3 flags in the high nibble. */
+#define PQ_DROPOUT             0x01     // bin far below the running rate, tube or HV dropped out
+#define PQ_BURST               0x02     // bin far above the running rate, noise
+#define PQ_NONLINEAR           0x04     // rate in the dead time or counter limited region
+#define PQ_RELOAD              0x08     // reload ISR missed or served too late, counts not trusted
+#define PQ_TUBE_SHIFT(tube)    ( ( tube ) == PROBE_GM_COUNT ? 0 : 4 )
+#define PQ_FLAGS(q, tube)      ( ( ( q ) >> PQ_TUBE_SHIFT(tube) ) & 0x0F )
+
+void   pulseQualityUpdate ( void );
+uint8  getPulseQuality ( void );
+void   pulseQualityText ( uint8 quality, char * str );
+
+#endif
@@ -31,13 +31,38 @@
   
 #define ENABLE_SD			   0
 #define DISABLE_SD   		1
+
+#define SD_CACHE_SECTOR     512       // bytes cached per file, one card sector
+#define SD_CACHE_SLOTS      2         // files cached at once, one per project session
+#define SD_CACHE_FLUSH_MS   2000      // dirty sectors are written back after this idle time
+#define SD_IDLE_UNMOUNT_MS  60000     // an unused card is unmounted and put to sleep after this
   
 enum { SDOUT,SDFAILED,SDERRSEEK,SDERRWRITE,SDCRDERR,CALCON,STATISTICAL,DRIFTPRNT,STANDARDPRINT,JUNITS,JDATE,LOADING};
 extern  int8 sdOpened;
+extern  char *SD_Str[LOADING + 1];
+
+typedef struct
+{
+   uint16 reads;                        // SDcacheRead calls
+   uint16 writes;                       // SDcacheWrite calls
+   uint16 fs_reads;                     // sector reads sent to emFile
+   uint16 fs_writes;                    // writes sent to emFile
+} sd_cache_stats_t;
+
+typedef struct
+{
+   uint16 mounts;                       // FS_Init of the volume
+   uint16 reuses;                       // starts that found the card mounted
+   uint16 unmounts;
+   uint16 unpaired;                     // SDstop calls with no reference held
+} sd_mount_stats_t;
 
 void    SD_Diag(void);
 void    SDstop(FS_FILE *file);
 void    SDstart();
+void    SDunmount ( void );
+void    SDidle ( void );
+void    getSDmountStats ( sd_mount_stats_t * stats, uint8 reset );
 int32   SDreadBuffer(FS_FILE *file,char *buf,int32 len);
 FS_FILE* SD_CreateProjectSimpleFile (char* str);
 bool     SD_CheckIfProjExists ( char* str );
@@ -52,6 +77,13 @@ void     sd_card_menu();
 void     SD_Wake();
 
 uint8 RemoveDir(char * path);
+uint8 SD_AppendLog ( char * fname, char * line );
+int32 SDcacheRead ( FS_FILE * file, uint32 offset, char * buf, int32 len );
+int32 SDcacheWrite ( FS_FILE * file, uint32 offset, char * buf, int32 len );
+int32 SDcacheFlush ( FS_FILE * file );
+void  SDcacheClose ( FS_FILE * file );
+void  SDcacheIdle ( void );
+void  getSDcacheStats ( sd_cache_stats_t * stats, uint8 reset );
 
 #endif
 //[] END OF FILE
@@ -33,6 +33,7 @@
 /*----------------------------------------------------------------------------*/
 /*-------------------------[   Global Constants   ]---------------------------*/
 /*----------------------------------------------------------------------------*/
+#define NO_SELECTION    0xFFFF    // ESC or error from the project and station pickers
 
 
 /*----------------------------------------------------------------------------*/
@@ -66,9 +67,12 @@ void     manual_storage(uint32_t address);
 void     print_data (  char * project );
 void     write_data_to_printer(void);
 void     write_data_to_USB(void);
+void     recompute_project(void);
+uint16_t recomputeProjectTo ( char * project, char * derived );
 void     review_data(void);
 void    delete_projects(void) ;
 void    storeStationData ( char * project, station_data_t station  )  ;
+void    storeErrorText ( void );
 
 
 #endif 
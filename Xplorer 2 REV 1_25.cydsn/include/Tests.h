@@ -3,6 +3,32 @@
 #define TESTS_H
 #include <Globals.h>
 
+/* Running mean and variance, updated one sample at a time (Welford) */
+typedef struct
+{
+  uint16_t n;
+  float    mean;
+  float    m2;                  // sum of squared differences from the mean
+} run_stats_t;
+
+/* Decision of a sequential test after the latest count */
+typedef enum
+{
+  SEQ_CONTINUE = 0,             // not clear yet, take another count
+  SEQ_PASS,
+  SEQ_FAIL
+} seq_result_t;
+
+/* Standard count statistics, built up as the 7.5s sub-counts come in */
+typedef struct
+{
+  float       d_ref, m_ref;     // expected standard counts, 0 if not known
+  run_stats_t d, m;             // accepted sub-counts
+  uint8_t     taken;            // sub-counts counted
+  uint8_t     rejected;         // sub-counts screened out as outliers
+  BOOL        early;            // accepted before all sub-counts were taken
+} std_stats_t;
+
 void storeDriftResultsToUSB ( Bool display_error );
 void stand_test(void);
 void general_purpose_test(void) ;
@@ -12,7 +38,22 @@ extern void selfTest(void);
 void diag_self_test(void);
 void diag_self_test_print(uint8_t destination);
 void measurePulses ( uint8_t line, uint8_t time1, uint16_t * moisture_count, uint32_t * density_count,uint8 depth ) ;
+void measurePulsesStandardCount ( uint8_t line, std_stats_t * stats );
 void storeStdCountsToUSB ( Bool display_error );
 void extended_drift_test ( void );
+uint32_t getPrecisionMinCounts ( void );
+float getCountRSE ( uint32_t density_raw, uint32_t moisture_raw );
+void  runStatsReset ( run_stats_t * s );
+void  runStatsAdd ( run_stats_t * s, float x );
+float runStatsSD ( const run_stats_t * s );
+float getStdChiRatio ( const run_stats_t * s );
+seq_result_t statSequentialCheck ( const run_stats_t * s );
+seq_result_t driftSequentialCheck ( const run_stats_t * s, float stat_avg, float limit );
+seq_result_t statSequentialStop ( const run_stats_t * d, const run_stats_t * m );
+seq_result_t driftSequentialStop ( const run_stats_t * d, const run_stats_t * m, float d_stat_avg, float m_stat_avg );
+
+extern uint32_t last_count_ms;
+extern float    last_count_rse;
+extern uint8_t  last_count_quality;
 
 #endif
@@ -120,6 +120,10 @@ void all_data_erased_text();
 void erase_data_text();
 void enter_to_delete_text();
 void delete_data_text();
+void cleanup_policy_text();
+void cleanup_days_text(char *temp_str);
+void erase_cleanup_text();
+void projects_deleted_text(uint16 deleted);
 void no_data_stored_text();
 void select_from_list_text(BYTE from_where);
 void no_stored_projects_text();
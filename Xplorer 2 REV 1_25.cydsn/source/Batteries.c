@@ -29,6 +29,7 @@
 #include "LCD_drivers.h"
 #include "Utilities.h"
 #include "Batteries.h"
+#include "SDcard.h"
 
 /************************************* EXTERNAL VARIABLE AND BUFFER DECLARATIONS  *************************************/
 
@@ -115,6 +116,8 @@ void shutdownLowBatteries ( void )
   
     Controls.shut_dwn = TRUE;                           // set when "auto" shut off is enabled   
   
+    SDunmount ( );  // write back the SD cache and unmount before the power goes
+  
     // update status of shutdown, 1 = auto shutdown 
     NV_MEMBER_STORE(OFF_MODE,1);
       
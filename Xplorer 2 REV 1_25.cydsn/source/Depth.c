@@ -201,6 +201,65 @@ void display_invalid_depth( BYTE depth_temp_inches)
  
 }
  /******************************************************************************
+ *  Name: set_precision_mode
+ *  
+ *  PARAMETERS: NA
+ *
+ *  DESCRIPTION: Enables stopping field counts as soon as both tubes reach the
+ *               target precision and sets the target. The count time becomes
+ *               the longest a count may run.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+void set_precision_mode(void)
+{
+  float num_temp;
+  char number_ptr[20] = NULL_NAME_STRING;
+  
+  if ( ( enable_disable_features('P') != YES ) || !Features.adaptive_count )
+  {
+    return;
+  }
+  
+  num_temp = NV_RAM_MEMBER_RD(COUNT_RSE);
+  if ( ( num_temp == 0 ) || ( num_temp > 1000 ) )
+  {
+    num_temp = 100;
+  }
+  
+  CLEAR_DISP;
+  LCD_position(LINE1);
+  if(Features.language_f)
+  {
+    _LCD_PRINT("Target Precision %%:");
+  }
+  else
+  {
+    _LCD_PRINT("Precision Meta %%:");
+  }
+  Enter_to_Accept(LINE3);
+  ESC_to_Exit(LINE4);
+  
+  sprintf(number_ptr,"%.2f", num_temp / 100.0);
+  num_temp = enterNumber ( number_ptr, LINE2, 5 );
+  
+  if ( getLastKey() == ESC )
+  {
+    return;
+  }
+  if ( num_temp < 0.1 )
+  {
+    num_temp = 0.1;
+  }
+  else if ( num_temp > 10.0 )
+  {
+    num_temp = 10.0;
+  }
+  NV_MEMBER_STORE(COUNT_RSE, (uint16_t)(num_temp * 100 + 0.5));
+}
+
+/******************************************************************************
  *  Name:
  *  
  *  PARAMETERS:None
@@ -253,6 +312,7 @@ void set_count_time(void)  // set duration of count (TIME button initiates)
     {      
       cnt_time = value;
       NV_MEMBER_STORE(COUNT_TIME, cnt_time);      
+      set_precision_mode();
       break;
     }
     else if(button == DOWN)
@@ -30,6 +30,7 @@
 #include  "Batteries.h"
 #include  "prompts.h"
 #include  "Utilities.h"
+#include  "PulseCounter.h"
 /*----------------------------------------------------------------------------*/
 /*------------------------[   Module Global Variables   ]---------------------*/
 /*----------------------------------------------------------------------------*/
@@ -96,39 +97,7 @@ static uint16_t charge_timer = 0;
     
     if (  Spec_flags.auto_turn_off && (shutdown_timer > g_turn_off_cnts) && !Spec_flags.self_test )     // 36000 = 1 hr
     {
-      Flags.stand_flag = FALSE;
-      Controls.shut_dwn = TRUE;                           // set when "auto" shut off is enabled   
-      
-      // update status of shutdown, 1 = auto shutdown 
-      NV_MEMBER_STORE(OFF_MODE,1);
-          
-      // write all flag settings to memory      
-      NV_MEMBER_STORE( OFFSET_SETTINGS,Offsets);
-       
-      //NV_MEMBER_STORE( FEATURE_SETTINGS, Features );
-         
-      NV_MEMBER_STORE( FLAG_SETTINGS, Flags );          
-     
-      Controls_U.controls_bitfield = &Controls;     
-      NV_MEMBER_STORE( CONTROL_SETTINGS, Controls );     
-	    Global_ID();                                                 // shutdown all competition.
-
-	    shutdown_inactivity_text_text();
-       // flash the keyboard backlight
-      KEY_B_LIGHT_ENABLE(); 		                    // turn on keyboard backlight                  
-      delay_ms(1000);    
-     	KEY_B_LIGHT_DISABLE();                       // turn OFF keyboard backlight
-      delay_ms(1000);
-      Global_ID();
-      
-      MICRO_POWER_DISABLE();
-           
-      while(1) 
-      {
-       delay_ms(100);  
-       MICRO_POWER_DISABLE();
-      };    
-      
+      requestShutDown ( AUTO );
    }
    else	if ( (CHARGER_DETECT_Read()==CHARGER_OFF) && (shutdown_timer <= g_turn_off_cnts) )
    { 
@@ -188,8 +157,7 @@ CY_ISR ( ISR_KILL ) {
  isr_ON_OFF_ClearPending();
  ON_OFF_INT_IO_ClearInterrupt();
 
- isrTIMER_1_Disable();
- shut_down_text();
+ requestShutDown ( MANUAL );
        
 }
 /*******************************************************************************
@@ -197,7 +165,7 @@ CY_ISR ( ISR_KILL ) {
  *  DESCRIPTION:
  *  RETURNS:
  ******************************************************************************/
-CY_ISR ( MS_TIMER_ISR ) { msTimer++; }
+CY_ISR ( MS_TIMER_ISR ) { msTimer++; pulseBinTick(); checkShutDownWait(); }
 /*******************************************************************************
  *  DESCRIPTION: Receives data packets from the BLE module
  ******************************************************************************/
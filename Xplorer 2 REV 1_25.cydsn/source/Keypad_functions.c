@@ -311,7 +311,7 @@ void  scan_keys ( void )
       if(off_counter >= 10 )   // 5 is pretty fast.
       {
 
-        shut_down_text();
+        requestShutDown ( MANUAL );
       }
 	    else
       {
@@ -403,6 +403,7 @@ void wait_for_key_release ( void )
   
  while ( Flags.button_pressed  )
  { 
+  serviceShutDown();
   delay_ms(10);  
  }
   
@@ -439,6 +440,7 @@ void wait_for_key_release ( void )
       
   while ( ( !Flags.button_pressed ) && ( time_delay_ms-- > 0 ))
   {
+    serviceShutDown();
     delay_ms(1);
      
   }
@@ -468,6 +470,7 @@ void wait_for_key_release ( void )
       
   while ( ( !Flags.button_pressed ) && ( time_delay_ms-- > 0 ))
   {
+    serviceShutDown();
     delay_ms(1);
      
   }
@@ -32,16 +32,60 @@
 #include "SDcard.h"
 #include "BlueTooth.h"
 #include "Measurement.h"
+#include "PulseCounter.h"
+#include "Profiler.h"
 
 /************************************* EXTERNAL VARIABLE AND BUFFER DECLARATIONS  *************************************/
 uint8_t measureThinLayer(void) ;
+extern float convertKgM3DensityToUnitDensity ( float value_in_kg, uint8_t units );
+extern void pulseBuzzer ( void );
 /************************************************  LOCAL DEFINITIONS  *************************************************/
 #define MAX_FLOAT_VALUE 10000.0
 #define MIN_FLOAT_VALUE .001
 // 15 minute wait time when 50ms delay is used
 #define WAIT_TIME_BEFORE_BREAK  ( 11380 )
 #define NO_DEMO_DEBUG  1
+// rolling mode: 15s window of pulse bins, one shot restarted every 60s
+#define ROLLING_WINDOW_BINS     ( 15000 / PULSE_BIN_MS_DEFAULT )
+#define ROLLING_SEGMENT_SEC     60.0
+#define ROLLING_MIN_MS          3750
+#define SWEEP_SETTLE_MS         2000    // rod must rest at a new depth this long before a sweep count
+#define SWEEP_POLL_MS           250
+#define SWEEP_SHOW_MOVE         0       // sweep screens, redrawn only when they change
+#define SWEEP_SHOW_SETTLE       1
+#define SWEEP_SHOW_NONE         0xFFFF
+// hands-free start: rod out of SAFE and held at one valid depth
+#define AUTO_START_STABLE_POLLS 2       // main loop depth polls at the same depth
+#define AUTO_START_COUNTDOWN_S  3       // audible countdown, any key cancels
+// post count jobs, run from the result screen after it is shown
+#define POST_JOB_NV             0x01    // last test time, depth and GPS to EEPROM
+#define POST_JOB_STORE          0x02    // station to the project on SD
+#define POST_JOB_BLE_CC         0x04
+#define POST_JOB_BLE            0x08
+#define POST_BEEP_MS            800     // end of test beep
 /*****************************************  VARIABLE AND BUFFER DECLARATIONS  *****************************************/
+post_timing_t post_timing;
+
+static uint8_t         post_jobs;           // POST_JOB_xxx still queued
+static uint8_t         post_errors;         // POST_JOB_xxx that failed
+static uint8_t         post_shown;          // jobs/errors last shown on LINE4
+static uint32_t        post_start;          // msTimer at the end of the count
+static uint32_t        post_beep_end;       // msTimer to end the beep
+static BOOL            post_beeping;
+static BOOL            post_result_up;      // result_ms has been taken
+static date_time_t     post_date;
+static uint8_t         post_depth;
+static BOOL            post_recall;
+static station_data_t  post_store_d;        // station as stored to the project
+static station_data_t  post_ble_d;          // station as sent over BLE
+
+/* cal_terms_t of each cal depth and the constants they were worked out from */
+static struct
+{
+    DOUBLE_FLOAT  A, B, C;
+    cal_terms_t   t;
+    BOOL          ok;
+} cal_cache[MAX_DEPTHS];
 
 /******************************************************************************
  *
@@ -89,6 +133,554 @@ uint8_t measureThinLayer(void) ;
                 break;
  }
 }
+/******************************************************************************
+ *
+ *  Name: getCalTerms ( uint8_t depth )
+ *
+ *  PARAMETERS: depth setting
+ *
+ *  DESCRIPTION: Returns ln A, 1/B and C for the depth. They are worked out
+ *               again in double whenever the stored A, B or C differ from
+ *               the ones they came from, so new constants from the keypad
+ *               or the serial port are picked up on the next reading.
+ *
+ *  RETURNS: terms of the depth
+ *
+ *****************************************************************************/
+const cal_terms_t * getCalTerms ( uint8_t depth )
+{
+    uint8_t i = getCalibrationDepth ( depth );
+    const t_depth_cal_const_abs * nv = &NV_CONSTANTS(DEPTHS[i]);
+    
+    if ( !cal_cache[i].ok || ( cal_cache[i].A != nv->A ) || ( cal_cache[i].B != nv->B ) || ( cal_cache[i].C != nv->C ) )
+    {
+        cal_cache[i].A      = nv->A;
+        cal_cache[i].B      = nv->B;
+        cal_cache[i].C      = nv->C;
+        cal_cache[i].t.lnA  = log ( nv->A );
+        cal_cache[i].t.invB = 1.0 / nv->B;
+        cal_cache[i].t.C    = nv->C;
+        cal_cache[i].ok     = TRUE;
+    }
+    return &cal_cache[i].t;
+}
+/******************************************************************************
+ *
+ *  Name: calDensityGcc ( const meas_consts_t * k, float cr )
+ *
+ *  PARAMETERS: constants of the depth, density count ratio
+ *
+ *  DESCRIPTION: WD = 1/B * ( ln A - ln ( CR + C ) ), which is
+ *               1/B * LN ( A / (CR + C) ) in single precision. Against the
+ *               double expression the error stays below
+ *               4 * 2^-24 * |1/B| * ( |ln A| + |ln (CR + C)| + 1 ), about
+ *               1.5e-5 GCC for B down to 0.05, well under the 0.001 GCC
+ *               the gauge shows.
+ *
+ *  RETURNS: density without moisture correction or offsets, GCC
+ *
+ *****************************************************************************/
+float calDensityGcc ( const meas_consts_t * k, float cr )
+{
+    return k->invB * ( k->lnA - logf ( cr + k->Cd ) );
+}
+/******************************************************************************
+ *
+ *  Name: calSpecialB ( uint8_t depth, float cr, float density_gcc )
+ *
+ *  PARAMETERS: depth setting, count ratio and density of the special
+ *              calibration
+ *
+ *  DESCRIPTION: Solves WD = 1/B * LN ( A / (CR + C) ) for B with the A and
+ *               C of the depth.
+ *
+ *  RETURNS: special calibration B, GCC
+ *
+ *****************************************************************************/
+float calSpecialB ( uint8_t depth, float cr, float density_gcc )
+{
+    const cal_terms_t * t = getCalTerms ( depth );
+    
+    return ( t->lnA - logf ( cr + t->C ) ) / density_gcc;
+}
+/******************************************************************************
+ *
+ *  Name: loadMeasConsts ( uint8_t depth, meas_consts_t * k )
+ *
+ *  PARAMETERS: depth setting, constants to fill
+ *
+ *  DESCRIPTION: Collects the calibration constants and standard counts a
+ *               reading at this depth needs. Cal consts are in GCC.
+ *
+ *  RETURNS: TRUE if the special calibration B replaced the depth B
+ *
+ *****************************************************************************/
+uint8_t loadMeasConsts ( uint8_t depth, meas_consts_t * k )
+{
+    uint8_t spec_cal = FALSE;
+    const cal_terms_t * t = getCalTerms ( depth );
+    
+    k->lnA = t->lnA;
+    if( Spec_flags.spec_cal_flag && (NV_RAM_MEMBER_RD(SPECIALCAL_DEPTH) == depth))
+    {  //  check for spec calibration mode
+        k->invB = 1.0f / NV_RAM_MEMBER_RD (Constants.SPECIALCAL_B);
+        spec_cal = TRUE;
+    }
+    else
+    {
+        k->invB = t->invB;
+    }
+    k->Cd   = t->C;
+    k->E    = NV_RAM_MEMBER_RD(Constants.E_MOIST_CONST);
+    k->invF = 1.0 / NV_RAM_MEMBER_RD(Constants.F_MOIST_CONST);
+    k->m_stand = NV_RAM_MEMBER_RD (MOIST_STAND);
+    k->d_stand = NV_RAM_MEMBER_RD (DEN_STAND);
+    
+    return spec_cal;
+}
+/******************************************************************************
+ *
+ *  Name: getActiveOffsets ( meas_offsets_t * o )
+ *
+ *  PARAMETERS: offsets to fill
+ *
+ *  DESCRIPTION: Collects the offsets, Proctor and Marshall the gauge is set
+ *               to use now.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+void getActiveOffsets ( meas_offsets_t * o )
+{
+    o->mask = 0;
+    if ( Offsets.den_offset_pos )
+    {
+        o->mask |= DENSITY_OFFSET_BIT;
+    }
+    if ( Offsets.moist_offset_pos )
+    {
+        o->mask |= MOISTURE_OFFSET_BIT;
+    }
+    if ( Offsets.tren_offset_pos )
+    {
+        o->mask |= TRENCH_OFFSET_BIT;
+    }
+    o->d_offset = NV_RAM_MEMBER_RD(D_OFFSET);
+    o->k_value  = NV_RAM_MEMBER_RD(K_VALUE);
+    o->t_offset = NV_RAM_MEMBER_RD(T_OFFSET);
+    o->proctor  = NV_RAM_MEMBER_RD(PROCTOR);
+    o->marshall = NV_RAM_MEMBER_RD(MARSHALL);
+}
+/******************************************************************************
+ *
+ *  Name: calcMoistureDensity ( )
+ *
+ *  PARAMETERS: density and moisture counts, constants, result
+ *
+ *  DESCRIPTION: Calculates a reading with the offsets the gauge is set to
+ *               use now, see calcWithOffsets.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+void calcMoistureDensity ( uint32_t density_cnt, uint16_t moisture_cnt, const meas_consts_t * k, meas_result_t * r )
+{
+    meas_offsets_t o;
+    
+    getActiveOffsets ( &o );
+    calcWithOffsets ( density_cnt, moisture_cnt, k, &o, r );
+}
+/******************************************************************************
+ *
+ *  Name: calcWithOffsets ( )
+ *
+ *  PARAMETERS: density and moisture counts, constants, offsets, result
+ *
+ *  DESCRIPTION: WD = 1/Bd * LN ( Ad / (CR + Cd ) ) - M/20 , where Ad, Bd, Cd are the density cal constants
+ *               M  = ( MCR - E) / F, where E, F are the moisture cal constants.
+ *               The trench, density and K offsets in o->mask are applied.
+ *               Results are in KG/M3.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+void calcWithOffsets ( uint32_t density_cnt, uint16_t moisture_cnt, const meas_consts_t * k, const meas_offsets_t * o, meas_result_t * r )
+{
+    float Mg, Mt;
+    
+    if ( o->mask & TRENCH_OFFSET_BIT ) { //Moisture Calculations, add the trenchoffset to the moisture count before getting the  moisture count ratio
+        r->mcr = ((float)moisture_cnt + o->t_offset )/(float)k->m_stand;
+    }
+    else { // moisture count ratio is the current moisture count divided by the moisture standard count
+        r->mcr = (float)moisture_cnt / (float)k->m_stand;
+    }
+    checkFloatLimits ( & r->mcr );
+    r->moisture = ((r->mcr - k->E) * k->invF) ; // moisture calculation. Result is supposed to be in GCC.
+    checkFloatLimits ( & r->moisture );
+    r->cr = (float)density_cnt / (float)k->d_stand; //Density Calculations. Result is supposed to be in GCC. get the density count ration
+    checkFloatLimits ( & r->cr );
+    r->density = calDensityGcc ( k, r->cr ) ; // density calculation without offset
+    r->density = r->density - ( r->moisture/20); // density without offset
+    checkFloatLimits ( & r->density );
+    r->density /= GCC_TO_KG;  // density in KGM3 // All offsets are stored in Kg/M3 units. So, change GCC units to KG/M3
+    r->moisture /= GCC_TO_KG; // density in KGM3
+    if ( o->mask & DENSITY_OFFSET_BIT ) { // density calculation with density offset. Offset should be stored in kg
+        r->density +=  o->d_offset;
+    }
+    r->dry_dens = r->density - r->moisture; // %Moisture and Dry Density Calculations without K offset DD calculation without K offset
+    r->moist_percent = (r->moisture / r->dry_dens) * 100; //Moist percent calculation without K offset
+    if ( o->mask & MOISTURE_OFFSET_BIT ) 
+    { // %Moisture and Dry Density Calculations with K offset This requires a new Bm value found from K
+        // K = 1000 x ( %Mtrue - %Mgauge ) / ( %Mgauge + 100 )
+        // %Mtrue = ( K x (%Mgauge + 100 ) / 1000 ) + %Mgauge
+        // %M = (moisture * 100) / ( density - moisture )
+        // moisture = (%M * density)/(100 + %M)
+        Mg = r->moist_percent;
+        Mt = (( o->k_value * ( Mg + 100 ) ) / 1000.0) + Mg;
+        r->moisture = (Mt * r->density)/(100 + Mt); // recalulate moisture using new %Mt
+        r->dry_dens = r->density - r->moisture;                               // DD calculation
+        r->moist_percent = (r->moisture / r->dry_dens) * 100.0;   //
+    }
+    r->pr_percent = (r->dry_dens / o->proctor) * 100;  //calculate %PR
+    checkFloatLimits ( & r->dry_dens );  // check to see if values are valid numbers
+    checkFloatLimits ( & r->moist_percent );
+    checkFloatLimits ( & r->pr_percent );
+}
+/******************************************************************************
+ *
+ *  Name: setStationOffsets ( station_data_t * station_d )
+ *
+ *  PARAMETERS: station record
+ *
+ *  DESCRIPTION: Records the active offsets and display units in the station.
+ *               Bits already set in offset_mask are kept.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+void setStationOffsets ( station_data_t * station_d )
+{
+    station_d->kk_value        = 0.0; // clear all offset values.
+    station_d->bottom_den      = 0.0;
+    station_d->den_off         = 0.0;
+    station_d->k_value         = 0.0;
+    station_d->t_offset        = 0;
+    if ( Offsets.den_offset_pos )
+    { // set the offset mask for the station
+        station_d->offset_mask     |= DENSITY_OFFSET_BIT;
+        station_d->den_off = NV_RAM_MEMBER_RD(D_OFFSET);
+    }
+    if ( Offsets.moist_offset_pos ) 
+    {
+        station_d->offset_mask     |= MOISTURE_OFFSET_BIT;
+        station_d->k_value  = NV_RAM_MEMBER_RD ( K_VALUE );
+    }
+    if ( Offsets.tren_offset_pos ) 
+    {
+        station_d->offset_mask     |= TRENCH_OFFSET_BIT;
+        station_d->t_offset        = NV_RAM_MEMBER_RD ( T_OFFSET );
+    }
+    if ( Features.SI_units == FALSE )
+    { station_d->units           = PCF;
+    }
+    else if ( Features.kg_gcc_units == GCC_UNITS ) 
+    { station_d->units           = GM_CC; 
+    }
+    else 
+    { 
+      station_d->units          = KG_M3; 
+    }
+}
+/******************************************************************************
+ *
+ *  Name: recomputeStation ( station_data_t * station_d )
+ *
+ *  PARAMETERS: stored station, updated in place
+ *
+ *  DESCRIPTION: Works a stored station out again from its raw counts and
+ *               the standard counts it was taken with, using the cal
+ *               constants, offsets, Proctor, Marshall and nomograph values
+ *               the gauge is set to now. A station taken with the special
+ *               calibration gets the current special B.
+ *
+ *  RETURNS: FALSE if the station can not be worked out again
+ *
+ *****************************************************************************/
+uint8_t recomputeStation ( station_data_t * station_d )
+{
+    meas_consts_t  k;
+    meas_offsets_t o;
+    meas_result_t  r;
+    const cal_terms_t * t;
+    float kk;
+    
+    if ( ( station_d->depth == 0 ) || ( station_d->depth > 12 ) || ( station_d->density_stand == 0 ) || ( station_d->moisture_stand == 0 ) )
+    {
+        return FALSE;
+    }
+    t = getCalTerms ( station_d->depth );
+    k.lnA = t->lnA;
+    if ( station_d->offset_mask & SPECIAL_CAL_BIT )
+    {
+        k.invB = 1.0f / NV_RAM_MEMBER_RD (Constants.SPECIALCAL_B);
+    }
+    else
+    {
+        k.invB = t->invB;
+    }
+    k.Cd   = t->C;
+    k.E    = NV_RAM_MEMBER_RD(Constants.E_MOIST_CONST);
+    k.invF = 1.0 / NV_RAM_MEMBER_RD(Constants.F_MOIST_CONST);
+    k.d_stand = station_d->density_stand;
+    k.m_stand = station_d->moisture_stand;
+    
+    getActiveOffsets ( &o );
+    calcWithOffsets ( station_d->density_count, station_d->moisture_count, &k, &o, &r );
+    station_d->density  = r.density;
+    station_d->moisture = r.moisture;
+    station_d->MCR      = r.mcr;
+    station_d->PR       = o.proctor;
+    station_d->MA       = o.marshall;
+    
+    station_d->offset_mask &= ~(DENSITY_OFFSET_BIT | MOISTURE_OFFSET_BIT | TRENCH_OFFSET_BIT);
+    setStationOffsets ( station_d );
+    if ( station_d->offset_mask & NOMOGRAPH_OFFSET_BIT )
+    {
+        kk = NV_RAM_MEMBER_RD ( KK_VALUE );
+        station_d->kk_value   = kk;
+        station_d->bottom_den = NV_RAM_MEMBER_RD ( BOTTOM_DENS );
+        station_d->DT = ( station_d->density - ( kk * station_d->bottom_den ) ) / ( 1 - kk );
+        checkFloatLimits ( & station_d->DT );
+    }
+    else
+    {
+        station_d->DT = 0;
+    }
+    return TRUE;
+}
+/******************************************************************************
+ *
+ *  Name: takeGPSFix ( station_data_t * station_d )
+ *
+ *  PARAMETERS: station to fill
+ *
+ *  DESCRIPTION: Puts the newest GPS fix in the station if it is no older
+ *               than GPS_MAX_AGE, without waiting for a new sentence. The
+ *               fix age is kept with the station, the fix quality is in
+ *               gps_read.fix.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+static void takeGPSFix ( station_data_t * station_d )
+{
+    GPSDATA  fix;
+    uint32   age_ms, max_age;
+    
+    memset ( &station_d->gps_read, 0, sizeof(GPSDATA) );
+    station_d->gps_read.fix = ' ';
+    station_d->gps_age      = GPS_AGE_NONE;
+    if ( Features.gps_on == FALSE )
+    {
+        return;
+    }
+    max_age = NV_RAM_MEMBER_RD ( GPS_MAX_AGE );
+    if ( ( max_age == 0 ) || ( max_age > GPS_MAX_AGE_LIMIT ) )
+    {
+        max_age = GPS_MAX_AGE_DEFAULT;
+    }
+    if ( gpsGetSnapshot ( &fix, &age_ms ) && ( age_ms <= max_age * 1000 ) )
+    {
+        station_d->gps_read = fix;
+        station_d->gps_age  = age_ms / 100;
+    }
+}
+/******************************************************************************
+ *
+ *  Name: runPostJob ( void )
+ *
+ *  PARAMETERS: NA
+ *
+ *  DESCRIPTION: Runs the oldest queued post count job and books its time.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+static void runPostJob ( void )
+{
+    uint32_t start = msTimer;
+    
+    if ( post_jobs & POST_JOB_NV )
+    {
+        post_jobs &= ~POST_JOB_NV;
+        NV_MEMBER_STORE(LAST_TEST_TIME, post_date); // Recall will need the time, type and depth of the reading.
+        NV_MEMBER_STORE(LAST_TEST_DEPTH, post_depth );
+        SavePartialEepromData((uint8*)&eepromData.LAST_GPS_READING, sizeof(GPSDATA), offsetof( EEPROM_DATA_t,LAST_GPS_READING)) ;
+        post_timing.nv_ms += msTimer - start;
+        profAdd ( PROF_EEPROM, msTimer - start );
+    }
+    else if ( post_jobs & POST_JOB_STORE )
+    {
+        post_jobs &= ~POST_JOB_STORE;
+        if ( writeStation ( project_info.current_project, project_info.station_index, &post_store_d ) &&
+             incrementStationNumber ( project_info.current_project ) )         //increment number of stations within project
+        {
+            project_info.station_index     = getStationNumber ( project_info.current_project );
+        }
+        else
+        {
+            post_errors |= POST_JOB_STORE;
+        }
+        post_timing.store_ms += msTimer - start;
+        profAdd ( PROF_SD, msTimer - start );
+    }
+    else if ( post_jobs & POST_JOB_BLE_CC )
+    {
+        post_jobs &= ~POST_JOB_BLE_CC;
+        SendBLEDataCC ();
+        post_timing.ble_ms += msTimer - start;
+        profAdd ( PROF_BLE, msTimer - start );
+    }
+    else if ( post_jobs & POST_JOB_BLE )
+    {
+        post_jobs &= ~POST_JOB_BLE;
+        SendBLEData ( &post_ble_d, (bool)post_recall );
+        post_timing.ble_ms += msTimer - start;
+        profAdd ( PROF_BLE, msTimer - start );
+    }
+    if ( post_jobs == 0 )
+    {
+        post_timing.done_ms = msTimer - post_start;
+    }
+}
+/******************************************************************************
+ *
+ *  Name: showPostStatus ( void )
+ *
+ *  PARAMETERS: NA
+ *
+ *  DESCRIPTION: Shows the post count job status on LINE4 of the result
+ *               screen. Once everything is done without errors the normal
+ *               key prompt is shown.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+static void showPostStatus ( void )
+{
+    LCD_position(LINE4);
+    if ( post_jobs & POST_JOB_STORE )
+    {
+        _LCD_PRINT( Features.language_f ? "Storing Station...  " : "Guardando...        " );
+    }
+    else if ( post_jobs )
+    {
+        _LCD_PRINT( Features.language_f ? "Sending Data...     " : "Enviando...         " );
+    }
+    else if ( post_errors & POST_JOB_STORE )
+    {
+        _LCD_PRINT( Features.language_f ? "Station NOT Stored  " : "Estacion NO Guardada" );
+    }
+    else if(Features.language_f)
+    {
+        _LCD_PRINT("    PRESS UP/DOWN   ");
+    }
+    else
+    {
+        _LCD_PRINT ("Arriba/Abajo       ");
+    }
+    post_shown = post_jobs | ( post_errors << 4 );
+}
+/******************************************************************************
+ *
+ *  Name: servicePostJobs ( void )
+ *
+ *  PARAMETERS: NA
+ *
+ *  DESCRIPTION: Called from the result screen key loops. Ends the beep when
+ *               it is due, then runs one queued job once the buzzer is quiet
+ *               so the SD and BLE work does not stretch the beep.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+static void servicePostJobs ( void )
+{
+    if ( post_beeping && ( (int32_t)( msTimer - post_beep_end ) >= 0 ) )
+    {
+        output_low(BUZZER);
+        post_beeping = FALSE;
+    }
+    if ( post_jobs && !post_beeping )
+    {
+        runPostJob ();
+    }
+    if ( post_shown != ( post_jobs | ( post_errors << 4 ) ) )
+    {
+        showPostStatus ();
+    }
+}
+/******************************************************************************
+ *
+ *  Name: finishPostJobs ( void )
+ *
+ *  PARAMETERS: NA
+ *
+ *  DESCRIPTION: Runs whatever is still queued, used before leaving the
+ *               result screen or storing by hand.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+static void finishPostJobs ( void )
+{
+    if ( post_beeping )
+    {
+        while ( (int32_t)( msTimer - post_beep_end ) < 0 )
+        {
+            ;
+        }
+        output_low(BUZZER);
+        post_beeping = FALSE;
+    }
+    while ( post_jobs )
+    {
+        runPostJob ();
+    }
+}
+/******************************************************************************
+ *
+ *  Name: postCountTimingReport ( void )
+ *
+ *  PARAMETERS: NA
+ *
+ *  DESCRIPTION: Diagnostic page with the post count phases of the last
+ *               measurement. Done in series the operator would have waited
+ *               for the EEPROM, SD and BLE work plus the beep before the
+ *               result, now the result shows after result_ms.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+void postCountTimingReport ( void )
+{
+    uint32_t serial_ms;
+    
+    serial_ms = post_timing.nv_ms + post_timing.store_ms + post_timing.ble_ms + POST_BEEP_MS;
+    
+    CLEAR_DISP;
+    LCD_position(LINE1);
+    _LCD_PRINTF("Result:  %lu ms",(unsigned long)post_timing.result_ms);
+    LCD_position(LINE2);
+    _LCD_PRINTF("EE/SD: %lu",(unsigned long)post_timing.nv_ms);
+    LCD_position(LINE2+12);
+    _LCD_PRINTF("/%lu",(unsigned long)post_timing.store_ms);
+    LCD_position(LINE3);
+    _LCD_PRINTF("BLE:     %lu ms",(unsigned long)post_timing.ble_ms);
+    LCD_position(LINE4);
+    _LCD_PRINTF("Saved:   %lu ms",(unsigned long)( ( serial_ms > post_timing.result_ms ) ? serial_ms - post_timing.result_ms : 0 ));
+    getKey( TIME_DELAY_MAX );
+}
 /******************************************************************************
  *
  *  Name: void measureMoistureDensity(void)
@@ -105,14 +697,16 @@ uint8_t measureMoistureDensity(void)
 { // leads user through a general count, (START button initiates)
     Bool auto_scroll_advance = 0;    //Bool prompt_for_start = 0;
     int8_t LCD_offset = 13, lcd_line, hj, x;
-    int16_t loop_cnt = 0, spec_cal_depth = 14;
-    float  Ad,Bd,Cd,E,F, Mg, Mt, cr, per_MA, mcr, pr, ma,dry_dens, moist_percent;
+    int16_t loop_cnt = 0;
+    float  cr, per_MA, mcr, pr, ma,dry_dens, moist_percent;
     float  KK, dt, bottom_density,temp_cnt, pr_temp, density, moisture;
     enum buttons button;
     uint16_t    d_stand, m_stand, wait_time, moisture_cnt = 0;
     date_time_t date_time;
     uint32_t    density_cnt = 0;
     station_data_t station_d;
+    meas_consts_t  consts;
+    meas_result_t  result;
     char   temp_str[80], buff[21];
     int str_equal;
     static float soil_air_voids,soil_sg;
@@ -121,6 +715,7 @@ uint8_t measureMoistureDensity(void)
 #if AUTO_TEST
     cnt_time = 1;
 #endif
+    profStart();  // phase times of this reading go to the SD timing log
 
     if ( Features.SI_units == FALSE )
     { 
@@ -138,10 +733,6 @@ uint8_t measureMoistureDensity(void)
        } 
     }
     Global_IE();
-    if(Spec_flags.spec_cal_flag) 
-    { 
-      spec_cal_depth = NV_RAM_MEMBER_RD(SPECIALCAL_DEPTH);
-    }
     if ( Spec_flags.recall_flag )
     { // Recall the depth
         depth_setting    = NV_RAM_MEMBER_RD(LAST_TEST_DEPTH);
@@ -153,6 +744,7 @@ uint8_t measureMoistureDensity(void)
     }
     else
     {
+        profBegin ( PROF_DEPTH );
         if(Features.auto_depth)
         { 
           tst_depth_g = get_depth_auto( 0 ); 
@@ -194,13 +786,12 @@ uint8_t measureMoistureDensity(void)
             delay_ms(1000);
             return 0;
         }
+        profEnd ( PROF_DEPTH );
   	} // end of getting depth
     if ( Features.auto_store_on && (Spec_flags.recall_flag == 0))
     { // Automatic Project storage on
-        if ( sdOpened == OFF )
-        { 
-          SDstart(); 
-        }
+        profBegin ( PROF_PROJECT );
+        SDstart();                    // given back on every way out of the project setup
         updateProjectInfo();
         str_equal= strcmp ((const char*)& project_info.current_project,  "none_selected" );
         if ( ( project_info.number_of_projects == 0 ) || (str_equal == 0 ) )
@@ -208,31 +799,22 @@ uint8_t measureMoistureDensity(void)
             start_new_project();
             if( getLastKey() == ESC) 
             {
-                if(sdOpened == ON) 
-                { 
-                  SDstop(null);
-                }
+                SDstop(null);
                 return 0;
             }
         }
-        if ( project_info.station_index >= MAX_STATIONS ) 
+        if ( !projectHasRoom ( project_info.current_project ) ) 
         { // Check to see if all station positions are full
             max_stations_text( project_info.current_project ); // display "Max # of Stations\nFor %s Has\nBeen Exceeded.\nStart New Project",current_project
             delay_ms(1500);
-            if (  sdOpened == ON  ) 
-            { 
-              SDstop(null); 
-            }
+            SDstop(null); 
             return 0;
         }
         if ( SD_CheckIfProjExists ( project_info.current_project ) == FALSE ) 
         { // auto store is on and a valid project is not selected
             no_project_selected();  //display "No Project Has Been\nSelected. Please\nCreate or Select\nProject."
             delay_ms(1500);
-            if (  sdOpened == ON  ) 
-            { 
-              SDstop(null);
-            }
+            SDstop(null);
             return 0;
         }
        if ( !Flags.auto_number_stations )
@@ -244,10 +826,7 @@ uint8_t measureMoistureDensity(void)
             enter_name ( project_info.current_station_name, lcd_line ); //write entered name of station
             if ( getLastKey() == ESC) 
             { //prompt_for_start = TRUE;
-                if (  sdOpened == ON  ) 
-                { 
-                  SDstop(null); 
-                }
+                SDstop(null); 
                 return 0;
             }
         }
@@ -256,32 +835,27 @@ uint8_t measureMoistureDensity(void)
             auto_number_temp = project_info.station_index + project_info.station_start ;  // equals index of last station
             itoa(auto_number_temp, project_info.current_station_name, 10);
         }
+        SDstop(null);                 // storeStationData takes its own reference
+        profEnd ( PROF_PROJECT );
     } // end project setup
+    profBegin ( PROF_RTC );
    	read_RTC( &date_time_g );  //read time at beginning of count
+    profEnd ( PROF_RTC );
     if ( Spec_flags.recall_flag == FALSE)
     { 
       date_time = date_time_g;
     }
-    Ad = get_constant('a', depth_setting ); // Calibration constants are stored in GCC units.
-    station_d.offset_mask     = 0;
-    if( Spec_flags.spec_cal_flag && (spec_cal_depth == depth_setting))
-    {  //  check for spec calibration mode
-        Bd = NV_RAM_MEMBER_RD (Constants.SPECIALCAL_B);
-        station_d.offset_mask  |= SPECIAL_CAL_BIT;
-    }
-    else
-    {
-      Bd = get_constant('b', depth_setting ); 
-    }
-    Cd = get_constant('c', depth_setting );
-    E = NV_RAM_MEMBER_RD(Constants.E_MOIST_CONST);
-    F = NV_RAM_MEMBER_RD(Constants.F_MOIST_CONST) ;
     if ( Features.dummy_mode == TRUE )
     { 
       NV_MEMBER_STORE(MOIST_STAND, 900); NV_MEMBER_STORE(DEN_STAND, 3200);
     }
-    m_stand = NV_RAM_MEMBER_RD (MOIST_STAND);
-    d_stand = NV_RAM_MEMBER_RD (DEN_STAND);
+    station_d.offset_mask     = 0;
+    if ( loadMeasConsts ( depth_setting, &consts ) )
+    {  //  spec calibration B is in use
+        station_d.offset_mask  |= SPECIAL_CAL_BIT;
+    }
+    m_stand = consts.m_stand;
+    d_stand = consts.d_stand;
     pr = NV_RAM_MEMBER_RD(PROCTOR);
     ma = NV_RAM_MEMBER_RD(MARSHALL);
     Controls.reset_count = TRUE;
@@ -290,10 +864,10 @@ uint8_t measureMoistureDensity(void)
             if(!Spec_flags.recall_flag) {
                 while ( Controls.reset_count ) {
                     CLEAR_DISP;
+                    profBegin ( PROF_COUNT );
                     measurePulses(LINE4, cnt_time, &moisture_cnt, &density_cnt, depth_setting );           //take measurements
+                    profEnd ( PROF_COUNT );
                     if (getLastKey() == ESC || getLastKey() == ENTER ) { break; }
-                    NV_MEMBER_STORE(LAST_TEST_TIME,date_time_g); // Recall will need the time, type and depth of the reading.
-                    NV_MEMBER_STORE(LAST_TEST_DEPTH, depth_setting );
                     if ( Features.dummy_mode == TRUE ) {
                         moisture_cnt = 500;
                         density_cnt = 1000;
@@ -305,22 +879,28 @@ uint8_t measureMoistureDensity(void)
             moisture_cnt = NV_RAM_MEMBER_RD ( M_CNT_AVG );
             density_cnt  = NV_RAM_MEMBER_RD ( D_CNT_AVG );
             if ( getLastKey() == ESC || getLastKey() == ENTER ) { break; }
-            // WD = 1/Bd * LN ( Ad / (CR + Cd ) ) - M/20 , where Ad, Bd, Cd are the density cal constants
-            // M  = ( MCR - E) / F, where E, F are the moisture cal constants.
-            if(Offsets.tren_offset_pos) { //Moisture Calculations, add the trenchoffset to the moisture count before getting the  moisture count ratio
-                float trench = NV_RAM_MEMBER_RD(T_OFFSET);
-                mcr = ((float)moisture_cnt + trench )/(float)m_stand;
-            }
-            else { // moisture count ratio is the current moisture count divided by the moisture standard count
-                mcr = (float)moisture_cnt / (float)m_stand;
-            }
-            checkFloatLimits ( & mcr );
-            moisture = ((mcr - E) / F) ; // moisture calculation. Result is supposed to be in GCC. //if ( Features.d ummy_mode == TRUE ) { moisture = .25; }
-            checkFloatLimits ( & moisture );
-            cr = (float)density_cnt / (float)d_stand; //Density Calculations. Result is supposed to be in GCC. get the density count ration
-            checkFloatLimits ( & cr );
-            density = 1/Bd * log ( Ad / (cr + Cd ) ) ; // density calculation without offset
-            density = density - ( moisture/20); // density without offset
+            post_start  = msTimer;  // results first, EEPROM, SD and BLE work is queued behind them
+            post_jobs   = 0;
+            post_errors = 0;
+            post_shown  = 0;
+            post_beeping = FALSE;
+            post_result_up = FALSE;
+            memset ( &post_timing, 0, sizeof(post_timing) );
+            if ( !Spec_flags.recall_flag ) {
+                post_date  = date_time_g;
+                post_depth = depth_setting;
+                post_jobs |= POST_JOB_NV;
+            }
+            profBegin ( PROF_CALC );
+            calcMoistureDensity ( density_cnt, moisture_cnt, &consts, &result );
+            profEnd ( PROF_CALC );
+            mcr           = result.mcr;
+            cr            = result.cr;
+            density       = result.density;
+            moisture      = result.moisture;
+            dry_dens      = result.dry_dens;
+            moist_percent = result.moist_percent;
+            pr_temp       = result.pr_percent;
             if ( Features.dummy_mode == TRUE ) {
                 CLEAR_DISP;  //                density = 2.0;
                 LCD_PrintAtPosition ( "DEMO MODE", LINE3 ); //LCD_position( LINE1); _LCD_PRINT ("DEMO MODE" );
@@ -329,33 +909,9 @@ uint8_t measureMoistureDensity(void)
                     output_low(BUZZER); delay_ms ( 100 );
                 }
             }
-            checkFloatLimits ( & density );
-            density /= GCC_TO_KG;  // density in KGM3 // All offsets are stored in Kg/M3 units. So, change GCC units to KG/M3
-            moisture /= GCC_TO_KG; // density in KGM3
-            if ( Offsets.den_offset_pos ) { // density calculation with density offset. Offset should be stored in kg
-                density +=  NV_RAM_MEMBER_RD(D_OFFSET);
-            }
-            dry_dens = density - moisture; // %Moisture and Dry Density Calculations without K offset DD calculation without K offset
-            moist_percent = (moisture / dry_dens) * 100; //Moist percent calculation without K offset
-            if ( Offsets.moist_offset_pos ) 
-            { // %Moisture and Dry Density Calculations with K offset This requires a new Bm value found from K
-                // K = 1000 x ( %Mtrue - %Mgauge ) / ( %Mgauge + 100 )
-                // %Mtrue = ( K x (%Mgauge + 100 ) / 1000 ) + %Mgauge
-                // %M = (moisture * 100) / ( density - moisture )
-                // moisture = (%M * density)/(100 + %M)
-                Mg = moist_percent;
-                Mt = (( NV_RAM_MEMBER_RD(K_VALUE) * ( Mg + 100 ) ) / 1000.0) + Mg;
-                moisture = (Mt * density)/(100 + Mt); // recalulate moisture using new %Mt
-                dry_dens = density - moisture;                               // DD calculation
-                moist_percent = (moisture / dry_dens) * 100.0;   //
-            }
             pr = NV_RAM_MEMBER_RD(PROCTOR);
-            pr_temp = (dry_dens /NV_RAM_MEMBER_RD(PROCTOR)) * 100;  //calculate %PR
             checkFloatLimits ( & pr );  // check to see if values are valid numbers
             checkFloatLimits ( & ma );
-            checkFloatLimits ( & dry_dens );
-            checkFloatLimits ( & moist_percent );
-            checkFloatLimits ( & pr_temp );
             soil_sg = NV_RAM_MEMBER_RD ( SOIL_GRAVITY ); // get value in KGM3
             soil_air_voids = 100 * ( 1 - (dry_dens/soil_sg) - moisture/1000 ); // dry dens and moisture are in KG/M3, so convert to GCC.
             LCD_light_timer(15);                // 15 seconds
@@ -367,7 +923,9 @@ uint8_t measureMoistureDensity(void)
                 if ( Features.sound_on ) 
                 { 
                   output_high(BUZZER); 
-                } //beep at end of test, use delay to store station data in secret
+                  post_beep_end = msTimer + POST_BEEP_MS;
+                  post_beeping  = TRUE;
+                } //beep at end of test, the queued jobs wait for the beep to end
                 station_d.depth           = depth_setting; // Put the measurement data into a struct for auto or manual storage
                 station_d.density_count   = density_cnt;
                 station_d.moisture_count  = moisture_cnt;
@@ -379,70 +937,27 @@ uint8_t measureMoistureDensity(void)
                 station_d.MA              = ma;
                 station_d.MCR             = mcr;
                 station_d.date            = date_time_g;
+                station_d.count_time      = last_count_ms / 1000.0;
+                station_d.count_rse       = last_count_rse;
+                station_d.count_quality   = last_count_quality;
+                station_d.sweep_id        = 0;
                 station_d.battery_voltage[0] =  readBatteryVoltage(NICAD) ;
                 station_d.battery_voltage[1] =  readBatteryVoltage(ALK) ;
                 x = sizeof(GPSDATA); // need to store the GPS reading for recall and project storage
                 if(!Spec_flags.recall_flag) 
                 { // Get GPS data If GPS is enabled and a fix is found, get the GPS reading
-                    clearGPSData(); // Get rid of existing GPS readings
-                    if (  Features.gps_on == TRUE ) 
-                    {
-                        if ( gps_fix == '1' )
-                        {
-                            Global_ID();
-                            parseGPSString();
-                            Global_IE();
-                        }
-                        else 
-                        {
-                            CyDelay( 1100 ); // The GPS data comes in at 1PPS
-                            if ( gps_fix == '1' )
-                            {
-                                Global_ID();
-                                parseGPSString();
-                                Global_IE();
-                            }
-                        }
-                    }
-                    memcpy ( &station_d.gps_read, &gdata , x );
-                    memcpy ( &eepromData.LAST_GPS_READING,  &gdata , x );
-                    SavePartialEepromData((uint8*)&eepromData.LAST_GPS_READING, x, offsetof( EEPROM_DATA_t,LAST_GPS_READING)) ;
+                    profBegin ( PROF_GPS );
+                    takeGPSFix ( &station_d );
+                    memcpy ( &eepromData.LAST_GPS_READING, &station_d.gps_read, x );  // saved by POST_JOB_NV
+                    profEnd ( PROF_GPS );
                 }
                 else 
                 { // recall last GPS reading
                     memcpy(station_d.name,project_info.current_station_name,PROJ_NAME_LENGTH);
                     memcpy ( &station_d.gps_read, &eepromData.LAST_GPS_READING , x );
+                    station_d.gps_age = GPS_AGE_NONE;
                 }
-                station_d.kk_value        = 0.0; // clear all offset values.
-                station_d.bottom_den      = 0.0;
-                station_d.den_off         = 0.0;
-                station_d.k_value         = 0.0;
-                station_d.t_offset        = 0;
-                if ( Offsets.den_offset_pos )
-                { // set the offset mask for the station         /*/*/          station_d.offset_mask = 0;
-                    station_d.offset_mask     |= DENSITY_OFFSET_BIT;
-                    station_d.den_off = NV_RAM_MEMBER_RD(D_OFFSET);
-                }
-                if ( Offsets.moist_offset_pos ) 
-                {
-                    station_d.offset_mask     |= MOISTURE_OFFSET_BIT;
-                    station_d.k_value  = NV_RAM_MEMBER_RD ( K_VALUE );
-                }
-                if ( Offsets.tren_offset_pos ) 
-                {
-                    station_d.offset_mask     |= TRENCH_OFFSET_BIT;
-                    station_d.t_offset        = NV_RAM_MEMBER_RD ( T_OFFSET );
-                }
-                if ( Features.SI_units == FALSE )
-                { station_d.units           = PCF;
-                }
-                else if ( Features.kg_gcc_units == GCC_UNITS ) 
-                { station_d.units           = GM_CC; 
-                }
-                else 
-                { 
-                  station_d.units          = KG_M3; 
-                }
+                setStationOffsets ( &station_d );
                 if ( Spec_flags.nomograph_flag && (depth_setting == 1) )
                 {  // Thin Layer Mode only valid in BS// SAFE = 0;  BSCATTER=1; AC = 13; 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 ,12
                     KK = NV_RAM_MEMBER_RD(KK_VALUE);        // read value from eeprom
@@ -460,11 +975,10 @@ uint8_t measureMoistureDensity(void)
                 if (( Features.auto_store_on ) && ( Spec_flags.recall_flag == FALSE ))
                 { // store the data
                     strcpy ( station_d.name, project_info.current_station_name );
-                    writeStation ( project_info.current_project, project_info.station_index, &station_d );
-                    incrementStationNumber ( project_info.current_project );            //increment number of stations within project
-                    project_info.station_index     = getStationNumber ( project_info.current_project );
+                    post_store_d = station_d;
+                    post_jobs |= POST_JOB_STORE;
                 }
-                SendBLEDataCC ();
+                post_jobs |= POST_JOB_BLE_CC;
                 station_d.den_off = NV_RAM_MEMBER_RD(D_OFFSET);
                 station_d.k_value  = NV_RAM_MEMBER_RD ( K_VALUE );
                 station_d.t_offset        =  NV_RAM_MEMBER_RD ( T_OFFSET );
@@ -477,11 +991,21 @@ uint8_t measureMoistureDensity(void)
                   station_d.offset_mask |= TR_GAUGE_BIT;
                 }           // If 3440 set gauge type bit
                
-                SendBLEData ( &station_d, (bool)Spec_flags.recall_flag );
-                CyDelay ( 800 );  // added longer delay for beeper (2-14-2022)
-                output_low(BUZZER);
+                post_ble_d  = station_d;
+                post_recall = Spec_flags.recall_flag;
+                post_jobs |= POST_JOB_BLE;
             }
             checkFloatLimits ( & dt );
+            if ( !Spec_flags.self_test && !Spec_flags.recall_flag && station_d.count_quality )
+            {   // suspect counts, make sure it is seen before the results
+                CLEAR_DISP;
+                LCD_PrintAtPositionCentered ( "CHECK COUNTS", LINE1 + 10 );
+                pulseQualityText ( station_d.count_quality, buff );
+                LCD_PrintAtPosition ( buff, LINE3 );
+                pulseBuzzer();
+                getNewKey ( 2000 );
+            }
+            profBegin ( PROF_DISPLAY );
             wait_time = 0;  // Display data // loop in this routine for 15 minutes
             while(1) 
             {                      //display data until button is pressed to exit
@@ -580,7 +1104,15 @@ uint8_t measureMoistureDensity(void)
                   break;
             case 0:
                   LCD_position(LINE1);
-                  printTimeDate ( date_time ) ;
+                  if ( !Spec_flags.self_test && !Spec_flags.recall_flag && station_d.count_quality )
+                  {
+                    pulseQualityText ( station_d.count_quality, buff );
+                    LCD_PrintAtPosition ( buff, LINE1 );
+                  }
+                  else
+                  {
+                    printTimeDate ( date_time ) ;
+                  }
                   LCD_position (LINE2);
                   display_depth(1,depth_setting);
                   LCD_position (LINE3);
@@ -596,14 +1128,12 @@ uint8_t measureMoistureDensity(void)
                   }
                   break;
           }                // end of "Switch"
-          LCD_position(LINE4);
-          if(Features.language_f)
-          {
-           _LCD_PRINT("    PRESS UP/DOWN   ");
-          }
-          else
+          showPostStatus();  // key prompt, or the queued job status
+          if ( !post_result_up )
           {
-            _LCD_PRINT ("Arriba/Abajo       ");
+            post_timing.result_ms = msTimer - post_start;
+            post_result_up = TRUE;
+            profEnd ( PROF_DISPLAY );
           }
           auto_scroll_advance = FALSE;
           if(Features.auto_scroll)
@@ -611,6 +1141,7 @@ uint8_t measureMoistureDensity(void)
             loop_cnt = 0;
             while(1)
             {
+             servicePostJobs();
              button = getKey(50);
               if ( ++wait_time > WAIT_TIME_BEFORE_BREAK )
               {
@@ -635,6 +1166,7 @@ uint8_t measureMoistureDensity(void)
           {
             while(1)
             {
+              servicePostJobs();
               #if AUTO_TEST
                 button = getKey(50);
                 if(button != ESC)
@@ -686,6 +1218,7 @@ uint8_t measureMoistureDensity(void)
             }
             else
             {
+             finishPostJobs();
              storeStationData ( project_info.current_project, station_d  );
             }
           }
@@ -694,6 +1227,12 @@ uint8_t measureMoistureDensity(void)
             break;
           }
         }
+        finishPostJobs();
+        if ( !Spec_flags.recall_flag )
+        {
+          profSetInfo ( date_time_g, depth_setting );
+          profCommit();
+        }
       } // end of if(a >= 0.00001 && d_standard > 0)
       else {
         if ( d_stand <= 0)
@@ -724,6 +1263,594 @@ uint8_t measureMoistureDensity(void)
     NV_MEMBER_STORE(GP_DISPLAY,gp_disp);
     return 1;
 }
+/******************************************************************************
+ *
+ *  Name: fillStation ( )
+ *
+ *  PARAMETERS: station to fill, depth, counts on the 3.75s basis, constants
+ *              and result of the reading, special cal in use, count time,
+ *              relative std. error and PQ_xxx count quality
+ *
+ *  DESCRIPTION: Builds the station record of a rolling or sweep reading.
+ *               The name is left empty.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+static void fillStation ( station_data_t * station_d, uint8_t depth, uint32_t density_cnt, uint16_t moisture_cnt,
+                          const meas_consts_t * k, const meas_result_t * r, uint8_t spec_cal, uint32_t ms, float rse, uint8_t quality )
+{
+    memset ( station_d, 0, sizeof(station_data_t) );
+    read_RTC( &date_time_g );
+    station_d->depth           = depth;
+    station_d->density_count   = density_cnt;
+    station_d->moisture_count  = moisture_cnt;
+    station_d->density         = r->density;
+    station_d->moisture        = r->moisture;
+    station_d->density_stand   = k->d_stand;
+    station_d->moisture_stand  = k->m_stand;
+    station_d->PR              = NV_RAM_MEMBER_RD(PROCTOR);
+    station_d->MA              = NV_RAM_MEMBER_RD(MARSHALL);
+    station_d->MCR             = r->mcr;
+    station_d->date            = date_time_g;
+    station_d->count_time      = ms / 1000.0;
+    station_d->count_rse       = rse;
+    station_d->count_quality   = quality;
+    station_d->battery_voltage[0] = readBatteryVoltage(NICAD);
+    station_d->battery_voltage[1] = readBatteryVoltage(ALK);
+    takeGPSFix ( station_d );
+    station_d->offset_mask     = spec_cal ? SPECIAL_CAL_BIT : 0;
+    setStationOffsets ( station_d );
+    if ((eepromData.gauge_type  == GAUGE_3440  ) ||(eepromData.gauge_type  == GAUGE_3440_PLUS  ))
+    { 
+      station_d->offset_mask |= TR_GAUGE_BIT;
+    }
+}
+/******************************************************************************
+ *
+ *  Name: storeRollingStation ( station_data_t * station_d )
+ *
+ *  PARAMETERS: station to store
+ *
+ *  DESCRIPTION: Stores a rolling mode reading in the current project. With
+ *               auto store and auto numbering on the station is written
+ *               straight away, otherwise the operator names it.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+static void storeRollingStation ( station_data_t * station_d )
+{
+    SDstart();                        // given back by SDstop on every way out
+    updateProjectInfo();
+    if ( SD_CheckIfProjExists ( project_info.current_project ) == FALSE ) 
+    {
+        no_project_selected();  //display "No Project Has Been\nSelected. Please\nCreate or Select\nProject."
+        SDstop(null);
+        delay_ms(1500);
+        return;
+    }
+    if ( !Features.auto_store_on || !Flags.auto_number_stations )
+    {
+        storeStationData ( project_info.current_project, *station_d );
+        SDstop(null);
+        return;
+    }
+    if ( !projectHasRoom ( project_info.current_project ) ) 
+    {
+        max_stations_text( project_info.current_project );
+        SDstop(null);
+        delay_ms(1500);
+        return;
+    }
+    itoa ( project_info.station_index + project_info.station_start, project_info.current_station_name, 10 );
+    strcpy ( station_d->name, project_info.current_station_name );
+    if ( ( writeStation ( project_info.current_project, project_info.station_index, station_d ) == 0 ) ||
+         ( incrementStationNumber ( project_info.current_project ) == 0 ) )
+    {
+        storeErrorText ( );
+        SDstop(null);
+        delay_ms(1500);
+        return;
+    }
+    project_info.station_index = getStationNumber ( project_info.current_project );
+    SDstop(null);
+    
+    CLEAR_DISP;
+    LCD_position(LINE2);
+    display_station_name(station_d->name);
+    LCD_PrintAtPosition ( "Stored", LINE3 );
+    delay_ms(800);
+}
+/******************************************************************************
+ *
+ *  Name: measureRolling ( void )
+ *
+ *  PARAMETERS: NA
+ *
+ *  DESCRIPTION: Continuous reading for compaction monitoring. The counters
+ *               run back to back and WD, DD and %PR are recalculated every
+ *               second from the last 15s of pulse bins. ENTER stores the
+ *               current reading as a station, ESC exits.
+ *
+ *  RETURNS: 0 if no reading could be started
+ *
+ *****************************************************************************/
+uint8_t measureRolling ( void )
+{
+    static pulse_bin_t window[ROLLING_WINDOW_BINS];
+    static pulse_bin_t fresh[ROLLING_WINDOW_BINS];
+    uint16_t w_head = 0, w_count = 0, seen = 0, n, i;
+    uint32_t gm = 0, he3 = 0, ms = 0, next_update, density_cnt = 0;
+    uint16_t moisture_cnt = 0;
+    uint8_t  spec_cal, have_reading = FALSE, secs;
+    BOOL     temp_auto_turn_off = Spec_flags.auto_turn_off;
+    meas_consts_t consts;
+    meas_result_t result;
+    station_data_t station_d;
+    enum buttons button;
+    char temp_str[30];
+
+    if(Features.auto_depth)
+    { 
+      tst_depth_g = get_depth_auto( 0 ); 
+    }
+    else 
+    {
+      set_depth_manual();
+      if ( ESC == getLastKey() )
+      { 
+        return 0; 
+      }
+    }
+    depth_setting = tst_depth_g;
+    if ( (depth_setting == 0) || (depth_setting >= 13) || !(bit_test(valid_depth, depth_setting )) ) 
+    {
+      display_invalid_depth(depth_setting);
+      delay_ms(1500);
+      return 0;
+    }
+    spec_cal = loadMeasConsts ( depth_setting, &consts );
+    if ( (consts.d_stand == 0) || (consts.m_stand == 0) )
+    {
+      invalid_std_or_const();
+      delay_ms(2000);
+      return 0;
+    }
+    
+    Spec_flags.auto_turn_off = FALSE;   // no idle shut down while monitoring
+    GM_TUBE_ENABLE();
+    CLEAR_DISP;
+    LCD_PrintAtPosition ( "ENTER=Store ESC=Exit", LINE4 );
+    wait_for_key_release();
+    
+    resetPulseTimers ( );
+    PulseCntStrt ( ROLLING_SEGMENT_SEC );
+    next_update = msTimer + 1000;
+    
+    while ( 1 )
+    {
+      CyDelay ( 50 );
+      
+      // segment finished, the one shot ISR has closed its last bin
+      pulseQualityUpdate();
+      if ( checkCountDone() == TRUE )
+      {
+        n = readNewPulseBins ( &seen, fresh, ROLLING_WINDOW_BINS );
+        PulseCntStrt ( ROLLING_SEGMENT_SEC );
+        seen = 0;
+      }
+      else
+      {
+        n = readNewPulseBins ( &seen, fresh, ROLLING_WINDOW_BINS );
+      }
+      for ( i = 0; i < n; i++ )
+      {
+        window[w_head] = fresh[i];
+        w_head = ( w_head + 1 ) % ROLLING_WINDOW_BINS;
+        if ( w_count < ROLLING_WINDOW_BINS )
+        {
+          w_count++;
+        }
+      }
+      
+      if ( msTimer >= next_update )
+      {
+        next_update = msTimer + 1000;
+        gm = he3 = ms = 0;
+        for ( i = 0; i < w_count; i++ )
+        {
+          gm  += window[i].gm;
+          he3 += window[i].he3;
+          ms  += window[i].ms;
+        }
+        if ( ms >= ROLLING_MIN_MS )
+        { // normalize to the 3.75s basis the standards use
+          density_cnt  = (uint32_t)( ((float)deadTimeCorrect ( gm,  ms, PROBE_GM_COUNT )  * 3750.0) / ms );
+          moisture_cnt = (uint16_t)( ((float)deadTimeCorrect ( he3, ms, PROBE_HE3_COUNT ) * 3750.0) / ms );
+          calcMoistureDensity ( density_cnt, moisture_cnt, &consts, &result );
+          have_reading = TRUE;
+          
+          LCD_position(LINE1);
+          count_text(5);  //TEXT// display "    WD:"
+          displayValueWithUnitsBW ( result.density, LINE1 + 19, temp_str );
+          LCD_position(LINE2);
+          count_text(10);  //TEXT// display "    DD:"
+          displayValueWithUnitsBW ( result.dry_dens, LINE2 + 19, temp_str );
+          secs = ( ms < 99000 ) ? ms / 1000 : 99;    // the window holds 15s
+          snprintf ( temp_str, 21, "%%PR:%5.1f   %2us  ", (double)result.pr_percent, (unsigned)secs );
+          LCD_PrintAtPosition ( temp_str, LINE3 );
+        }
+        else
+        {
+          LCD_PrintAtPosition ( "Reading...", LINE1 );
+        }
+      }
+      
+      button = getLastKey();
+      if ( button == ESC )
+      {
+        break;
+      }
+      if ( ( button == ENTER ) && have_reading )
+      {
+        stop_ONE_SHOT_Early();
+        fillStation ( &station_d, depth_setting, density_cnt, moisture_cnt, &consts, &result, spec_cal, ms, getCountRSE ( gm, he3 ), getPulseQuality ( ) );
+        storeRollingStation ( &station_d );
+        
+        // start a fresh window after storing
+        CLEAR_DISP;
+        LCD_PrintAtPosition ( "ENTER=Store ESC=Exit", LINE4 );
+        w_head = w_count = 0;
+        have_reading = FALSE;
+        resetPulseTimers ( );
+        PulseCntStrt ( ROLLING_SEGMENT_SEC );
+        seen = 0;
+        next_update = msTimer + 1000;
+      }
+      if ( button != DFLT )
+      {
+        wait_for_key_release();
+      }
+    }
+    
+    stop_ONE_SHOT_Early();
+    wait_for_key_release();
+    Spec_flags.auto_turn_off = temp_auto_turn_off;
+    shutdown_timer = 0;
+    return 1;
+}
+/******************************************************************************
+ *
+ *  Name: showSweepSummary ( )
+ *
+ *  PARAMETERS: depths, wet and dry densities of the sweep, number of depths
+ *
+ *  DESCRIPTION: Density versus depth, three depths a page. UP/DOWN pages,
+ *               ESC or ENTER leaves.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+static void showSweepSummary ( const uint8_t * depth, const float * wd, const float * dd, uint8_t n )
+{
+    uint8_t first = 0, i, line;
+    enum buttons button;
+    char temp_str[21];
+    
+    while ( 1 )
+    {
+        CLEAR_DISP;
+        LCD_PrintAtPosition ( "Depth    WD      DD", LINE1 );
+        for ( i = first, line = LINE2; ( i < n ) && ( i < first + 3 ); i++ )
+        {
+            if ( depth[i] == 1 )
+            {
+                snprintf ( temp_str, 21, "BS" );
+            }
+            else if ( Features.SI_units )
+            {
+                snprintf ( temp_str, 21, "%umm", depth[i] * 25 );
+            }
+            else
+            {
+                snprintf ( temp_str, 21, "%uin", depth[i] );
+            }
+            LCD_PrintAtPosition ( temp_str, line );
+            snprintf ( temp_str, 21, "%6.1f  %6.1f", (double)convertKgM3DensityToUnitDensity ( wd[i], Features.SI_units ? KG_M3 : PCF ),
+                                                       (double)convertKgM3DensityToUnitDensity ( dd[i], Features.SI_units ? KG_M3 : PCF ) );
+            LCD_PrintAtPosition ( temp_str, line + 6 );
+            line = ( line == LINE2 ) ? LINE3 : LINE4;
+        }
+        button = getKey ( TIME_DELAY_MAX );
+        if ( ( button == ESC ) || ( button == ENTER ) )
+        {
+            break;
+        }
+        else if ( ( button == DOWN ) && ( first + 3 < n ) )
+        {
+            first += 3;
+        }
+        else if ( ( button == UP ) && ( first >= 3 ) )
+        {
+            first -= 3;
+        }
+    }
+}
+/******************************************************************************
+ *
+ *  Name: measureSweep ( void )
+ *
+ *  PARAMETERS: NA
+ *
+ *  DESCRIPTION: Multi-depth profile of one station. With auto depth on, a
+ *               count starts by itself once the rod has rested for
+ *               SWEEP_SETTLE_MS at a valid depth not yet measured. In a
+ *               journal project every depth is a record holding the station
+ *               name, its depth and the sweep_id of the sweep, 1 + the index
+ *               of its first depth, so review and export group them. A fixed
+ *               file has no sweep_id and names them <station>-<depth>. ESC
+ *               ends the sweep and shows WD and DD against depth.
+ *
+ *  RETURNS: number of depths stored
+ *
+ *****************************************************************************/
+uint8_t measureSweep ( void )
+{
+    uint8_t  depth, cand = 0xFF, n = 0, i, j, spec_cal, lcd_line;
+    uint8_t  dep[MAX_DEPTHS];
+    float    wd[MAX_DEPTHS], dd[MAX_DEPTHS], f_temp;
+    uint16_t done_mask = 0, moisture_cnt, sweep_id = 0, shown = SWEEP_SHOW_NONE, show;
+    BOOL     tagged;
+    uint32_t cand_ms = 0, density_cnt;
+    BOOL     temp_auto_turn_off = Spec_flags.auto_turn_off;
+    char     base[PROJ_NAME_LENGTH] = NULL_NAME_STRING;
+    meas_consts_t  consts;
+    meas_result_t  result;
+    station_data_t station_d;
+    enum buttons button;
+    
+    if ( !Features.auto_depth )
+    {
+        CLEAR_DISP;
+        LCD_PrintAtPositionCentered ( "Sweep Needs", LINE2 + 10 );
+        LCD_PrintAtPositionCentered ( "Auto Depth", LINE3 + 10 );
+        delay_ms ( 1500 );
+        return 0;
+    }
+    SDstart();                        // given back by SDstop on every way out
+    updateProjectInfo();
+    if ( SD_CheckIfProjExists ( project_info.current_project ) == FALSE ) 
+    {
+        no_project_selected();  //display "No Project Has Been\nSelected. Please\nCreate or Select\nProject."
+        delay_ms(1500);
+        SDstop(null);
+        return 0;
+    }
+    if ( Flags.auto_number_stations )
+    {
+        itoa ( project_info.station_index + project_info.station_start, base, 10 );
+    }
+    else
+    {
+        enter_station_name_text();  //TEXT// display "Enter Station\nName:" LINE1,2
+        YES_to_Accept(LINE3);
+        ESC_to_Exit(LINE4);
+        lcd_line = (Features.language_f) ? LINE2+6 : LINE2+10;
+        enter_name ( base, lcd_line );
+        if ( getLastKey() == ESC )
+        {
+            SDstop(null);
+            return 0;
+        }
+    }
+    tagged = ( getProjectFormat ( project_info.current_project ) == PROJ_FORMAT_LOG );
+    if ( !tagged )
+    {
+        base[PROJ_NAME_LENGTH - 4] = '\0';  // room for "-12"
+    }
+    cnt_time = NV_RAM_MEMBER_RD( COUNT_TIME );
+    Spec_flags.auto_turn_off = FALSE;   // no idle shut down between depths
+    wait_for_key_release();
+    
+    while ( 1 )
+    {
+        depth = get_depth_auto ( 0 );
+        if ( depth != cand )
+        {
+            cand    = depth;
+            cand_ms = msTimer;
+        }
+        if ( ( depth == 0 ) || ( depth >= 13 ) || !bit_test ( valid_depth, depth ) || ( done_mask & ( 1 << depth ) ) )
+        {
+            show = ( SWEEP_SHOW_MOVE << 8 ) | depth;
+        }
+        else if ( msTimer - cand_ms < SWEEP_SETTLE_MS )
+        {
+            show = ( SWEEP_SHOW_SETTLE << 8 ) | depth;
+        }
+        else if ( !projectHasRoom ( project_info.current_project ) )
+        {
+            max_stations_text( project_info.current_project );
+            delay_ms(1500);
+            break;
+        }
+        else
+        {   // rod has rested at a new depth, count it
+            tst_depth_g = depth_setting = depth;
+            spec_cal = loadMeasConsts ( depth, &consts );
+            if ( (consts.d_stand == 0) || (consts.m_stand == 0) )
+            {
+                invalid_std_or_const();
+                delay_ms(2000);
+                break;
+            }
+            if ( tagged )
+            {
+                strcpy ( project_info.current_station_name, base );
+            }
+            else
+            {
+                snprintf ( project_info.current_station_name, PROJ_NAME_LENGTH, "%s-%u", base, depth );
+            }
+            density_cnt  = 0;
+            moisture_cnt = 0;
+            CLEAR_DISP;
+            measurePulses ( LINE4, cnt_time, &moisture_cnt, &density_cnt, depth );
+            if ( getLastKey() == ESC )
+            {
+                break;
+            }
+            shown = SWEEP_SHOW_NONE;
+            if ( getLastKey() == ENTER )
+            {   // count restarted by the operator, settle again
+                cand = 0xFF;
+                continue;
+            }
+            calcMoistureDensity ( density_cnt, moisture_cnt, &consts, &result );
+            fillStation ( &station_d, depth, density_cnt, moisture_cnt, &consts, &result, spec_cal, last_count_ms, last_count_rse, last_count_quality );
+            strcpy ( station_d.name, project_info.current_station_name );
+            if ( tagged && ( sweep_id == 0 ) )
+            {
+                sweep_id = project_info.station_index + 1;
+            }
+            station_d.sweep_id = sweep_id;
+            CLEAR_DISP;
+            if ( writeStation ( project_info.current_project, project_info.station_index, &station_d ) &&
+                 incrementStationNumber ( project_info.current_project ) )
+            {
+                project_info.station_index = getStationNumber ( project_info.current_project );
+                dep[n] = depth;
+                wd[n]  = result.density;
+                dd[n]  = result.dry_dens;
+                n++;
+                done_mask |= ( 1 << depth );
+                LCD_position(LINE2);
+                display_station_name(station_d.name);
+                LCD_PrintAtPosition ( "Stored", LINE3 );
+            }
+            else
+            {
+                storeErrorText ( );
+            }
+            if ( Features.sound_on )
+            {
+                hold_buzzer();
+            }
+            delay_ms(800);
+            cand = 0xFF;
+            continue;
+        }
+        if ( show != shown )
+        {
+            shown = show;
+            CLEAR_DISP;
+            LCD_PrintAtPosition ( "Depth Sweep", LINE1 );
+            LCD_position ( LINE2 );
+            display_depth ( 0, depth );
+            if ( ( show >> 8 ) == SWEEP_SHOW_MOVE )
+            {
+                snprintf ( lcdstr, 21, "%u Done, Move Rod", n );
+                LCD_PrintAtPosition ( lcdstr, LINE3 );
+            }
+            else
+            {
+                LCD_PrintAtPosition ( "Settling", LINE3 );
+            }
+            LCD_PrintAtPosition ( "ESC=End Sweep", LINE4 );
+        }
+        button = getKey ( SWEEP_POLL_MS );
+        if ( button == ESC )
+        {
+            break;
+        }
+    }
+    
+    wait_for_key_release();
+    SDstop(null);
+    Spec_flags.auto_turn_off = temp_auto_turn_off;
+    shutdown_timer = 0;
+    if ( n > 0 )
+    {   // sort by depth, the rod may have been moved either way
+        for ( i = 1; i < n; i++ )
+        {
+            for ( j = i; ( j > 0 ) && ( dep[j - 1] > dep[j] ); j-- )
+            {
+                depth = dep[j]; dep[j] = dep[j - 1]; dep[j - 1] = depth;
+                f_temp = wd[j]; wd[j]  = wd[j - 1];  wd[j - 1] = f_temp;
+                f_temp = dd[j]; dd[j]  = dd[j - 1];  dd[j - 1] = f_temp;
+            }
+        }
+        showSweepSummary ( dep, wd, dd, n );
+    }
+    return n;
+}
+/******************************************************************************
+ *
+ *  Name: checkAutoStart ( uint8_t depth )
+ *
+ *  PARAMETERS: depth from the main loop's auto depth poll
+ *
+ *  DESCRIPTION: Called once per depth poll while the gauge is idle. The
+ *               rod is armed at SAFE. Once it has been held at one valid
+ *               depth for AUTO_START_STABLE_POLLS polls a beeping countdown
+ *               runs on LINE4. A key or a depth change cancels it; a key
+ *               also disarms until the rod is back at SAFE so the keypad
+ *               can be used at that depth. One count per trip out of SAFE.
+ *
+ *  RETURNS: TRUE when the count should start now
+ *
+ *****************************************************************************/
+uint8_t checkAutoStart ( uint8_t depth )
+{
+    static uint8_t armed = FALSE, cand = 0xFF, polls = 0;
+    uint8_t n;
+    
+    if ( depth == 0 )
+    {
+        armed = TRUE;
+        cand  = 0xFF;
+        return FALSE;
+    }
+    if ( !armed || ( depth >= 13 ) || !bit_test ( valid_depth, depth ) )
+    {
+        cand = 0xFF;
+        return FALSE;
+    }
+    if ( depth != cand )
+    {
+        cand  = depth;
+        polls = 0;
+    }
+    if ( ++polls < AUTO_START_STABLE_POLLS )
+    {
+        return FALSE;
+    }
+    
+    for ( n = AUTO_START_COUNTDOWN_S; n > 0; n-- )
+    {
+        sprintf ( lcdstr, "Auto Start in %u  ", n );
+        LCD_PrintAtPosition ( lcdstr, LINE4 );
+        pulseBuzzer();
+        if ( getNewKey ( 1000 ) != DFLT )
+        {
+            armed = FALSE;
+            break;
+        }
+        if ( get_depth_auto ( LINE2 ) != depth )
+        {
+            break;
+        }
+    }
+    LCD_PrintAtPosition ( "Press START to Test", LINE4 );
+    cand = 0xFF;
+    if ( n > 0 )
+    {
+        return FALSE;
+    }
+    armed = FALSE;
+    return TRUE;
+}
 /******************************************************************************
  *
  *  Name: placeGaugeinBS (void)
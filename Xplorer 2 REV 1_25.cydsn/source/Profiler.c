@@ -0,0 +1,381 @@
+/**********************************************************************************************************************/
+//
+// Title:       Elite
+// Company:     Instrotek
+//
+// Document No.:
+// Issue:
+// Description: Reading phase profiler. Each phase of a reading is timed
+//              with msTimer and the readings are kept in a ring file on
+//              the SD card, for the diagnostics menu and USB export.
+//
+// Filename:    Profiler.c
+// Author:
+//
+//
+//
+// History: date, version, personal initials with comments about any changes
+//
+/**********************************************************************************************************************/
+/*********************************************  INCLUDE FILES  ***************************************************/
+#include "project.h"
+#include "Globals.h"
+#include "Utilities.h"
+#include "prompts.h"
+#include "Keypad_functions.h"
+#include "LCD_drivers.h"
+#include "SDcard.h"
+#include "Alfat.h"
+#include "Profiler.h"
+
+/************************************************  LOCAL DEFINITIONS  *************************************************/
+#define PROF_MAGIC        0x5052        // "PR", marks an initialized ring file
+
+/* Ring file header, the records follow it */
+typedef struct
+{
+  uint16 magic;
+  uint16 head;                          // next record slot to write
+  uint16 count;                         // records in the file
+} prof_header_t;
+
+/*****************************************  VARIABLE AND BUFFER DECLARATIONS  *****************************************/
+const char * const prof_phase_names[PROF_PHASES] =
+{
+  "Depth", "Project", "RTC", "Count", "Calc", "GPS", "EEPROM", "SD", "BLE", "Display"
+};
+
+static prof_record_t prof_rec;          // reading being timed
+static uint32 prof_start;               // msTimer at profStart
+static uint32 prof_begin[PROF_PHASES];  // msTimer at profBegin of each phase
+static BOOL   prof_active = FALSE;
+
+/******************************************************************************
+ *
+ *  Name: profStart ( ), profBegin ( ), profEnd ( ), profAdd ( ), profSetInfo ( )
+ *
+ *  PARAMETERS: phase, ms already measured by the caller
+ *
+ *  DESCRIPTION: profStart clears the record for a new reading. A phase is
+ *               timed from profBegin to profEnd, or the caller adds a time
+ *               it measured itself with profAdd, and a phase that runs more
+ *               than once in a reading adds up. Nothing is timed until
+ *               profStart is called.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+void profStart ( void )
+{
+  memset ( &prof_rec, 0, sizeof(prof_rec) );
+  prof_start  = msTimer;
+  prof_active = TRUE;
+}
+
+void profBegin ( prof_phase_t phase )
+{
+  prof_begin[phase] = msTimer;
+}
+
+void profEnd ( prof_phase_t phase )
+{
+  if ( prof_active )
+  {
+    prof_rec.ms[phase] += msTimer - prof_begin[phase];
+  }
+}
+
+void profAdd ( prof_phase_t phase, uint32 ms )
+{
+  if ( prof_active )
+  {
+    prof_rec.ms[phase] += ms;
+  }
+}
+
+void profSetInfo ( date_time_t date, uint8 depth )
+{
+  prof_rec.date  = date;
+  prof_rec.depth = depth;
+}
+
+/******************************************************************************
+ *
+ *  Name: profOpen ( )
+ *
+ *  PARAMETERS: header read from the file
+ *
+ *  DESCRIPTION: Opens the ring file, making a new one if it is missing or
+ *               was not written by the profiler. SD must be started.
+ *
+ *  RETURNS: file, null on error
+ *
+ *****************************************************************************/
+static FS_FILE * profOpen ( prof_header_t * hdr )
+{
+  FS_FILE * file;
+  
+  file = FS_FOpen ( PROF_FILE, "r+" );
+  if ( file != null )
+  {
+    if ( ( FS_Read ( file, hdr, sizeof(prof_header_t) ) == sizeof(prof_header_t) ) && ( hdr->magic == PROF_MAGIC ) )
+    {
+      return file;
+    }
+    FS_FClose ( file );
+  }
+  file = FS_FOpen ( PROF_FILE, "wb+" );
+  if ( file != null )
+  {
+    hdr->magic = PROF_MAGIC;
+    hdr->head  = 0;
+    hdr->count = 0;
+    FS_Write ( file, hdr, sizeof(prof_header_t) );
+  }
+  return file;
+}
+
+/******************************************************************************
+ *
+ *  Name: profCommit ( )
+ *
+ *  PARAMETERS: NA
+ *
+ *  DESCRIPTION: Closes the reading and writes it over the oldest record of
+ *               the SD ring file.
+ *
+ *  RETURNS: 1 if written, 0 if nothing was timed or on an SD error
+ *
+ *****************************************************************************/
+uint8 profCommit ( void )
+{
+  FS_FILE * file;
+  prof_header_t hdr;
+  uint8 res = 0;
+  
+  if ( !prof_active )
+  {
+    return 0;
+  }
+  prof_active = FALSE;
+  prof_rec.total_ms = msTimer - prof_start;
+  
+  if ( SD_CARD_DETECT_Read() == SD_CARD_OUT )
+  {
+    return 0;
+  }
+  SDstart();
+  file = profOpen ( &hdr );
+  if ( file != null )
+  {
+    FS_FSeek ( file, sizeof(prof_header_t) + (int32)hdr.head * sizeof(prof_record_t), FS_SEEK_SET );
+    if ( FS_Write ( file, &prof_rec, sizeof(prof_record_t) ) == sizeof(prof_record_t) )
+    {
+      hdr.head = ( hdr.head + 1 ) % PROF_RING_DEPTH;
+      if ( hdr.count < PROF_RING_DEPTH )
+      {
+        hdr.count++;
+      }
+      FS_FSeek ( file, 0, FS_SEEK_SET );
+      res = ( FS_Write ( file, &hdr, sizeof(prof_header_t) ) == sizeof(prof_header_t) );
+    }
+    FS_FClose ( file );
+  }
+  SDstop ( null );
+  return res;
+}
+
+/******************************************************************************
+ *
+ *  Name: profRead ( )
+ *
+ *  PARAMETERS: age 0 is the newest reading, record to fill
+ *
+ *  DESCRIPTION: Reads one reading back from the ring file. SD must be
+ *               started.
+ *
+ *  RETURNS: number of readings in the file, 0 if there are none or on error
+ *
+ *****************************************************************************/
+uint16 profRead ( uint16 age, prof_record_t * rec )
+{
+  FS_FILE * file;
+  prof_header_t hdr;
+  uint16 slot;
+  
+  file = FS_FOpen ( PROF_FILE, "r" );
+  if ( file == null )
+  {
+    return 0;
+  }
+  if ( ( FS_Read ( file, &hdr, sizeof(prof_header_t) ) != sizeof(prof_header_t) ) || ( hdr.magic != PROF_MAGIC ) || ( age >= hdr.count ) )
+  {
+    FS_FClose ( file );
+    return 0;
+  }
+  slot = ( hdr.head + PROF_RING_DEPTH - 1 - age ) % PROF_RING_DEPTH;
+  FS_FSeek ( file, sizeof(prof_header_t) + (int32)slot * sizeof(prof_record_t), FS_SEEK_SET );
+  if ( FS_Read ( file, rec, sizeof(prof_record_t) ) != sizeof(prof_record_t) )
+  {
+    hdr.count = 0;
+  }
+  FS_FClose ( file );
+  return hdr.count;
+}
+
+/******************************************************************************
+ *
+ *  Name: profViewLog ( )
+ *
+ *  PARAMETERS: NA
+ *
+ *  DESCRIPTION: Diagnostics viewer. UP/DOWN steps through the readings,
+ *               newest first, ENTER pages through the phases, STORE exports
+ *               the log to a USB drive and ESC exits.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+void profViewLog ( void )
+{
+  prof_record_t rec;
+  uint16 age = 0, total;
+  uint8 page = 0, line, p;
+  char date_string[30];
+  enum buttons button;
+  
+  SDstart();
+  while ( 1 )
+  {
+    total = profRead ( age, &rec );
+    CLEAR_DISP;
+    if ( total == 0 )
+    {
+      LCD_PrintAtPositionCentered ( "No Timing Log", LINE2+10 );
+      delay_ms ( 1500 );
+      break;
+    }
+    line = LINE1;
+    if ( page == 0 )
+    {
+      getTimeDateStr ( rec.date, date_string );
+      LCD_position ( LINE1 );
+      _LCD_PRINTF ( "%s", date_string );
+      line = LINE2;
+    }
+    for ( p = ( page == 0 ) ? 0 : page * 4 - 1; ( p < PROF_PHASES ) && ( line <= LINE4 ); p++ )
+    {
+      sprintf ( lcdstr, "%-8s%7lu ms", prof_phase_names[p], (unsigned long)rec.ms[p] );
+      LCD_PrintAtPosition ( lcdstr, line );
+      line = ( line == LINE1 ) ? LINE2 : ( line == LINE2 ) ? LINE3 : ( line == LINE3 ) ? LINE4 : LINE4 + 1;
+    }
+    if ( ( p >= PROF_PHASES ) && ( line <= LINE4 ) )
+    {
+      sprintf ( lcdstr, "Total%10lu ms", (unsigned long)rec.total_ms );
+      LCD_PrintAtPosition ( lcdstr, line );
+    }
+    
+    button = getKey ( TIME_DELAY_MAX );
+    if ( ( button == ESC ) || ( button == MENU ) )
+    {
+      break;
+    }
+    else if ( button == DOWN )
+    {
+      age  = ( age + 1 ) % total;
+      page = 0;
+    }
+    else if ( button == UP )
+    {
+      age  = ( age + total - 1 ) % total;
+      page = 0;
+    }
+    else if ( button == ENTER )
+    {
+      page = ( page + 1 ) % 3;
+    }
+    else if ( button == STORE )
+    {
+      SDstop ( null );
+      profExportToUSB ();
+      SDstart ();
+    }
+  }
+  SDstop ( null );
+}
+
+/******************************************************************************
+ *
+ *  Name: profExportToUSB ( )
+ *
+ *  PARAMETERS: NA
+ *
+ *  DESCRIPTION: Writes the whole timing log, oldest reading first, to a
+ *               tab separated file on the USB drive.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+void profExportToUSB ( void )
+{
+  char name_string[30];
+  char date_string[30];
+  char temp_str[60];
+  FILE_PARAMETERS fp;
+  prof_record_t * rec;
+  static prof_record_t recs[PROF_RING_DEPTH];
+  uint16 total, n;
+  uint8 p;
+  
+  // read the log before the SD card is given up for the USB drive
+  SDstart();
+  total = profRead ( 0, &recs[0] );
+  for ( n = 1; n < total; n++ )
+  {
+    profRead ( n, &recs[n] );
+  }
+  SDstop ( null );
+  
+  AlfatStart();
+  isrTIMER_1_Disable();
+  
+  if ( initialize_USB( TRUE ) )
+  {
+    CLEAR_DISP;
+    LCD_PrintAtPosition( "Writing Timing Log", LINE2);
+    
+    nullString(name_string, sizeof(name_string) );
+    strcat( name_string, "TIMING_LOG" );
+    USB_open_file  ( name_string, &fp );
+    
+    nullString(temp_str, sizeof(temp_str));
+    sprintf( temp_str, "Date\tDepth" );
+    AlfatWriteStr(&fp,temp_str);
+    for ( p = 0; p < PROF_PHASES; p++ )
+    {
+      sprintf( temp_str, "\t%s", prof_phase_names[p] );
+      AlfatWriteStr(&fp,temp_str);
+    }
+    AlfatWriteStr(&fp,"\tTotal\r\n");
+    
+    for ( n = total; n > 0; n-- )
+    {
+      rec = &recs[n - 1];
+      getTimeDateStr ( rec->date, date_string );
+      sprintf( temp_str, "%s\t%u", date_string, rec->depth );
+      AlfatWriteStr(&fp,temp_str);
+      for ( p = 0; p < PROF_PHASES; p++ )
+      {
+        sprintf( temp_str, "\t%lu", (unsigned long)rec->ms[p] );
+        AlfatWriteStr(&fp,temp_str);
+      }
+      sprintf( temp_str, "\t%lu\r\n", (unsigned long)rec->total_ms );
+      AlfatWriteStr(&fp,temp_str);
+    }
+    AlfatFlushData(fp.fileHandle);
+    AlfatCloseFile(fp.fileHandle);
+  }
+  AlfatStop();
+  
+  isrTIMER_1_Enable();
+}
@@ -19,36 +19,465 @@
 #include "LCD_drivers.h"
 #include <stddef.h> /* for offsetof */
 /************************************************************************
+//  Project sessions. The projects in use stay open between helper calls,
+//  so a review or export pass costs one FAT open instead of one per field.
+//  Two are kept so a copy from one project to another doesn't thrash.
+//  A session is closed by projSessionClose, by SDunmount, before a project
+//  file is removed and after PROJ_SESSION_IDLE_MS without use.
+//
+//  Opening a session also works out the file format. Journal projects
+//  (PROJ_LOG_MAGIC header) are recovered here: a torn last record from a
+//  power cut is found by its length or CRC and cut off, so the station
+//  count is always the number of whole records. A rewrite of a counted
+//  record left in the slot is written out again.
+***************************************************************************/
+typedef struct
+{
+  FS_FILE * file;
+  char      name[PROJ_NAME_LENGTH];
+  uint32    used_ms;
+  uint8     format;                     // PROJ_FORMAT_xxx
+  uint16_t  count;                      // journal: whole records on the card
+} proj_session_t;
+static proj_session_t session[PROJ_SESSIONS];
+static proj_session_stats_t sessionStats;
+/************************************************************************
+//  Station directory. Name, depth and date of every station of one
+//  project, loaded in a single sequential pass so browsing a project
+//  doesn't go back to the card on every key. Any write through the
+//  session drops it.
+***************************************************************************/
+static station_dir_t stationDir;
+static FS_FILE * catalogFile;
+static uint32    catalogUsedMs;
+/************************************************************************
+//  Functions Name: projCrc16 ()
+//  Description:  CRC-16/CCITT (poly 0x1021, init 0xFFFF) of a buffer
+***************************************************************************/
+static uint16_t projCrc16 ( const uint8_t * buf, uint16_t len )
+{
+ uint16_t crc = 0xFFFF;
+ uint8_t  i;
+ while ( len-- )
+ {
+  crc ^= (uint16_t)( *buf++ ) << 8;
+  for ( i = 0; i < 8; i++ )
+  {
+   crc = ( crc & 0x8000 ) ? ( crc << 1 ) ^ 0x1021 : ( crc << 1 );
+  }
+ }
+ return crc;
+}
+/************************************************************************
+//  Functions Name: projLogRecordOk ()
+//  Description:  TRUE if a journal record is whole and belongs at index
+***************************************************************************/
+static uint8 projLogRecordOk ( const proj_log_record_t * rec, uint16_t index )
+{
+ return ( rec->tag == PROJ_LOG_REC_TAG ) && ( rec->index == index )
+        && ( rec->crc == projCrc16 ( (const uint8_t *)rec, offsetof(proj_log_record_t,crc) ) );
+}
+/************************************************************************
+//  Functions Name: projLogInit ()
+//  Description:  Writes the header of a new, empty journal project
+//  Parameters:   file just created
+//  Returns:      0 success, -1 error
+***************************************************************************/
+int32 projLogInit ( FS_FILE * file )
+{
+ proj_log_header_t head;
+ proj_log_record_t slot;
+ memset ( &head, 0, sizeof(head) );
+ memset ( &slot, 0, sizeof(slot) );
+ head.magic       = PROJ_LOG_MAGIC;
+ head.version     = PROJ_LOG_VERSION;
+ head.header_size = sizeof(proj_log_header_t);
+ head.record_size = sizeof(proj_log_record_t);
+ if ( SD_WriteBuffer ( file, (char*)&head, sizeof(head) ) != 0 )
+ {
+  return -1;
+ }
+ return SD_WriteBuffer ( file, (char*)&slot, sizeof(slot) );
+}
+/************************************************************************
+//  Functions Name: projLogMount ()
+//  Description:  Checks the header of a journal project and recovers its
+//                tail. Only the last records are read, the ones a power
+//                cut could have left half written, then a whole record in
+//                the rewrite slot is written over its station.
+//  Returns:      0 success, -1 if the journal can't be used
+***************************************************************************/
+static int32 projLogMount ( proj_session_t * s, const proj_log_header_t * head )
+{
+ proj_log_record_t rec;
+ uint32_t size, whole;
+ uint16_t none = 0;
+ if ( ( head->version != PROJ_LOG_VERSION ) || ( head->header_size != sizeof(proj_log_header_t) )
+      || ( head->record_size != sizeof(proj_log_record_t) ) )
+ {
+  return -1;  // written by other firmware, leave it alone
+ }
+ size = FS_GetFileSize ( s->file );
+ if ( size < PROJ_LOG_OFFSET(0) )
+ {
+  return -1;  // cut off while it was created
+ }
+ whole = ( size - sizeof(proj_log_header_t) ) / sizeof(proj_log_record_t);
+ while ( whole > 0 )
+ {
+  FS_FSeek ( s->file, PROJ_LOG_OFFSET(whole - 1), FS_SEEK_SET );
+  if ( ( FS_Read ( s->file, (char*)&rec, sizeof(rec) ) == sizeof(rec) ) && projLogRecordOk ( &rec, whole - 1 ) )
+  {
+   break;
+  }
+  whole--;
+ }
+ if ( size != PROJ_LOG_OFFSET(whole) )
+ {
+  FS_Truncate ( s->file, PROJ_LOG_OFFSET(whole) );
+  FS_Sync ( "" );
+  sessionStats.recovered++;
+ }
+ FS_FSeek ( s->file, PROJ_LOG_SLOT_OFFSET, FS_SEEK_SET );
+ if ( ( FS_Read ( s->file, (char*)&rec, sizeof(rec) ) == sizeof(rec) ) && ( rec.tag == PROJ_LOG_REC_TAG ) )
+ {
+  if ( ( rec.index < whole ) && projLogRecordOk ( &rec, rec.index ) )
+  {
+   FS_FSeek ( s->file, PROJ_LOG_OFFSET(rec.index), FS_SEEK_SET );
+   FS_Write ( s->file, (char*)&rec, sizeof(rec) );
+   sessionStats.recovered++;
+  }
+  FS_FSeek ( s->file, PROJ_LOG_SLOT_OFFSET, FS_SEEK_SET );
+  FS_Write ( s->file, (char*)&none, sizeof(none) );
+  FS_Sync ( "" );
+ }
+ s->count = whole;
+ return 0;
+}
+/************************************************************************
+//  Functions Name: projSessionFor ()
+//  Description:  The session of a project, opened if it isn't. The least
+//                recently used session is given up for it.
+//  Returns:      session, null if the project can't be opened
+***************************************************************************/
+static proj_session_t * projSessionFor ( char* project )
+{
+ proj_session_t * s = &session[0];
+ proj_log_header_t head;
+ uint8 i;
+ for ( i = 0; i < PROJ_SESSIONS; i++ )
+ {
+  if ( ( session[i].file != null ) && ( strncmp ( session[i].name, project, PROJ_NAME_LENGTH ) == 0 ) )
+  {
+   sessionStats.reuses++;
+   session[i].used_ms = msTimer;
+   return &session[i];
+  }
+  if ( ( session[i].file == null ) || ( ( s->file != null ) && ( session[i].used_ms < s->used_ms ) ) )
+  {
+   s = &session[i];
+  }
+ }
+ if ( s->file != null )
+ {
+  SDcacheClose ( s->file );
+  FS_FClose ( s->file );
+  s->file = null;
+ }
+ SD_Wake();
+ s->file = SDProjOpen ( project );
+ if ( s->file == null )
+ {
+  return null;
+ }
+ sessionStats.opens++;
+ s->used_ms = msTimer;
+ s->format  = PROJ_FORMAT_FIXED;
+ s->count   = 0;
+ if ( ( FS_Read ( s->file, (char*)&head, sizeof(head) ) == sizeof(head) ) && ( head.magic == PROJ_LOG_MAGIC ) )
+ {
+  s->format = PROJ_FORMAT_LOG;
+  if ( projLogMount ( s, &head ) != 0 )
+  {
+   FS_FClose ( s->file );
+   s->file = null;
+   return null;
+  }
+ }
+ strncpy ( s->name, project, PROJ_NAME_LENGTH - 1 );
+ s->name[PROJ_NAME_LENGTH - 1] = '\0';
+ return s;
+}
+/************************************************************************
+//  Functions Name: projSessionGet ()
+//  Description:  Returns the open handle of a project
+//  Parameters:   Project name
+//  Returns:      file handle, null if the project can't be opened
+***************************************************************************/
+FS_FILE * projSessionGet ( char* project )
+{
+ proj_session_t * s = projSessionFor ( project );
+ return ( s != null ) ? s->file : null;
+}
+/************************************************************************
+//  Functions Name: projSessionClose ()
+//  Description:  Closes the projects in session, if any
+***************************************************************************/
+void projSessionClose ( void )
+{
+ uint8 i;
+ catalogClose ( );
+ for ( i = 0; i < PROJ_SESSIONS; i++ )
+ {
+  if ( session[i].file != null )
+  {
+   SDcacheClose ( session[i].file );
+   FS_FClose ( session[i].file );
+   session[i].file = null;
+  }
+ }
+}
+/************************************************************************
+//  Functions Name: projSessionIdle ()
+//  Description:  Called from the idle loop, closes a session once it has
+//                not been used for PROJ_SESSION_IDLE_MS
+***************************************************************************/
+void projSessionIdle ( void )
+{
+ uint8 i;
+ if ( ( catalogFile != null ) && ( ( msTimer - catalogUsedMs ) > PROJ_SESSION_IDLE_MS ) )
+ {
+  catalogClose ( );
+ }
+ for ( i = 0; i < PROJ_SESSIONS; i++ )
+ {
+  if ( ( session[i].file != null ) && ( ( msTimer - session[i].used_ms ) > PROJ_SESSION_IDLE_MS ) )
+  {
+   SDcacheClose ( session[i].file );
+   FS_FClose ( session[i].file );
+   session[i].file = null;
+  }
+ }
+}
+/************************************************************************
+//  Functions Name: getProjSessionStats ()
+//  Description:  Opens and handle reuses since the last reset
+//  Parameters:   destination, TRUE to clear the figures after the copy
+***************************************************************************/
+void getProjSessionStats ( proj_session_stats_t * stats, uint8 reset )
+{
+ *stats = sessionStats;
+ if ( reset )
+ {
+  memset ( &sessionStats, 0, sizeof(sessionStats) );
+ }
+}
+/************************************************************************
+//  Functions Name: getProjectFormat ()
+//  Description:  PROJ_FORMAT_FIXED for a project_data_t file,
+//                PROJ_FORMAT_LOG for a journal, 0 if it can't be opened
+***************************************************************************/
+uint8 getProjectFormat ( char* project )
+{
+ proj_session_t * s = projSessionFor ( project );
+ return ( s != null ) ? s->format : 0;
+}
+/************************************************************************
+//  Functions Name: projRead (), projWrite (), projCommit ()
+//  Description:  Read or write len bytes at offset of a project through the
+//                session and the SD sector cache. Writes stay in the cache
+//                until projCommit, which writes them back and syncs the
+//                directory entry, so a power cut after it loses nothing.
+//  Returns:      0 success, -1 error
+***************************************************************************/
+static int32 projRead ( proj_session_t * s, uint32_t offset, char * buf, int32 len )
+{
+ if ( s == null )
+ {
+  return -1;
+ }
+ return SDcacheRead ( s->file, offset, buf, len );
+}
+static int32 projWrite ( proj_session_t * s, uint32_t offset, char * buf, int32 len )
+{
+ stationDirInvalidate ( );
+ if ( s == null )
+ {
+  return -1;
+ }
+ return SDcacheWrite ( s->file, offset, buf, len );
+}
+static int32 projCommit ( proj_session_t * s )
+{
+ int32 error;
+ if ( s == null )
+ {
+  return -1;
+ }
+ error = SDcacheFlush ( s->file );
+ FS_Sync ( "" );
+ return error;
+}
+/************************************************************************
+//  Functions Name: projFieldOffset ()
+//  Description:  Where a project wide field lives in either format
+//  Parameters:   session, PROJ_FIELD_xxx
+***************************************************************************/
+static uint32_t projFieldOffset ( const proj_session_t * s, uint8 field )
+{
+ if ( s->format == PROJ_FORMAT_LOG )
+ {
+  return ( field == PROJ_FIELD_AUTO ) ? offsetof ( proj_log_header_t, station_auto )
+                                      : offsetof ( proj_log_header_t, station_auto_start );
+ }
+ return ( field == PROJ_FIELD_AUTO ) ? offsetof ( project_data_t, station_auto )
+                                     : offsetof ( project_data_t, station_auto_start );
+}
+/************************************************************************
+//  Functions Name: loadStationDir ()
+//  Description:  Makes the station directory of a project current, reading
+//                the window of STATION_DIR_ENTRIES stations holding station
+//                first in one pass if it isn't
+//  Parameters:   Project name, a station the window must hold
+//  Returns:      the directory, null if the project can't be read
+***************************************************************************/
+const station_dir_t * loadStationDir ( char* project, uint16_t first )
+{
+ station_data_t station;
+ uint16_t i, total;
+ first -= first % STATION_DIR_ENTRIES;
+ if ( stationDir.valid && ( stationDir.first == first ) && ( strncmp ( stationDir.project, project, PROJ_NAME_LENGTH ) == 0 ) )
+ {
+  return &stationDir;
+ }
+ stationDir.valid = FALSE;
+ total = getStationNumber ( project );
+ for ( i = 0; ( i < STATION_DIR_ENTRIES ) && ( first + i < total ); i++ )  // consecutive records, the seeks don't move the file position
+ {
+  if ( readStation ( project, first + i, &station ) != 0 )
+  {
+   return null;
+  }
+  memcpy ( stationDir.entry[i].name, station.name, PROJ_NAME_LENGTH );
+  stationDir.entry[i].name[PROJ_NAME_LENGTH - 1] = '\0';
+  stationDir.entry[i].depth    = station.depth;
+  stationDir.entry[i].sweep_id = station.sweep_id;
+  stationDir.entry[i].date     = station.date;
+ }
+ strncpy ( stationDir.project, project, PROJ_NAME_LENGTH - 1 );
+ stationDir.project[PROJ_NAME_LENGTH - 1] = '\0';
+ stationDir.total = total;
+ stationDir.first = first;
+ stationDir.count = i;
+ stationDir.valid = TRUE;
+ return &stationDir;
+}
+/************************************************************************
+//  Functions Name: projectHasRoom ()
+//  Description:  Whether another station can be stored. A fixed layout
+//                project holds MAX_STATIONS, a journal grows until
+//                PROJ_LOG_MAX_STATIONS or the card is full.
+//  Parameters:   Project name
+//  Returns:      TRUE if there is room
+***************************************************************************/
+uint8 projectHasRoom ( char* project )
+{
+ proj_session_t * s = projSessionFor ( project );
+ if ( s == null )
+ {
+  return FALSE;
+ }
+ if ( s->format == PROJ_FORMAT_LOG )
+ {
+  return ( s->count < PROJ_LOG_MAX_STATIONS );
+ }
+ return ( getStationNumber ( project ) < MAX_STATIONS );
+}
+/************************************************************************
+//  Functions Name: stationDirInvalidate ()
+//  Description:  Drops the station directory, the next browse reloads it
+***************************************************************************/
+void stationDirInvalidate ( void )
+{
+ stationDir.valid = FALSE;
+}
+/************************************************************************
 //  Functions Name: readStation ()
 //  Description:  Given a project and station number, a station is copied from
 //                NV Memory to RAM
 //  Parameters:   Project number, Station Number, destination Ram
+//  Returns:      0 success, -1 error or a journal record that fails its CRC
 ***************************************************************************/
 int32 readStation ( char* project, uint16_t index_station, station_data_t * station   )
 {
- int32 error;
- FS_FILE* pFile = null;
- int32 offset = offsetof(project_data_t,station[index_station]);
- pFile = SDProjOpen ( project );
- FS_FSeek ( pFile, offset, FS_SEEK_SET );
- error = SDreadBuffer ( pFile, (char*)station, sizeof(station_data_t) );
- FS_FClose( pFile );
- return error;
+ proj_log_record_t rec;
+ proj_session_t * s = projSessionFor ( project );
+ if ( ( s != null ) && ( s->format == PROJ_FORMAT_LOG ) )
+ {
+  if ( ( index_station >= s->count ) || ( projRead ( s, PROJ_LOG_OFFSET(index_station), (char*)&rec, sizeof(rec) ) != 0 )
+       || !projLogRecordOk ( &rec, index_station ) )
+  {
+   return -1;
+  }
+  *station = rec.station;
+  return 0;
+ }
+ // a fixed file holds the shipped layout only, the fields after it are unknown
+ station->count_time    = 0;
+ station->count_rse     = 0;
+ station->gps_age       = GPS_AGE_NONE;
+ station->count_quality = 0;
+ station->sweep_id      = 0;
+ return projRead ( s, offsetof(project_data_t,station[index_station]), (char*)station, STATION_FIXED_SIZE );
 }
 /************************************************************************/
 //  Functions Name: writeStation ()
 //  Description:  Given a project and station number, a station is copied from
-//                RAM to  NV Memory
+//                RAM to  NV Memory. In a journal the next index is appended
+//                as one record and counted at once. An existing index is
+//                written to the slot first and committed, then in place,
+//                then the slot is cleared, so a power cut keeps either the
+//                old record or the new one. A fixed file only takes the
+//                first STATION_FIXED_SIZE bytes.
 //  Parameters:   Project number, Station Number, Source address in RAM
+//  Returns:   0=fail, 1 = success
 /***************************************************************************/
-void writeStation ( char* project, uint16_t index_station, station_data_t * station_n )
+uint8 writeStation ( char* project, uint16_t index_station, station_data_t * station_n )
 {
- FS_FILE *pFile = null;
-  uint32_t offset = offsetof(project_data_t,station[index_station]);
- pFile = SDProjOpen ( project );
- FS_FSeek ( pFile, offset, FS_SEEK_SET );
- SD_WriteBuffer( pFile, (char*)station_n, (uint32_t)sizeof(station_data_t) ) ;
- FS_FClose( pFile );
+ proj_log_record_t rec;
+ proj_session_t * s = projSessionFor ( project );
+ if ( ( s != null ) && ( s->format == PROJ_FORMAT_LOG ) )
+ {
+  if ( index_station > s->count )
+  {
+   return 0;  // no gaps in a journal
+  }
+  rec.tag     = PROJ_LOG_REC_TAG;
+  rec.index   = index_station;
+  rec.station = *station_n;
+  rec.crc     = projCrc16 ( (const uint8_t *)&rec, offsetof(proj_log_record_t,crc) );
+  if ( index_station == s->count )
+  {
+   if ( projWrite ( s, PROJ_LOG_OFFSET(index_station), (char*)&rec, sizeof(rec) ) != 0 )
+   {
+    return 0;
+   }
+   s->count++;
+   return 1;
+  }
+  if ( ( projWrite ( s, PROJ_LOG_SLOT_OFFSET, (char*)&rec, sizeof(rec) ) != 0 ) || ( projCommit ( s ) != 0 )
+       || ( projWrite ( s, PROJ_LOG_OFFSET(index_station), (char*)&rec, sizeof(rec) ) != 0 ) || ( projCommit ( s ) != 0 ) )
+  {
+   return 0;  // the slot, if it got out, is replayed at the next mount
+  }
+  rec.tag = 0;
+  if ( ( projWrite ( s, PROJ_LOG_SLOT_OFFSET, (char*)&rec.tag, sizeof(rec.tag) ) != 0 ) || ( projCommit ( s ) != 0 ) )
+  {
+   return 0;
+  }
+  return 1;
+ }
+ return ( projWrite ( s, offsetof(project_data_t,station[index_station]), (char*)station_n, STATION_FIXED_SIZE ) == 0 );
 }
 /************************************************************************/
 //  Functions Name: writeStationName ( )
@@ -59,24 +488,28 @@ void writeStation ( char* project, uint16_t index_station, station_data_t * stat
 /***************************************************************************/
 uint8 writeStationName (char* project, char * name, uint16_t index_station )
 {
- uint8 open;
- FS_FILE *pFile = null;
+ station_data_t station;
  int32_t size = strlen(name) + 1;   // length of name string plus NULL
- // find the offset of the station name of project station
- int32_t offset = offsetof(project_data_t, station[index_station].name[0]);
- pFile = SDProjOpen ( project );
- if ( pFile == null )
- {
-  return 0 ;
+ proj_session_t * s = projSessionFor ( project );
+ if ( ( s != null ) && ( s->format == PROJ_FORMAT_LOG ) )
+ {  // the record's CRC covers the name, so the whole record is rewritten
+  if ( ( size > PROJ_NAME_LENGTH ) || ( readStation ( project, index_station, &station ) != 0 ) )
+  {
+   return 0;
+  }
+  memcpy ( station.name, name, size );
+  if ( writeStation ( project, index_station, &station ) == 0 )
+  {
+   return 0;
+  }
+  return ( projCommit ( s ) == 0 );
  }
- open = FS_FSeek ( pFile, offset, FS_SEEK_SET );
- if ( open  )
+ // find the offset of the station name of project station
+ if ( projWrite ( s, offsetof(project_data_t, station[index_station]), name, size ) != 0 )
  {
-  return 0 ;
+  return 0;
  }
-open =  SD_WriteBuffer( pFile, name, size ) ;
-open = FS_FClose( pFile );
- return 1;
+ return ( projCommit ( s ) == 0 );
 }
 /************************************************************************/
 //  Functions Name: getStationName ( )
@@ -88,30 +521,34 @@ open = FS_FClose( pFile );
 int32 getStationName ( char* project, char * name, uint16_t index_station )
 {
  int32 error;
- uint8 i;
- FS_FILE *pFile = null;
+ proj_session_t * s;
  char s_name[ PROJ_NAME_LENGTH ];
- // find the offset of the station name of project station
- uint32_t offset = offsetof(project_data_t, station[index_station].name[0]);
- pFile = SDProjOpen ( project );
- FS_FSeek ( pFile, offset, FS_SEEK_SET );
- error = 1;
- for ( i=0; i < PROJ_NAME_LENGTH; i++ )
- {
-   error = SDreadBuffer ( pFile, &s_name[i], 1 );
-   if ( error == -1 )
-   {
-    error = 0;
-    break;
-   }
-  if ( s_name[i] == '\0' )
+ uint32_t offset;
+ if ( stationDir.valid && ( index_station < stationDir.total ) && ( strncmp ( stationDir.project, project, PROJ_NAME_LENGTH ) == 0 ) )
+ {  // browsing, move the window along if the station is outside it
+  if ( loadStationDir ( project, index_station ) != null )
   {
-    error = 1;
-    break;
+   memcpy ( name, stationDir.entry[index_station - stationDir.first].name, PROJ_NAME_LENGTH );
+   return 1;
   }
  }
+ s = projSessionFor ( project );
+ if ( s == null )
+ {
+  return 0;
+ }
+ // find the offset of the station name of project station
+ if ( s->format == PROJ_FORMAT_LOG )
+ {
+  offset = PROJ_LOG_OFFSET(index_station) + offsetof(proj_log_record_t, station.name[0]);
+ }
+ else
+ {
+  offset = offsetof(project_data_t, station[index_station]);
+ }
+ error = ( projRead ( s, offset, s_name, PROJ_NAME_LENGTH ) == 0 );
+ s_name[PROJ_NAME_LENGTH - 1] = '\0';
  memcpy( name, s_name, PROJ_NAME_LENGTH );
- FS_FClose( pFile );
  return error;
 }
 /************************************************************************/
@@ -122,38 +559,59 @@ int32 getStationName ( char* project, char * name, uint16_t index_station )
 /***************************************************************************/
 void clearStationNumber ( char* project   )
 {
-  uint16_t st_num = 0 ;
- FS_FILE *pFile = null;
- // offset of station number for project in NV Memory
- uint32_t offset = offsetof(project_data_t,station_number );
-  // store the number
- pFile = SDProjOpen ( project );
- FS_FSeek ( pFile, offset, FS_SEEK_SET );
- SD_WriteBuffer( pFile, (char*)&st_num, 2 ) ;
- FS_FClose( pFile );
+ uint16_t st_num = 0 ;
+ proj_session_t * s = projSessionFor ( project );
+ if ( ( s != null ) && ( s->format == PROJ_FORMAT_LOG ) )
+ {  // an empty journal is just its header
+  stationDirInvalidate ( );
+  SDcacheClose ( s->file );  // the truncate bypasses the cache
+  FS_Truncate ( s->file, PROJ_LOG_OFFSET(0) );
+  FS_Sync ( "" );
+  s->count = 0;
+  return;
+ }
+ // store the number
+ projWrite ( s, offsetof(project_data_t,station_number ), (char*)&st_num, 2 );
+ projCommit ( s );
 }
 /************************************************************************/
 //  Functions Name: incrementStationNumber ()
 //  Description:  Given a project number, the number of stations stored in it is incremented
+//                A journal counted the station when it was appended. Every
+//                store ends here, so the catalog entry is refreshed too.
 //  Parameters:   Project number
-//  Returns:      number of stations after increment
+//  Returns:      number of stations after increment, 0 if the station
+//                didn't reach the card
 /***************************************************************************/
 uint16_t incrementStationNumber ( char* project   )
 {
-  uint16_t st_num;
- FS_FILE *pFile = null;
+ uint16_t st_num = 0;
+ proj_session_t * s = projSessionFor ( project );
  // offset of station number for project in NV Memory
  uint32_t offset = offsetof(project_data_t,station_number );
- pFile = SDProjOpen ( project );
- FS_FSeek ( pFile, offset, FS_SEEK_SET );
- // read the current number of stored station in the project
- SDreadBuffer ( pFile, (char*)&st_num, 2 );
- // increment stations by one
- st_num++ ;
- // store the number
- FS_FSeek ( pFile, offset, FS_SEEK_SET );
- SD_WriteBuffer( pFile, (char*)&st_num, 2 ) ;
- FS_FClose( pFile );
+ if ( ( s != null ) && ( s->format == PROJ_FORMAT_LOG ) )
+ {
+  st_num = s->count;
+ }
+ else
+ {
+  // read the current number of stored station in the project
+  projRead ( s, offset, (char*)&st_num, 2 );
+  // increment stations by one
+  st_num++ ;
+  // store the number
+  projWrite ( s, offset, (char*)&st_num, 2 );
+ }
+ if ( projCommit ( s ) != 0 )  // the station and its count reach the card together
+ {
+  if ( ( s != null ) && ( s->format == PROJ_FORMAT_LOG ) && ( s->count > 0 ) )
+  {
+   s->count--;  // the next store takes the same index again
+  }
+  stationDirInvalidate ( );
+  return 0;
+ }
+ catalogUpdate ( project );
  return st_num;
 }
 /************************************************************************/
@@ -164,15 +622,19 @@ uint16_t incrementStationNumber ( char* project   )
 /***************************************************************************/
 uint16_t  getStationNumber ( char* project  )
 {
-  uint16_t st_num;
- FS_FILE *pFile = null;
- // offset of station number for project in NV Memory
- uint32_t offset = offsetof(project_data_t,station_number );
- pFile = SDProjOpen ( project );
- FS_FSeek ( pFile, offset, FS_SEEK_SET );
+ uint16_t st_num = 0;
+ proj_session_t * s;
+ if ( stationDir.valid && ( strncmp ( stationDir.project, project, PROJ_NAME_LENGTH ) == 0 ) )
+ {
+  return stationDir.total;
+ }
+ s = projSessionFor ( project );
+ if ( ( s != null ) && ( s->format == PROJ_FORMAT_LOG ) )
+ {
+  return s->count;
+ }
  // read the current number of stored station in the project
- SDreadBuffer ( pFile, (char*)&st_num, 2 );
- FS_FClose( pFile );
+ projRead ( s, offsetof(project_data_t,station_number ), (char*)&st_num, 2 );
  return st_num;
 }
 /************************************************************************/
@@ -188,14 +650,12 @@ uint16_t  getStationNumber ( char* project  )
 /***************************************************************************/
 void setStationAutoNumber ( char* project, char flag )
 {
- FS_FILE *pFile = null;
-// calculate the offset into the NV Memory to start the write
- uint32_t offset = offsetof ( project_data_t, station_auto );
- // store the number
- pFile = SDProjOpen ( project );
- FS_FSeek ( pFile, offset, FS_SEEK_SET );
- SD_WriteBuffer (  pFile, &flag , 1);
- FS_FClose( pFile );
+ proj_session_t * s = projSessionFor ( project );
+ if ( s != null )
+ {
+  projWrite ( s, projFieldOffset ( s, PROJ_FIELD_AUTO ), &flag, 1 );
+  projCommit ( s );
+ }
 }
 /************************************************************************/
 //  Functions Name: checkStationAutoNumberE( )
@@ -210,15 +670,12 @@ void setStationAutoNumber ( char* project, char flag )
 /***************************************************************************/
 uint8_t checkStationAutoNumber ( char* project )
 {
- char st_auto;
- FS_FILE *pFile = null;
- pFile = SDProjOpen ( project );
- // calculate the offset into the NV Memory to start the write
- uint32_t offset = offsetof ( project_data_t, station_auto );
- FS_FSeek ( pFile, offset, FS_SEEK_SET );
- // read the current number of stored station in the project
- SDreadBuffer ( pFile,  &st_auto , 1 );
- FS_FClose( pFile );
+ char st_auto = 0;
+ proj_session_t * s = projSessionFor ( project );
+ if ( s != null )
+ {
+  projRead ( s, projFieldOffset ( s, PROJ_FIELD_AUTO ), &st_auto, 1 );
+ }
  return st_auto;
 }
 /**************************************************************************/
@@ -249,6 +706,496 @@ void  getActiveProjectEE ( char * proj )
 {
   EEpromReadArray(  (uint8 *)proj, PROJ_NAME_LENGTH, offsetof( EEPROM_DATA_t,active_project_name ) );
 }
+/************************************************************************
+//  Project catalog. CATALOG_FILE in the project directory lists every
+//  project sorted by name, with its station count, size and last write
+//  time, so a project list is read by index instead of walking the FAT
+//  directory to the n-th file on every key. It is kept up to date when a
+//  project is created, stored to or deleted, checked against the
+//  directory once per mount and rebuilt from a directory scan if it is
+//  missing or doesn't match.
+***************************************************************************/
+static uint16_t  catalogEntries;
+/************************************************************************
+//  Functions Name: catalogSetCount ()
+//  Description:  Writes the number of entries into the catalog header
+***************************************************************************/
+static int32 catalogSetCount ( uint16_t count )
+{
+ catalogEntries = count;
+ FS_FSeek ( catalogFile, offsetof(proj_catalog_header_t,count), FS_SEEK_SET );
+ return SD_WriteBuffer ( catalogFile, (char*)&count, sizeof(count) );
+}
+/************************************************************************
+//  Functions Name: catalogRead ()
+//  Description:  Reads catalog entry pos (0 based)
+//  Returns:      0 success, -1 error
+***************************************************************************/
+static int32 catalogRead ( uint16_t pos, proj_catalog_entry_t * entry )
+{
+ if ( ( pos >= catalogEntries ) || FS_FSeek ( catalogFile, CATALOG_OFFSET(pos), FS_SEEK_SET ) )
+ {
+  return -1;
+ }
+ return SDreadBuffer ( catalogFile, (char*)entry, sizeof(proj_catalog_entry_t) );
+}
+/************************************************************************
+//  Functions Name: catalogFind ()
+//  Description:  Binary search of the catalog for a project
+//  Parameters:   project name, where it is or would be inserted
+//  Returns:      TRUE if found
+***************************************************************************/
+static uint8 catalogFind ( char * project, uint16_t * pos )
+{
+ proj_catalog_entry_t entry;
+ uint16_t lo = 0, hi = catalogEntries, mid;
+ int cmp;
+ while ( lo < hi )
+ {
+  mid = ( lo + hi ) / 2;
+  if ( catalogRead ( mid, &entry ) != 0 )
+  {
+   break;
+  }
+  cmp = strncmp ( project, entry.name, PROJ_NAME_LENGTH );
+  if ( cmp == 0 )
+  {
+   *pos = mid;
+   return TRUE;
+  }
+  if ( cmp < 0 )
+  {
+   hi = mid;
+  }
+  else
+  {
+   lo = mid + 1;
+  }
+ }
+ *pos = lo;
+ return FALSE;
+}
+/************************************************************************
+//  Functions Name: catalogShift ()
+//  Description:  Moves the entries from pos to the end one place up (to
+//                open a slot) or down (to close one), a block at a time
+***************************************************************************/
+static void catalogShift ( uint16_t pos, uint8 up )
+{
+ proj_catalog_entry_t block[CATALOG_MOVE_ENTRIES];
+ uint16_t n, first;
+ if ( up )
+ {
+  first = catalogEntries;
+  while ( first > pos )  // from the end backwards so nothing is overwritten
+  {
+   n = ( ( first - pos ) > CATALOG_MOVE_ENTRIES ) ? CATALOG_MOVE_ENTRIES : ( first - pos );
+   first -= n;
+   FS_FSeek ( catalogFile, CATALOG_OFFSET(first), FS_SEEK_SET );
+   SDreadBuffer ( catalogFile, (char*)block, n * sizeof(proj_catalog_entry_t) );
+   FS_FSeek ( catalogFile, CATALOG_OFFSET(first + 1), FS_SEEK_SET );
+   SD_WriteBuffer ( catalogFile, (char*)block, n * sizeof(proj_catalog_entry_t) );
+  }
+ }
+ else
+ {
+  first = pos + 1;
+  while ( first < catalogEntries )
+  {
+   n = ( ( catalogEntries - first ) > CATALOG_MOVE_ENTRIES ) ? CATALOG_MOVE_ENTRIES : ( catalogEntries - first );
+   FS_FSeek ( catalogFile, CATALOG_OFFSET(first), FS_SEEK_SET );
+   SDreadBuffer ( catalogFile, (char*)block, n * sizeof(proj_catalog_entry_t) );
+   FS_FSeek ( catalogFile, CATALOG_OFFSET(first - 1), FS_SEEK_SET );
+   SD_WriteBuffer ( catalogFile, (char*)block, n * sizeof(proj_catalog_entry_t) );
+   first += n;
+  }
+ }
+}
+/************************************************************************
+//  Functions Name: catalogPut ()
+//  Description:  Adds an entry in name order, or replaces the entry of the
+//                same name
+//  Returns:      0 success, -1 error or catalog full
+***************************************************************************/
+static int32 catalogPut ( proj_catalog_entry_t * entry )
+{
+ uint16_t pos;
+ if ( !catalogFind ( entry->name, &pos ) )
+ {
+  if ( catalogEntries >= MAX_PROJECTS )
+  {
+   return -1;
+  }
+  catalogShift ( pos, TRUE );
+  catalogSetCount ( catalogEntries + 1 );
+ }
+ FS_FSeek ( catalogFile, CATALOG_OFFSET(pos), FS_SEEK_SET );
+ return SD_WriteBuffer ( catalogFile, (char*)entry, sizeof(proj_catalog_entry_t) );
+}
+/************************************************************************
+//  Functions Name: catalogEntryOf ()
+//  Description:  Fills a catalog entry from the project file
+***************************************************************************/
+static void catalogEntryOf ( char * project, proj_catalog_entry_t * entry )
+{
+ station_data_t last;
+ char buf[30];
+ U32 stamp = 0;
+ proj_session_t * s;
+ memset ( entry, 0, sizeof(proj_catalog_entry_t) );
+ strncpy ( entry->name, project, PROJ_NAME_LENGTH - 1 );
+ entry->stations = getStationNumber ( project );
+ if ( ( entry->stations > 0 ) && ( readStation ( project, entry->stations - 1, &last ) == 0 ) )
+ {
+  entry->last_date = last.date;
+ }
+ s = projSessionFor ( project );
+ if ( s != null )
+ {
+  SDcacheFlush ( s->file );  // the size on the card must include what is cached
+  entry->size = FS_GetFileSize ( s->file );
+ }
+ snprintf ( buf, 30, "\\Project\\%s", project );
+ FS_GetFileTime ( buf, &stamp );  // U32 is unsigned long, wider than the entry field off target
+ entry->modified = stamp;
+}
+/************************************************************************
+//  Functions Name: catalogListed ()
+//  Description:  Whether a directory entry of \Project\ gets a catalog
+//                entry: a file other than the catalog whose name fits
+***************************************************************************/
+static uint8 catalogListed ( FS_FIND_DATA * fd, char * fname )
+{
+ return ( ( fd->Attributes & FS_ATTR_DIRECTORY ) != FS_ATTR_DIRECTORY ) && ( strcmp ( fname, CATALOG_NAME ) != 0 )
+        && ( strcmp ( fname, CATALOG_OLD_NAME ) != 0 ) && ( strlen ( fname ) < PROJ_NAME_LENGTH );
+}
+/************************************************************************
+//  Functions Name: catalogListedFiles ()
+//  Description:  Entries a rebuild would write, the catalogListed files
+//                up to MAX_PROJECTS
+***************************************************************************/
+static uint16_t catalogListedFiles ( void )
+{
+ FS_FIND_DATA fd;
+ char fname[31];
+ uint16_t files = 0;
+ int32 more;
+ more = ( FS_FindFirstFile ( &fd, "\\Project\\", fname, sizeof(fname) ) == 0 );
+ while ( more && ( files < MAX_PROJECTS ) )
+ {
+  if ( catalogListed ( &fd, fname ) )
+  {
+   files++;
+  }
+  more = FS_FindNextFile ( &fd );
+ }
+ FS_FindClose ( &fd );
+ return files;
+}
+/************************************************************************
+//  Functions Name: catalogCarryFlags ()
+//  Description:  Copies the export marks of the replaced catalog to the
+//                new one, for projects unchanged since, then removes it
+***************************************************************************/
+static void catalogCarryFlags ( void )
+{
+ proj_catalog_header_t head;
+ proj_catalog_entry_t old, entry;
+ FS_FILE * file;
+ uint16_t i, pos;
+ file = FS_FOpen ( CATALOG_OLD_FILE, "r" );
+ if ( file == null )
+ {
+  return;
+ }
+ if ( ( SDreadBuffer ( file, (char*)&head, sizeof(head) ) == 0 ) && ( head.magic == CATALOG_MAGIC )
+      && ( head.entry_size == sizeof(proj_catalog_entry_t) ) )
+ {
+  for ( i = 0; ( i < head.count ) && ( SDreadBuffer ( file, (char*)&old, sizeof(old) ) == 0 ); i++ )
+  {
+   if ( ( old.flags & CATALOG_EXPORTED ) && catalogFind ( old.name, &pos ) && ( catalogRead ( pos, &entry ) == 0 )
+        && ( entry.stations == old.stations ) && ( entry.size == old.size ) && ( entry.modified == old.modified ) )
+   {
+    entry.flags |= CATALOG_EXPORTED;
+    FS_FSeek ( catalogFile, CATALOG_OFFSET(pos), FS_SEEK_SET );
+    SD_WriteBuffer ( catalogFile, (char*)&entry, sizeof(entry) );
+   }
+  }
+ }
+ FS_FClose ( file );
+ FS_Remove ( CATALOG_OLD_FILE );
+}
+/************************************************************************
+//  Functions Name: catalogRebuild ()
+//  Description:  Writes a new catalog from one scan of the project directory.
+//                The old one is kept aside until its export marks are
+//                carried over.
+//  Returns:      0 success, -1 error
+***************************************************************************/
+static int32 catalogRebuild ( void )
+{
+ proj_catalog_header_t head;
+ proj_catalog_entry_t entry;
+ FS_FIND_DATA fd;
+ char fname[31];
+ int32 more;
+ if ( catalogFile != null )
+ {
+  FS_FClose ( catalogFile );
+ }
+ FS_Remove ( CATALOG_OLD_FILE );      // left by a rebuild cut short
+ FS_Rename ( CATALOG_FILE, CATALOG_OLD_NAME );
+ catalogFile = FS_FOpen ( CATALOG_FILE, "wb+" );
+ if ( catalogFile == null )
+ {
+  return -1;
+ }
+ memset ( &head, 0, sizeof(head) );
+ head.magic      = CATALOG_MAGIC;
+ head.version    = CATALOG_VERSION;
+ head.entry_size = sizeof(proj_catalog_entry_t);
+ SD_WriteBuffer ( catalogFile, (char*)&head, sizeof(head) );
+ catalogEntries = 0;
+ more = ( FS_FindFirstFile ( &fd, "\\Project\\", fname, sizeof(fname) ) == 0 );
+ while ( more )
+ {
+  if ( catalogListed ( &fd, fname ) )
+  {
+   catalogEntryOf ( fname, &entry );
+   entry.size     = fd.FileSize;
+   entry.modified = fd.LastWriteTime;
+   catalogPut ( &entry );
+  }
+  more = FS_FindNextFile ( &fd );
+ }
+ FS_FindClose ( &fd );
+ catalogCarryFlags ( );
+ FS_Sync ( "" );
+ sessionStats.catalog_rebuilds++;
+ return 0;
+}
+/************************************************************************
+//  Functions Name: catalogOpen ()
+//  Description:  Opens the catalog. The first open after the card is
+//                started checks its entry count against the files a
+//                rebuild would list.
+//  Returns:      0 success, -1 error
+***************************************************************************/
+static int32 catalogOpen ( void )
+{
+ proj_catalog_header_t head;
+ uint16_t files;
+ catalogUsedMs = msTimer;
+ if ( catalogFile != null )
+ {
+  return 0;
+ }
+ SD_Wake();
+ catalogFile = FS_FOpen ( CATALOG_FILE, "r+" );
+ if ( catalogFile != null )
+ {
+  files = catalogListedFiles ( );
+  if ( ( SDreadBuffer ( catalogFile, (char*)&head, sizeof(head) ) == 0 ) && ( head.magic == CATALOG_MAGIC )
+       && ( head.version == CATALOG_VERSION ) && ( head.entry_size == sizeof(proj_catalog_entry_t) )
+       && ( head.count == files ) )
+  {
+   catalogEntries = head.count;
+   return 0;
+  }
+ }
+ return catalogRebuild ( );
+}
+/************************************************************************
+//  Functions Name: catalogClose ()
+//  Description:  Closes the catalog, it is checked again on the next open
+***************************************************************************/
+void catalogClose ( void )
+{
+ if ( catalogFile != null )
+ {
+  FS_FClose ( catalogFile );
+  catalogFile = null;
+ }
+}
+/************************************************************************
+//  Functions Name: catalogGetEntry ()
+//  Description:  Catalog entry of the n-th project in name order
+//  Parameters:   index, 1 based like SD_FindFile, destination
+//  Returns:      0 success, -1 error
+***************************************************************************/
+int32 catalogGetEntry ( uint16_t index, proj_catalog_entry_t * entry )
+{
+ if ( ( index == 0 ) || ( catalogOpen ( ) != 0 ) )
+ {
+  return -1;
+ }
+ return catalogRead ( index - 1, entry );
+}
+/************************************************************************
+//  Functions Name: catalogGetName ()
+//  Description:  Name of the n-th project in name order
+//  Parameters:   index, 1 based, destination of PROJ_NAME_LENGTH
+//  Returns:      0 success, -1 error
+***************************************************************************/
+int32 catalogGetName ( uint16_t index, char * project )
+{
+ proj_catalog_entry_t entry;
+ if ( catalogGetEntry ( index, &entry ) != 0 )
+ {
+  project[0] = '\0';
+  return -1;
+ }
+ memcpy ( project, entry.name, PROJ_NAME_LENGTH );
+ return 0;
+}
+/************************************************************************
+//  Functions Name: catalogUpdate ()
+//  Description:  Adds a project to the catalog or refreshes its entry
+//  Returns:      0 success, -1 error or catalog full
+***************************************************************************/
+int32 catalogUpdate ( char * project )
+{
+ proj_catalog_entry_t entry;
+ int32 error;
+ if ( catalogOpen ( ) != 0 )
+ {
+  return -1;
+ }
+ catalogEntryOf ( project, &entry );
+ error = catalogPut ( &entry );
+ FS_Sync ( "" );
+ return error;
+}
+/************************************************************************
+//  Functions Name: catalogRemove ()
+//  Description:  Takes a deleted project out of the catalog
+***************************************************************************/
+void catalogRemove ( char * project )
+{
+ uint16_t pos;
+ if ( ( catalogOpen ( ) == 0 ) && catalogFind ( project, &pos ) )
+ {
+  catalogShift ( pos, FALSE );
+  catalogSetCount ( catalogEntries - 1 );
+  FS_Truncate ( catalogFile, CATALOG_OFFSET(catalogEntries) );
+  FS_Sync ( "" );
+ }
+}
+/************************************************************************
+//  Functions Name: catalogMarkExported ()
+//  Description:  Notes that a project has been written to USB. Storing
+//                to it again refreshes the entry and clears the mark.
+***************************************************************************/
+void catalogMarkExported ( char * project )
+{
+ proj_catalog_entry_t entry;
+ uint16_t pos;
+ if ( ( catalogOpen ( ) == 0 ) && catalogFind ( project, &pos ) && ( catalogRead ( pos, &entry ) == 0 ) )
+ {
+  entry.flags |= CATALOG_EXPORTED;
+  FS_FSeek ( catalogFile, CATALOG_OFFSET(pos), FS_SEEK_SET );
+  SD_WriteBuffer ( catalogFile, (char*)&entry, sizeof(entry) );
+  FS_Sync ( "" );
+ }
+}
+/************************************************************************
+//  Functions Name: projDeleteWanted ()
+//  Description:  Whether a project goes under a clean up policy
+//  Parameters:   catalog entry, PROJ_DELETE_xxx, today and age limit in
+//                decode_date days
+***************************************************************************/
+static uint8 projDeleteWanted ( proj_catalog_entry_t * entry, uint8 policy, uint32 today, uint16 days )
+{
+ switch ( policy )
+ {
+  case PROJ_DELETE_ALL:
+   return TRUE;
+  case PROJ_DELETE_EXPORTED:
+   return ( entry->flags & CATALOG_EXPORTED ) != 0;
+  case PROJ_DELETE_OLDER:  // dated by the last station, empty projects are kept
+   return ( entry->last_date.iyear != 0 ) && ( today > decode_date ( entry->last_date ) + days );
+ }
+ return FALSE;
+}
+/************************************************************************
+//  Functions Name: deleteProjectsBy ()
+//  Description:  Deletes the projects a clean up policy picks in a single
+//                pass over the project directory, showing progress. Each
+//                file is judged by its catalog entry, deleted entries are
+//                only marked during the pass and the catalog is compacted
+//                once at the end. Files missing from the catalog are only
+//                removed by PROJ_DELETE_ALL.
+//  Parameters:   PROJ_DELETE_xxx, age in days for PROJ_DELETE_OLDER
+//  Returns:      number of projects deleted
+***************************************************************************/
+uint16_t deleteProjectsBy ( uint8 policy, uint16 days )
+{
+ proj_catalog_entry_t entry;
+ FS_FIND_DATA fd;
+ date_time_t now;
+ char fname[31], path[30], active[PROJ_NAME_LENGTH];
+ uint16_t pos, i, kept = 0, deleted = 0;
+ uint32 today;
+ uint8 found, wanted;
+ int32 more;
+ projSessionClose ( );  // files can't be removed while they are open
+ stationDirInvalidate ( );
+ if ( catalogOpen ( ) != 0 )
+ {
+  return 0;
+ }
+ read_RTC ( &now );
+ today = decode_date ( now );
+ getActiveProjectEE ( active );
+ CLEAR_DISP;
+ LCD_PrintAtPositionCentered ( "Deleting Projects", LINE1 + 10 );
+ more = ( FS_FindFirstFile ( &fd, "\\Project\\", fname, sizeof(fname) ) == 0 );
+ while ( more )
+ {
+  if ( ( ( fd.Attributes & FS_ATTR_DIRECTORY ) != FS_ATTR_DIRECTORY ) && ( strcmp ( fname, CATALOG_NAME ) != 0 ) )
+  {
+   found  = ( strlen ( fname ) < PROJ_NAME_LENGTH ) && catalogFind ( fname, &pos ) && ( catalogRead ( pos, &entry ) == 0 );
+   wanted = found ? projDeleteWanted ( &entry, policy, today, days ) : ( policy == PROJ_DELETE_ALL );
+   snprintf ( path, 30, "\\Project\\%s", fname );
+   if ( wanted && ( FS_Remove ( path ) == 0 ) )
+   {
+    deleted++;
+    if ( found )
+    {
+     entry.flags |= CATALOG_DELETED;
+     FS_FSeek ( catalogFile, CATALOG_OFFSET(pos), FS_SEEK_SET );
+     SD_WriteBuffer ( catalogFile, (char*)&entry, sizeof(entry) );
+    }
+    if ( strncmp ( fname, active, PROJ_NAME_LENGTH ) == 0 )
+    {
+     setActiveProjectEE ( "none_selected" ); // Put the active project name into EEPROM
+    }
+    sprintf ( lcdstr, "%u Deleted", deleted );
+    LCD_PrintAtPositionCentered ( lcdstr, LINE3 + 10 );
+    LCD_PrintBlanksAtPosition ( 20, LINE4 );
+    LCD_PrintAtPositionCentered ( fname, LINE4 + 10 );
+   }
+  }
+  more = FS_FindNextFile ( &fd );
+ }
+ FS_FindClose ( &fd );
+ for ( i = 0; i < catalogEntries; i++ )
+ {
+  if ( ( catalogRead ( i, &entry ) == 0 ) && !( entry.flags & CATALOG_DELETED ) )
+  {
+   if ( kept != i )
+   {
+    FS_FSeek ( catalogFile, CATALOG_OFFSET(kept), FS_SEEK_SET );
+    SD_WriteBuffer ( catalogFile, (char*)&entry, sizeof(entry) );
+   }
+   kept++;
+  }
+ }
+ catalogSetCount ( kept );
+ FS_Truncate ( catalogFile, CATALOG_OFFSET(kept) );
+ FS_Sync ( "" );
+ return deleted;
+}
 /**************************************************************************/
 //  Functions Name: getProjectNumber ()
 //
@@ -261,10 +1208,11 @@ void  getActiveProjectEE ( char * proj )
 /***************************************************************************/
 uint16_t  getProjectNumber ( void  )
 {
- uint16_t proj_num;
- SD_Wake();
- proj_num = SD_FindTotalFiles (  "Project\\", false );
- return proj_num;
+ if ( catalogOpen ( ) != 0 )
+ {
+  return 0;
+ }
+ return catalogEntries;
 }
 /************************************************************************/
 //  Functions Name: writeAutoStationStart( )
@@ -279,14 +1227,12 @@ uint16_t  getProjectNumber ( void  )
 /***************************************************************************/
 void writeAutoStationStart ( char* project , uint16 start )
 {
- // calculate the offset into the NV Memory to start the write
- FS_FILE *file = null;
- SD_Wake();
- file = SDProjOpen ( project );
- uint32_t offset = offsetof ( project_data_t, station_auto_start );
- FS_FSeek ( file, offset, FS_SEEK_SET );
- SD_WriteBuffer( file, (char*)&start, 2 ) ;
- FS_FClose( file );
+ proj_session_t * s = projSessionFor ( project );
+ if ( s != null )
+ {
+  projWrite ( s, projFieldOffset ( s, PROJ_FIELD_AUTO_START ), (char*)&start, 2 );
+  projCommit ( s );
+ }
 }
 /************************************************************************/
 //  Functions Name: getAutoStationStart( )
@@ -301,15 +1247,12 @@ void writeAutoStationStart ( char* project , uint16 start )
 /***************************************************************************/
 uint16 getAutoStationStart ( char* project  )
 {
- // calculate the offset into the NV Memory to start the write
- uint16 start;
- FS_FILE *file = null;
- SD_Wake();
- file = SDProjOpen ( project );
- uint32_t offset = offsetof ( project_data_t, station_auto_start );
- FS_FSeek ( file, offset, FS_SEEK_SET );
- SDreadBuffer( file, (char*)&start, 2 ) ;
- FS_FClose( file );
+ uint16 start = 0;
+ proj_session_t * s = projSessionFor ( project );
+ if ( s != null )
+ {
+  projRead ( s, projFieldOffset ( s, PROJ_FIELD_AUTO_START ), (char*)&start, 2 );
+ }
  return start;
 }
 /************************************************************************/
@@ -326,13 +1269,15 @@ uint16_t clearProject  ( char * project_name  )
 {
   int error,i;
   char buffer[30];
+  projSessionClose ( );  // the file can't be removed while it is open
+  stationDirInvalidate ( );
   SD_Wake();
   sprintf( buffer, "\\Project\\%s", project_name );
   for ( i=0; i<3; i++ )
   {
     error =  FS_Remove ( buffer ) ;
     if ( error == 0 ) break;
-    SDstop(NULL);
+    SDunmount();  // retry on a fresh mount
     CyDelay(200);
     SD_Wake();
   }
@@ -351,6 +1296,10 @@ uint16_t clearProject  ( char * project_name  )
     sprintf(buffer,"%s",project_name );
     DisplayStrCentered(LINE2,buffer);
   }
+  if ( error == 0 )
+  {
+    catalogRemove ( project_name );
+  }
   setActiveProjectEE ( "none_selected" ); // Put the active project name into EEPROM
   CyDelay(2000);
   return error;
@@ -370,8 +1319,9 @@ uint16 resetProjectStorage ( void )
 {
   int Err;
   char project [] = "TEMP";
+  projSessionClose ( );
+  stationDirInvalidate ( );
   SD_Wake();
-  DeleteProjectDirectory();
   if( 0 == CreateDir("Project") )
   {
     /* Display failure message */
@@ -380,6 +1330,7 @@ uint16 resetProjectStorage ( void )
     DisplayStrCentered(LINE2,"Project directory");
     CyDelay(2000);
   }
+  deleteProjectsBy ( PROJ_DELETE_ALL, 0 );
   Err =  getProjectNumber (  );
   if ( Err != 0 )
   {
@@ -20,6 +20,8 @@
 #include "Project.h"
 #include "Globals.h"
 #include "Elite.h"
+#include "PulseCounter.h"
+#include "DataStructs.h"
 
 
 extern uint16 const countTime ;
@@ -27,23 +29,181 @@ extern uint16 const countTime ;
 volatile uint32 pulseCounts[2];
 volatile BOOL cntDone = FALSE;
 
+// reload bookkeeping, the reload ISR only runs once per pulseReload counts
+static uint16 pulseReload = PULSE_COUNTER_RELOAD;
+static volatile BOOL   cntRunning = FALSE;
+static volatile uint32 reloadIsrs[2];   // reload ISRs serviced this count
+static uint32 reloadWraps[2];           // counter wraps counted by the wrap counters
+static uint8  wrapLast[2];              // wrap counter value at the last fold
+static uint32 cntMs;                    // ms ticks since PulseCntStrt
+static BOOL   stampSet;                 // tickStamp holds the last ms tick of this count
+static uint32 tickStamp;                // SysTick on entry of the last ms tick
+static uint32 tickShotMs;               // one shot reading on entry of the last ms tick
+static uint32 tickLateUs;               // longest the ms tick was held off this count
+
+// the ms tick is stamped with SysTick, free running at the bus clock
+#define TICK_STAMP_MASK        CY_SYS_SYST_RVR_CNT_MASK
+#define TICK_STAMP_MAX_MS      200      // longer gaps are timed by the one shot, SysTick wraps in 262ms at 64MHz
+
+// sub-interval capture, filled from the 1ms timer while a count runs
+static pulse_bin_t pulseBins[PULSE_BIN_DEPTH];
+static volatile uint16 binTotal;        // bins closed since PulseCntStrt
+static volatile uint16 binHead;         // next slot to be written
+static volatile BOOL   binActive = FALSE;
+static uint16 binMs = 0;                // 0 = capture off
+static uint16 binElapsed;               // ms into the current bin
+static uint32 binLast[2];               // running totals at the last bin edge
+static uint32 binEdgeMs;                // count time at the last bin edge
+
+// count quality, running stats of the full length bins of each tube
+#define PQ_MIN_BINS            8        // bins before a single bin is judged
+#define PQ_MIN_MEAN            20.0     // counts per bin before a single bin is judged
+#define PQ_DROP_SIGMA          5.0
+#define PQ_BURST_SIGMA         6.0
+#define PQ_DISP_MIN_BINS       16       // bins before the dispersion is judged
+#define PQ_DISP_MIN_MEAN       50.0
+#define PQ_DISP_SIGMA          4.0
+#define PQ_DISP_MIN_LIMIT      0.5      // below this there are too few bins to judge, 129 or more
+#define PQ_DEAD_FRAC_MAX       0.10     // rate * tau past this is out of the linear region
+typedef struct
+{
+  uint16 n;
+  float  mean;
+  float  m2;                            // sum of squared deviations, Welford
+} pq_stats_t;
+static pq_stats_t pqStats[2];
+static uint16 pqSeen;                   // bins already judged this count
+static uint8  pqFlags;
+
+/*******************************************************************************
+* Function Name: readTubeCounter, readTubeWraps, clearTubeCounters
+********************************************************************************
+* Summary: The only places the count path touches the counter hardware, so
+*          a simulated pulse source only has to replace these three.
+*          Counter_GM_WRAP and Counter_HE3_WRAP are 8 bit counters clocked
+*          by the terminal count of the tube counters. They keep counting
+*          wraps while the interrupts are masked, when a second wrap of a
+*          tube counter finds its reload ISR already pending and is lost.
+*
+* Parameters:  tube  PROBE_GM_COUNT or PROBE_HE3_COUNT
+*
+* Return: counts in the hardware counter since its last reload, or the
+*         free running wrap count modulo 256
+*******************************************************************************/
+static uint32 readTubeCounter ( uint8 tube )
+{
+  return ( tube == PROBE_GM_COUNT ) ? Counter_GM_ReadCounter() : Counter_HE3_ReadCounter();
+}
+
+static uint8 readTubeWraps ( uint8 tube )
+{
+  return ( tube == PROBE_GM_COUNT ) ? Counter_GM_WRAP_ReadCounter() : Counter_HE3_WRAP_ReadCounter();
+}
+
+static void clearTubeCounters ( void )
+{
+  Counter_GM_WriteCounter(0);  
+  Counter_HE3_WriteCounter(0);  
+}
+
+
+/*******************************************************************************
+* Function Name: foldWraps
+********************************************************************************
+* Summary: Add the wraps the wrap counters took since the last fold to the
+*          reloads owed. The counters are 8 bit, so up to 255 wraps between
+*          two folds are counted, however long the ms tick was held off.
+*          Called from the ms tick and the one shot ISR.
+*
+* Parameters:  none
+*
+* Return: none
+*******************************************************************************/
+static void foldWraps ( void )
+{
+  uint8 w;
+
+  w = readTubeWraps(PROBE_GM_COUNT);
+  reloadWraps[PROBE_GM_COUNT] += (uint8)( w - wrapLast[PROBE_GM_COUNT] );
+  wrapLast[PROBE_GM_COUNT] = w;
+
+  w = readTubeWraps(PROBE_HE3_COUNT);
+  reloadWraps[PROBE_HE3_COUNT] += (uint8)( w - wrapLast[PROBE_HE3_COUNT] );
+  wrapLast[PROBE_HE3_COUNT] = w;
+}
+
+
+/*******************************************************************************
+* Function Name: closePulseBin
+********************************************************************************
+* Summary: Push the counts since the last bin edge into the ring buffer.
+*          Only called from the ms timer and one shot ISRs, which run at the
+*          same priority as the counter reload ISRs.
+*
+* Parameters:  gm, he3  running totals at this bin edge
+*
+* Return: none
+*******************************************************************************/
+static void closePulseBin ( uint32 gm, uint32 he3 )
+{
+  pulse_bin_t * bin = &pulseBins[binHead];
+
+  // a reload still pending behind us reads one reload low, the next bin picks it up
+  if ( gm < binLast[PROBE_GM_COUNT] )
+  {
+    gm = binLast[PROBE_GM_COUNT];
+  }
+  if ( he3 < binLast[PROBE_HE3_COUNT] )
+  {
+    he3 = binLast[PROBE_HE3_COUNT];
+  }
+  bin->gm  = gm  - binLast[PROBE_GM_COUNT];
+  bin->he3 = he3 - binLast[PROBE_HE3_COUNT];
+  bin->ms  = binElapsed;
+  binEdgeMs += binElapsed;
+
+  binLast[PROBE_GM_COUNT]  = gm;
+  binLast[PROBE_HE3_COUNT] = he3;
+  binElapsed = 0;
+
+  if ( ++binHead >= PULSE_BIN_DEPTH )
+  {
+    binHead = 0;
+  }
+  if ( binTotal < 0xFFFF )
+  {
+    binTotal++;
+  }
+}
+
  
 // After end of one shot pulse, read the remainder in the counters
 // Set the global countdown flag equal to TRUE
 CY_ISR(ISR_ONESHOT)
 {   
-  pulseCounts[PROBE_GM_COUNT] += Counter_GM_ReadCounter();
-  pulseCounts[PROBE_HE3_COUNT] += Counter_HE3_ReadCounter();
+  pulseCounts[PROBE_GM_COUNT] += readTubeCounter(PROBE_GM_COUNT);
+  pulseCounts[PROBE_HE3_COUNT] += readTubeCounter(PROBE_HE3_COUNT);
+  foldWraps();
+  cntRunning = FALSE;
+  if ( binActive )
+  {
+    binActive = FALSE;
+    if ( binElapsed )
+    {
+      closePulseBin ( pulseCounts[PROBE_GM_COUNT], pulseCounts[PROBE_HE3_COUNT] );
+    }
+  }
   cntDone = TRUE;
   ONE_SHOT_TIMER_Stop();
 }
 
-// counter reloads at 200, so add 200 to the reading
+// counter reloads at pulseReload, so add pulseReload to the reading
 CY_ISR ( ISR_GM )
 {
   
   Counter_GM_ReadStatusRegister();
-  pulseCounts[PROBE_GM_COUNT] += 200;
+  pulseCounts[PROBE_GM_COUNT] += pulseReload;
+  reloadIsrs[PROBE_GM_COUNT]++;
 }
 
 
@@ -51,7 +211,331 @@ CY_ISR ( ISR_HE3 )
 {
   
   Counter_HE3_ReadStatusRegister();
-  pulseCounts[PROBE_HE3_COUNT] += 200;
+  pulseCounts[PROBE_HE3_COUNT] += pulseReload;
+  reloadIsrs[PROBE_HE3_COUNT]++;
+}
+
+
+/*******************************************************************************
+* Function Name: stampTick
+********************************************************************************
+* Summary: Time this ms tick's entry against the last one. The tick fires
+*          every 1000us, so whatever the gap has on top of that the tick
+*          was held off by a masked section, and a reload ISR firing at
+*          the start of that section waited just as long. Gaps up to
+*          TICK_STAMP_MAX_MS are timed with SysTick, longer ones with the
+*          one shot, which counts the count time in hardware at 1ms.
+*
+* Parameters:  none
+*
+* Return: none
+*******************************************************************************/
+static void stampTick ( void )
+{
+  uint32 now  = CySysTickGetValue();
+  uint32 shot = ONE_SHOT_TIMER_ReadCounter();
+  uint32 gap;
+
+  if ( stampSet )
+  {
+    gap = ( tickShotMs - shot ) * ( 1000000 / PULSETIMERCLK );
+    if ( gap <= TICK_STAMP_MAX_MS * 1000 )
+    {
+      gap = ( ( tickStamp - now ) & TICK_STAMP_MASK ) / BCLK__BUS_CLK__MHZ;   // SysTick counts down
+    }
+    if ( ( gap > 1000 ) && ( gap - 1000 > tickLateUs ) )
+    {
+      tickLateUs = gap - 1000;
+    }
+  }
+  tickStamp  = now;
+  tickShotMs = shot;
+  stampSet   = TRUE;
+}
+
+
+/*******************************************************************************
+* Function Name: checkReloads
+********************************************************************************
+* Summary: Called every ms while a count runs.
+*
+* Parameters:  none
+*
+* Return: none
+*******************************************************************************/
+static void checkReloads ( void )
+{
+  cntMs++;
+  stampTick();
+  foldWraps();
+}
+
+
+/*******************************************************************************
+* Function Name: pulseBinTick
+********************************************************************************
+* Summary: Called every ms from MS_TIMER_ISR. While a count is running it
+*          closes a bin each time binMs has elapsed.
+*
+* Parameters:  none
+*
+* Return: none
+*******************************************************************************/
+void pulseBinTick ( void )
+{
+  if ( cntRunning )
+  {
+    checkReloads();
+  }
+  if ( !binActive )
+  {
+    return;
+  }
+  if ( ++binElapsed >= binMs )
+  {
+    closePulseBin ( pulseCounts[PROBE_GM_COUNT] + readTubeCounter(PROBE_GM_COUNT),
+                    pulseCounts[PROBE_HE3_COUNT] + readTubeCounter(PROBE_HE3_COUNT) );
+  }
+}
+
+
+/*******************************************************************************
+* Function Name: setPulseBinCapture
+********************************************************************************
+* Summary: Set the sub-interval length used from the next PulseCntStrt.
+*
+* Parameters:  bin_ms  bin length in ms, 0 turns the capture off
+*
+* Return: none
+*******************************************************************************/
+void setPulseBinCapture ( uint16 bin_ms )
+{
+  binMs = bin_ms;
+}
+
+
+/*******************************************************************************
+* Function Name: setPulseReload
+********************************************************************************
+* Summary: Set how many counts the hardware counters take between reload
+*          interrupts. The period is read back, so a value the counters are
+*          too narrow for is refused and the standard reload kept. Only call
+*          while no count is running.
+*
+* Parameters:  reload  counts per reload interrupt
+*
+* Return: TRUE if the counters took the new reload
+*******************************************************************************/
+uint8 setPulseReload ( uint16 reload )
+{
+  uint8 ok = TRUE;
+
+  Counter_GM_WritePeriod ( reload );
+  Counter_HE3_WritePeriod ( reload );
+  if ( ( Counter_GM_ReadPeriod() != reload ) || ( Counter_HE3_ReadPeriod() != reload ) )
+  {
+    reload = PULSE_COUNTER_RELOAD;
+    Counter_GM_WritePeriod ( reload );
+    Counter_HE3_WritePeriod ( reload );
+    ok = FALSE;
+  }
+  pulseReload = reload;
+
+  return ok;
+}
+
+
+/*******************************************************************************
+* Function Name: getPulseReload
+********************************************************************************
+* Summary: Counts per reload interrupt in use.
+*
+* Parameters:  none
+*
+* Return: reload value
+*******************************************************************************/
+uint16 getPulseReload ( void )
+{
+  return pulseReload;
+}
+
+
+/*******************************************************************************
+* Function Name: getPulseIsrStats
+********************************************************************************
+* Summary: Copy the reload interrupt figures of the running or last count.
+*
+* Parameters:  stats  destination
+*
+* Return: none
+*******************************************************************************/
+void getPulseIsrStats ( pulse_isr_stats_t * stats )
+{
+  Global_ID();
+  stats->serviced[PROBE_GM_COUNT]  = reloadIsrs[PROBE_GM_COUNT];
+  stats->serviced[PROBE_HE3_COUNT] = reloadIsrs[PROBE_HE3_COUNT];
+  stats->expected[PROBE_GM_COUNT]  = reloadWraps[PROBE_GM_COUNT];
+  stats->expected[PROBE_HE3_COUNT] = reloadWraps[PROBE_HE3_COUNT];
+  stats->counts[PROBE_GM_COUNT]    = pulseCounts[PROBE_GM_COUNT];
+  stats->counts[PROBE_HE3_COUNT]   = pulseCounts[PROBE_HE3_COUNT];
+  stats->worst_us = tickLateUs;
+  stats->ms     = cntMs;
+  stats->reload = pulseReload;
+  Global_IE();
+}
+
+
+/*******************************************************************************
+* Function Name: getPulseIsrRate
+********************************************************************************
+* Summary: Reload interrupts per second over the count.
+*
+* Parameters:  stats  from getPulseIsrStats
+*              tube   PROBE_GM_COUNT or PROBE_HE3_COUNT
+*
+* Return: interrupts per second
+*******************************************************************************/
+uint32 getPulseIsrRate ( const pulse_isr_stats_t * stats, uint8 tube )
+{
+  if ( stats->ms == 0 )
+  {
+    return 0;
+  }
+  return (uint32)( ( (uint64)stats->serviced[tube] * 1000 ) / stats->ms );
+}
+
+
+/*******************************************************************************
+* Function Name: getMissedReloads
+********************************************************************************
+* Summary: Counter wraps with no matching reload ISR, each one lost
+*          stats->reload counts.
+*
+* Parameters:  stats  from getPulseIsrStats
+*              tube   PROBE_GM_COUNT or PROBE_HE3_COUNT
+*
+* Return: number of missed reloads
+*******************************************************************************/
+uint32 getMissedReloads ( const pulse_isr_stats_t * stats, uint8 tube )
+{
+  if ( stats->expected[tube] > stats->serviced[tube] )
+  {
+    return stats->expected[tube] - stats->serviced[tube];
+  }
+  return 0;
+}
+
+
+/*******************************************************************************
+* Function Name: getWorstIsrLatencyUs
+********************************************************************************
+* Summary: Worst interrupt entry latency of the count, the longest the
+*          ms tick was held off. A reload ISR can wait as long.
+*
+* Parameters:  stats  from getPulseIsrStats
+*
+* Return: latency in us
+*******************************************************************************/
+uint32 getWorstIsrLatencyUs ( const pulse_isr_stats_t * stats )
+{
+  return stats->worst_us;
+}
+
+
+/*******************************************************************************
+* Function Name: checkPulseIntegrity
+********************************************************************************
+* Summary: A tube's count is not trusted when a reload went missing or the
+*          worst masked section was long enough for the tube to fill
+*          reload / PULSE_LATE_DIVISOR counts at its rate over the count,
+*          so one a little longer would have lost a reload.
+*
+* Parameters:  stats  from getPulseIsrStats
+*              tube   PROBE_GM_COUNT or PROBE_HE3_COUNT
+*
+* Return: TRUE if the count of the tube is sound
+*******************************************************************************/
+uint8 checkPulseIntegrity ( const pulse_isr_stats_t * stats, uint8 tube )
+{
+  uint64 window = (uint64)stats->counts[tube] * stats->worst_us;             // counts in the window times ms * 1000
+
+  return ( getMissedReloads ( stats, tube ) == 0 ) && ( window < (uint64)stats->ms * 1000 * ( stats->reload / PULSE_LATE_DIVISOR ) );
+}
+
+
+/*******************************************************************************
+* Function Name: getPulseBinTotal
+********************************************************************************
+* Summary: Number of bins closed since the count was started. Only the last
+*          PULSE_BIN_DEPTH of them are still held in the ring buffer.
+*
+* Parameters:  none
+*
+* Return: bin count
+*******************************************************************************/
+uint16 getPulseBinTotal ( void )
+{
+  return binTotal;
+}
+
+
+/*******************************************************************************
+* Function Name: getPulseBinEdge
+********************************************************************************
+* Summary: Counts accumulated up to the last closed bin. Unlike the ring
+*          buffer this covers the whole count, however long it is.
+*
+* Parameters:  gm, he3  returned counts since PulseCntStrt
+*
+* Return: count time in ms covered by gm and he3
+*******************************************************************************/
+uint32 getPulseBinEdge ( uint32 * gm, uint32 * he3 )
+{
+  uint32 ms;
+
+  Global_ID();
+  *gm  = binLast[PROBE_GM_COUNT];
+  *he3 = binLast[PROBE_HE3_COUNT];
+  ms   = binEdgeMs;
+  Global_IE();
+
+  return ms;
+}
+
+
+/*******************************************************************************
+* Function Name: readPulseBins
+********************************************************************************
+* Summary: Copy the newest bins out of the ring buffer, oldest first. Safe to
+*          call while the count is still running.
+*
+* Parameters:  bins      destination
+*              max_bins  size of the destination
+*
+* Return: number of bins copied
+*******************************************************************************/
+uint16 readPulseBins ( pulse_bin_t * bins, uint16 max_bins )
+{
+  uint16 n, i, slot;
+
+  Global_ID();
+  n = ( binTotal < PULSE_BIN_DEPTH ) ? binTotal : PULSE_BIN_DEPTH;
+  if ( n > max_bins )
+  {
+    n = max_bins;
+  }
+  slot = ( binHead + PULSE_BIN_DEPTH - n ) % PULSE_BIN_DEPTH;
+  for ( i = 0; i < n; i++ )
+  {
+    bins[i] = pulseBins[slot];
+    if ( ++slot >= PULSE_BIN_DEPTH )
+    {
+      slot = 0;
+    }
+  }
+  Global_IE();
+
+  return n;
 }
 
 
@@ -147,6 +631,8 @@ void stop_ONE_SHOT_Early ( void )
   ONE_SHOT_TIMER_WriteCounter(0);
   ONE_SHOT_RESET_Write(1);			// Put ONE_SHOT in reset
   isrOneShot_ClearPending();
+  binActive = FALSE;
+  cntRunning = FALSE;
 }
 
 
@@ -163,10 +649,17 @@ void initPulseCntStrt( void )
 {
     initOneShotTimer();
     Counter_GM_Start(); //Init();
+    Counter_GM_WRAP_Start();
     isr_GM_StartEx(ISR_GM);
     Counter_HE3_Start(); //Init();
+    Counter_HE3_WRAP_Start();
     isr_HE3_StartEx(ISR_HE3);
+    CySysTickStart();                         // free running stamp for the ms tick, no interrupt
+    CySysTickDisableInterrupt();
+    CySysTickSetReload ( TICK_STAMP_MASK );
     ONE_SHOT_TIMER_Start();
+    setPulseBinCapture ( PULSE_BIN_MS_DEFAULT );
+    setPulseReload ( PULSE_COUNTER_RELOAD_WIDE );  // falls back to 200 on 8 bit counters
   
 }
 
@@ -190,11 +683,35 @@ void PulseCntStrt( float timeSec )
   pulseCounts[PROBE_HE3_COUNT] = 0;
   
   // clear hardware to zero
-  Counter_GM_WriteCounter(0);  
-  Counter_HE3_WriteCounter(0);  
+  clearTubeCounters();
+  
+  pulseCounts[PROBE_GM_COUNT] += readTubeCounter(PROBE_GM_COUNT);
+  pulseCounts[PROBE_HE3_COUNT] += readTubeCounter(PROBE_HE3_COUNT);
+  
+  // start a fresh time series
+  binActive = FALSE;
+  binTotal = 0;
+  binHead = 0;
+  binElapsed = 0;
+  binEdgeMs = 0;
+  binLast[PROBE_GM_COUNT]  = pulseCounts[PROBE_GM_COUNT];
+  binLast[PROBE_HE3_COUNT] = pulseCounts[PROBE_HE3_COUNT];
+  binActive = ( binMs != 0 );
+  memset ( pqStats, 0, sizeof(pqStats) );
+  pqSeen  = 0;
+  pqFlags = 0;
   
-  pulseCounts[PROBE_GM_COUNT] += Counter_GM_ReadCounter();
-  pulseCounts[PROBE_HE3_COUNT] += Counter_HE3_ReadCounter();
+  // start the reload cross check
+  reloadIsrs[PROBE_GM_COUNT]  = 0;
+  reloadIsrs[PROBE_HE3_COUNT] = 0;
+  stampSet   = FALSE;
+  tickLateUs = 0;
+  reloadWraps[PROBE_GM_COUNT]  = 0;
+  reloadWraps[PROBE_HE3_COUNT] = 0;
+  wrapLast[PROBE_GM_COUNT]  = readTubeWraps(PROBE_GM_COUNT);
+  wrapLast[PROBE_HE3_COUNT] = readTubeWraps(PROBE_HE3_COUNT);
+  cntMs = 0;
+  cntRunning = TRUE;
   
   triggerOneShotPulse ( ms );
     
@@ -234,6 +751,302 @@ uint32 getHEPulseCounts ( void )
 }
 
 
+/*******************************************************************************
+* Function Name: readNewPulseBins
+********************************************************************************
+* Summary: Copy the bins closed since the caller last looked, oldest first.
+*          Bins that have already left the ring buffer are skipped.
+*
+* Parameters:  seen      bins already consumed, updated on return. Set it to
+*                        0 whenever a new count is started.
+*              bins      destination
+*              max_bins  size of the destination
+*
+* Return: number of bins copied
+*******************************************************************************/
+uint16 readNewPulseBins ( uint16 * seen, pulse_bin_t * bins, uint16 max_bins )
+{
+  uint16 pending, n, i, slot;
+
+  Global_ID();
+  if ( *seen > binTotal )
+  {
+    *seen = binTotal;
+  }
+  pending = binTotal - *seen;
+  if ( pending > PULSE_BIN_DEPTH )      // overwritten before they were read
+  {
+    *seen += pending - PULSE_BIN_DEPTH;
+    pending = PULSE_BIN_DEPTH;
+  }
+  n = ( pending < max_bins ) ? pending : max_bins;
+  slot = ( binHead + PULSE_BIN_DEPTH - pending ) % PULSE_BIN_DEPTH;
+  for ( i = 0; i < n; i++ )
+  {
+    bins[i] = pulseBins[slot];
+    if ( ++slot >= PULSE_BIN_DEPTH )
+    {
+      slot = 0;
+    }
+  }
+  *seen += n;
+  Global_IE();
+
+  return n;
+}
+
+
+/*******************************************************************************
+* Function Name: deadTimeTrueRate
+********************************************************************************
+* Summary: Recover the true count rate n from the measured rate m.
+*          Non-paralyzable: m = n / (1 + n*tau)  ->  n = m / (1 - m*tau)
+*          Paralyzable:     m = n * exp(-n*tau), solved by Newton's method on
+*          the low rate branch (n*tau < 1).
+*          A measured rate at or past the model's limit returns the largest
+*          rate the model can explain.
+*
+* Parameters:  rate   measured counts per second
+*              tau_s  dead time in seconds
+*              model  DEAD_TIME_xxx
+*
+* Return: true counts per second
+*******************************************************************************/
+float deadTimeTrueRate ( float rate, float tau_s, uint8 model )
+{
+  float x, n, e;
+  uint8 i;
+
+  x = rate * tau_s;
+  if ( ( tau_s <= 0 ) || ( rate <= 0 ) )
+  {
+    return rate;
+  }
+
+  switch ( model )
+  {
+    case DEAD_TIME_NON_PARALYZABLE:
+      if ( x > 0.95 )
+      {
+        x = 0.95;
+      }
+      return rate / ( 1.0 - x );
+
+    case DEAD_TIME_PARALYZABLE:
+      if ( x >= 0.3678 )                // peak of n*exp(-n*tau) is 1/(e*tau)
+      {
+        return 1.0 / tau_s;
+      }
+      n = rate / ( 1.0 - x );           // non-paralyzable guess is close
+      for ( i = 0; i < 8; i++ )
+      {
+        e = exp ( -n * tau_s );
+        n -= ( n * e - rate ) / ( e * ( 1.0 - n * tau_s ) );
+        if ( n * tau_s >= 1.0 )
+        {
+          n = 1.0 / tau_s;
+          break;
+        }
+      }
+      return n;
+
+    default:
+      return rate;
+  }
+}
+
+
+/*******************************************************************************
+* Function Name: deadTimeCorrect
+********************************************************************************
+* Summary: Dead time correction stage between the counters and the density
+*          and moisture math. Uses the model and per tube dead time kept in
+*          EEPROM, so standard and field counts are corrected alike.
+*
+* Parameters:  counts  raw counts
+*              ms      count time the counts were collected over
+*              tube    PROBE_GM_COUNT or PROBE_HE3_COUNT
+*
+* Return: corrected counts over the same time
+*******************************************************************************/
+uint32 deadTimeCorrect ( uint32 counts, uint32 ms, uint8 tube )
+{
+  uint8 model = NV_RAM_MEMBER_RD ( DT_MODEL );
+  float tau_us, secs;
+
+  if ( ( model == DEAD_TIME_OFF ) || ( model > DEAD_TIME_PARALYZABLE ) || ( ms == 0 ) )
+  {
+    return counts;
+  }
+  tau_us = ( tube == PROBE_GM_COUNT ) ? NV_RAM_MEMBER_RD ( DT_TAU_GM ) : NV_RAM_MEMBER_RD ( DT_TAU_HE3 );
+  if ( !( tau_us > 0 ) || ( tau_us > DEAD_TIME_MAX_US ) )  // also catches NaN from blank EEPROM
+  {
+    return counts;
+  }
+  secs = ms / 1000.0;
+
+  return (uint32)( deadTimeTrueRate ( counts / secs, tau_us * 1.0e-6, model ) * secs + 0.5 );
+}
+
+
+/*******************************************************************************
+* Function Name: pulseQualityBin
+********************************************************************************
+* Summary: Judge one full length bin of one tube against the bins before it.
+*          For Poisson counts the spread of a bin is sqrt(mean), so a bin
+*          PQ_DROP_SIGMA below or PQ_BURST_SIGMA above the running mean is
+*          flagged. A flagged bin is kept out of the running stats so one
+*          outlier does not hide the next.
+*
+* Parameters:  tube    PROBE_GM_COUNT or PROBE_HE3_COUNT
+*              counts  counts in the bin
+*
+* Return: none
+*******************************************************************************/
+static void pulseQualityBin ( uint8 tube, uint32 counts )
+{
+  pq_stats_t * s = &pqStats[tube];
+  float x = counts, sd, d;
+
+  if ( ( s->n >= PQ_MIN_BINS ) && ( s->mean >= PQ_MIN_MEAN ) )
+  {
+    sd = sqrtf ( s->mean );
+    if ( x < s->mean - PQ_DROP_SIGMA * sd )
+    {
+      pqFlags |= PQ_DROPOUT << PQ_TUBE_SHIFT(tube);
+      return;
+    }
+    if ( x > s->mean + PQ_BURST_SIGMA * sd )
+    {
+      pqFlags |= PQ_BURST << PQ_TUBE_SHIFT(tube);
+      return;
+    }
+  }
+  s->n++;
+  d = x - s->mean;
+  s->mean += d / s->n;
+  s->m2   += d * ( x - s->mean );
+}
+
+
+/*******************************************************************************
+* Function Name: pulseQualityUpdate
+********************************************************************************
+* Summary: Judge the bins closed since the last call. Call it at least once
+*          per PULSE_BIN_DEPTH bins while a count runs, the count loop polls
+*          it every 250ms. The short last bin of a count is not judged.
+*
+* Parameters:  none
+*
+* Return: none
+*******************************************************************************/
+void pulseQualityUpdate ( void )
+{
+  pulse_bin_t bins[16];
+  uint16 n, i;
+
+  if ( binMs == 0 )
+  {
+    return;
+  }
+  while ( ( n = readNewPulseBins ( &pqSeen, bins, 16 ) ) > 0 )
+  {
+    for ( i = 0; i < n; i++ )
+    {
+      if ( bins[i].ms == binMs )
+      {
+        pulseQualityBin ( PROBE_GM_COUNT, bins[i].gm );
+        pulseQualityBin ( PROBE_HE3_COUNT, bins[i].he3 );
+      }
+    }
+  }
+}
+
+
+/*******************************************************************************
+* Function Name: getPulseQuality
+********************************************************************************
+* Summary: Quality flags of the last count. A tube failing the reload
+*          cross check is flagged PQ_RELOAD. On top of the bin checks each
+*          tube is flagged non-linear when
+*           - the bins spread much less than Poisson (var/mean well under 1),
+*             which is what dead time and pile-up do to a saturating tube;
+*             with fewer than 129 full bins the limit is too loose to mean
+*             anything and this check is skipped,
+*           - rate * tau from EEPROM is past PQ_DEAD_FRAC_MAX, or
+*           - the rate is near the one wrap per ms the reload check can see.
+*
+* Parameters:  none
+*
+* Return: PQ_xxx flags, GM in the low nibble, He3 in the high nibble
+*******************************************************************************/
+uint8 getPulseQuality ( void )
+{
+  uint8 tube;
+  float disp, limit, rate, tau_us;
+  pq_stats_t * s;
+  pulse_isr_stats_t isr;
+
+  pulseQualityUpdate();
+  getPulseIsrStats ( &isr );
+  for ( tube = PROBE_GM_COUNT; tube <= PROBE_HE3_COUNT; tube++ )
+  {
+    if ( !checkPulseIntegrity ( &isr, tube ) )
+    {
+      pqFlags |= PQ_RELOAD << PQ_TUBE_SHIFT(tube);
+    }
+    s = &pqStats[tube];
+    if ( s->n < 2 )
+    {
+      continue;
+    }
+    if ( ( s->n >= PQ_DISP_MIN_BINS ) && ( s->mean >= PQ_DISP_MIN_MEAN ) )
+    {
+      disp  = ( s->m2 / ( s->n - 1 ) ) / s->mean;
+      limit = 1.0 - PQ_DISP_SIGMA * sqrtf ( 2.0 / ( s->n - 1 ) );
+      if ( ( limit >= PQ_DISP_MIN_LIMIT ) && ( disp < limit ) )
+      {
+        pqFlags |= PQ_NONLINEAR << PQ_TUBE_SHIFT(tube);
+      }
+    }
+    rate   = s->mean * 1000.0 / binMs;  // counts per second
+    tau_us = ( tube == PROBE_GM_COUNT ) ? NV_RAM_MEMBER_RD ( DT_TAU_GM ) : NV_RAM_MEMBER_RD ( DT_TAU_HE3 );
+    if ( ( ( tau_us > 0 ) && ( tau_us <= DEAD_TIME_MAX_US ) && ( rate * tau_us * 1.0e-6 > PQ_DEAD_FRAC_MAX ) )
+         || ( rate > pulseReload * 500.0 ) )
+    {
+      pqFlags |= PQ_NONLINEAR << PQ_TUBE_SHIFT(tube);
+    }
+  }
+
+  return pqFlags;
+}
+
+
+/*******************************************************************************
+* Function Name: pulseQualityText
+********************************************************************************
+* Summary: One LCD line for the quality flags, worst flag of each tube,
+*          e.g. "QC D:DROP  M:OK".
+*
+* Parameters:  quality  flags from getPulseQuality
+*              str      at least 21 chars
+*
+* Return: none
+*******************************************************************************/
+void pulseQualityText ( uint8 quality, char * str )
+{
+  const char * name[2];
+  uint8 tube, q;
+
+  for ( tube = PROBE_GM_COUNT; tube <= PROBE_HE3_COUNT; tube++ )
+  {
+    q = PQ_FLAGS ( quality, tube );
+    name[tube] = ( q & PQ_RELOAD ) ? "ISR" : ( q & PQ_DROPOUT ) ? "DROP" : ( q & PQ_NONLINEAR ) ? "SAT" : ( q & PQ_BURST ) ? "NOISE" : "OK";
+  }
+  sprintf ( str, "QC D:%-5s M:%s", name[PROBE_GM_COUNT], name[PROBE_HE3_COUNT] );
+}
+
+
 /* [] END OF FILE */
 
 /* [] END OF FILE */
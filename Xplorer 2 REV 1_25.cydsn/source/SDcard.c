@@ -11,9 +11,11 @@
 */
 
 #include "stdio.h"
+#include <stddef.h> /* for offsetof */
 #include "SDcard.h"
 #include "Keypad_functions.h"
 #include "LCD_drivers.h"
+#include "ProjectData.h"
 
 char fname[255]; 
 int8 sdOpened = OFF;
@@ -48,6 +50,8 @@ int32 SD_FormatHi(void)
    fs_info.NumRootDirEntries = 256;
    fs_info.SectorsPerCluster = 64;
    fs_info.pDevInfo = NULL;
+   projSessionClose ( );
+   stationDirInvalidate ( );
    err = FS_GetVolumeName (0,buf,50);
 
    CLEAR_DISP;
@@ -106,7 +110,8 @@ int32 CheckEmptyDirectory(char *path,char *name,int32 nameLen)
 /*******************************************************************************
 * Function Name: RemoveDir
 ********************************************************************************
-* Summary: 
+* Summary: removes every file in a directory in one pass, then the directory.
+*          FS_RmDir refuses a directory that is not empty, so no count first.
 * Parameters:  char *path = directory to remove
 * Return: 0 if successful, else 1
 *******************************************************************************/
@@ -116,49 +121,33 @@ uint8 RemoveDir(char * path)
    FS_FIND_DATA pfd;
    char fullpath[50],name[30];
   
-   // if there are files in the directory, remove them
-   if( SD_FindTotalFiles(path,false) != 0 ) 
-   { 
-  
-    FS_FindFirstFile(&pfd,path,name,sizeof(name)); // find the first file in the directory.
-    do 
-    {
-     // if this is a file and not a sub-directry, delete the file. THERE SHOULD BE NO SUB DIRECTORIES
-     if( ( pfd.Attributes & FS_ATTR_DIRECTORY ) != FS_ATTR_DIRECTORY ) 
-     {
-      snprintf(fullpath,50,"%s\\%s",path,name);
-      FS_Remove(fullpath);
-     }
-       
-      // == 1: File found in directory.
-      // == 0: In case of any error.
-      res = FS_FindNextFile(&pfd); //puts new file name into name array
-    } while(res == 1);
-    
-    FS_FindClose(&pfd); // Close the dir search
-   }
-
-   if( SD_FindTotalFiles(path,false) == 0 )  
+   projSessionClose ( );
+   stationDirInvalidate ( );
+   // remove the files while walking the directory
+   res = ( FS_FindFirstFile(&pfd,path,name,sizeof(name)) == 0 ); // find the first file in the directory.
+   while(res == 1)
    {
-    if(FS_RmDir(path) != 0)
+    // if this is a file and not a sub-directry, delete the file. THERE SHOULD BE NO SUB DIRECTORIES
+    if( ( pfd.Attributes & FS_ATTR_DIRECTORY ) != FS_ATTR_DIRECTORY ) 
     {
-      CLEAR_DISP;
-      LCD_position(LINE1 + 8); 
-      _LCD_PRINT("Error");
-      LCD_position(LINE2);
-      _LCD_PRINT("SD ERROR RMDIR");
-      CyDelay ( 2000 );
-      error = 1;
-    }
-    else
-    {
-     error = 0;
+     snprintf(fullpath,50,"%s\\%s",path,name);
+     FS_Remove(fullpath);
     }
-      
-   } 
-   else
+    // == 1: File found in directory.
+    // == 0: In case of any error.
+    res = FS_FindNextFile(&pfd); //puts new file name into name array
+   }
+   FS_FindClose(&pfd); // Close the dir search
+
+   if(FS_RmDir(path) != 0)
    {
-    error = 1;
+     CLEAR_DISP;
+     LCD_position(LINE1 + 8); 
+     _LCD_PRINT("Error");
+     LCD_position(LINE2);
+     _LCD_PRINT("SD ERROR RMDIR");
+     CyDelay ( 2000 );
+     error = 1;
    }
    return error;
 }
@@ -324,57 +313,157 @@ int32 SD_FindFile ( int32 num, char* dir, char* fname, bool directory)
    return 1;
 }
 /*******************************************************************************
-* Function Name: SDstart()
+* Card manager. The volume is mounted by the first user and then left
+* mounted, with the project sessions open, while the card stays in use.
+* SDstart takes a reference and every SDstart is paired with exactly one
+* SDstop; SD_Wake only makes sure the volume is mounted. SDidle, from the
+* main loop, unmounts and sleeps the card once no reference is held and
+* SD_IDLE_UNMOUNT_MS have passed since the last use, or at once if the
+* card is pulled. SDunmount is for shutdown and for callers that need a
+* fresh mount, a reference still held remounts on the next use.
+*******************************************************************************/
+static uint8  sdRefs;
+static uint32 sdUsedMs;
+static sd_mount_stats_t sdMountStats;
+
+/*******************************************************************************
+* Function Name: sdMount()
 ********************************************************************************
-* Summary: raises sd wake and reset lines, starts uart and interrupt
-* Parameters:  none
-* Return: none
+* Summary: wakes the card and mounts the volume if it isn't mounted. A card
+*          pulled since the mount is unmounted first, its handles are gone.
 *******************************************************************************/
-void SDstart()
+static void sdMount ( void )
 {
+  sdUsedMs = msTimer;
+  if ( ( sdOpened == ON ) && ( SD_CARD_DETECT_Read() == SD_CARD_OUT ) )
+  {
+    SDunmount ( );
+  }
+  if ( sdOpened == ON )
+  {
+    sdMountStats.reuses++;
+    return;
+  }
   sdOpened = ON;
+  sdMountStats.mounts++;
   CyDelay(50);
   FS_Init();
   FS_FAT_SupportLFN();
+  emFile_1_Wakeup();
 }
 /*******************************************************************************
-* Function Name: SDstop
+* Function Name: SDstart()
 ********************************************************************************
-* Summary: Stops sd reset low,wakeup low,pwr ctrl low
+* Summary: takes a reference on the card, mounting it on first use
 * Parameters:  none
 * Return: none
 *******************************************************************************/
+void SDstart()
+{
+  sdMount ( );
+  if ( sdRefs < 0xFF )
+  {
+    sdRefs++;
+  }
+}
+/*******************************************************************************
+* Function Name: SDstop
+********************************************************************************
+* Summary: closes file if given, writes back the SD cache and gives back a
+*          reference on the card. The card stays mounted until SDidle finds
+*          it unused.
+* Parameters:  file to close, or null
+* Return: none
+*******************************************************************************/
 void SDstop(FS_FILE *file)
 {
  if ( sdOpened == ON )
  {
-  sdOpened = OFF;
-   
-   if(file != null) { 
-      FS_FClose(file); 
-   }
+  if ( file != null )
+  {
+   SDcacheClose(file);
+   FS_FClose(file); 
+  }
+  SDcacheFlush(null);
+  FS_Sync("");
+ }
+ if ( sdRefs > 0 )
+ {
+  sdRefs--;
+ }
+ else
+ {
+  sdMountStats.unpaired++;  // a stop with no start, the pairing is broken
+ }
+ sdUsedMs = msTimer;
+}
+/*******************************************************************************
+* Function Name: SDunmount
+********************************************************************************
+* Summary: writes everything back, unmounts the volume and sleeps the card
+* Parameters:  none
+* Return: none
+*******************************************************************************/
+void SDunmount ( void )
+{
+ projSessionClose ( );  // handles don't survive FS_DeInit
+ if ( sdOpened == ON )
+ {
+  sdMountStats.unmounts++;
   emFile_1_Sleep(); // This also calls emFIle_saveConfig()
-
   FS_DeInit();
+  sdOpened = OFF;   // last, a power off request seeing OFF cuts the power at once
  } 
 }
+/*******************************************************************************
+* Function Name: SDidle
+********************************************************************************
+* Summary: called from the main loop, unmounts the card once no reference
+*          is held and it has been idle for SD_IDLE_UNMOUNT_MS.
+* Parameters:  none
+* Return: none
+*******************************************************************************/
+void SDidle ( void )
+{
+ if ( sdOpened == OFF )
+ {
+  return;
+ }
+ if ( SD_CARD_DETECT_Read() == SD_CARD_OUT )
+ {
+  SDunmount ( );
+  return;
+ }
+ if ( ( sdRefs == 0 ) && ( ( msTimer - sdUsedMs ) > SD_IDLE_UNMOUNT_MS ) )
+ {
+  SDunmount ( );
+ }
+}
+/*******************************************************************************
+* Function Name: getSDmountStats()
+********************************************************************************
+* Summary:     mounts against uses that found the card already mounted
+* Parameters:  destination, TRUE to clear the figures after the copy
+*******************************************************************************/
+void getSDmountStats ( sd_mount_stats_t * stats, uint8 reset )
+{
+   *stats = sdMountStats;
+   if ( reset )
+   {
+      memset ( &sdMountStats, 0, sizeof(sdMountStats) );
+   }
+}
 
 /*******************************************************************************
 * Function Name: SD_Wake()
 ********************************************************************************
-* Summary: raises sd wake and reset lines, starts uart and interrupt
+* Summary: makes sure the card is mounted, without taking a reference
 * Parameters:  none
 * Return: none
 *******************************************************************************/
 void SD_Wake()
 {
-  if ( sdOpened == OFF )
-  {
-    sdOpened = ON;
-    FS_Init();
-    FS_FAT_SupportLFN();
-    emFile_1_Wakeup();
-  }
+  sdMount ( );
 }
 
 /*******************************************************************************
@@ -430,6 +519,8 @@ FS_FILE* SD_CreateProjectSimpleFile (char* str)
     return null;
   }
   
+  projSessionClose ( );      // a project of this name is being replaced
+  stationDirInvalidate ( );
   snprintf(buf,50,"Project\\%s",str);
   file = FS_FOpen(buf,"wb+");
   // write dummy values to project data.
@@ -468,10 +559,44 @@ FS_FILE* SD_CreateProjectSimpleFile (char* str)
     }
   }
 
+  projLogInit ( file );      // new projects are journals
   FS_FClose ( file );
+  catalogUpdate ( str );
   return file;
 }
 
+/*******************************************************************************
+* Function Name: SD_AppendLog()
+********************************************************************************
+* Summary:     Appends a line of text to a log file in the SD root, under
+*              its own reference on the card.
+* Parameters:  file name, line of text without line end
+* Return:      1 if written, 0 on error
+*******************************************************************************/
+uint8 SD_AppendLog ( char * fname, char * line )
+{
+   FS_FILE *file = null;
+   char buf[30];
+   uint8 res = 0;
+   int32 len;
+
+   if ( SD_CARD_DETECT_Read() == SD_CARD_OUT )
+   {
+      return 0;
+   }
+   SDstart();
+   snprintf ( buf, 30, "\\%s", fname );
+   file = FS_FOpen ( buf, "a" );
+   if ( file != null )
+   {
+      len = strlen ( line );
+      res = ( FS_Write ( file, line, len ) == len ) && ( FS_Write ( file, "\r\n", 2 ) == 2 );
+      FS_FClose ( file );
+   }
+   SDstop ( null );
+   return res;
+}
+
 /*******************************************************************************
 * Function Name: SD_CheckIfProjExists()
 ********************************************************************************
@@ -511,6 +636,7 @@ void SD_Diag(void)
  	FS_FILE *SDfile = null;
 	char buf[11],buffer[20];
 	uint32 err;
+  sd_mount_stats_t mounts;
   int8 flag;
   if ( SD_CARD_DETECT_Read() == SD_CARD_OUT) 
   {
@@ -606,7 +732,10 @@ void SD_Diag(void)
       DisplayStrCentered(LINE4,SD_Str[SDFAILED]);
       CyDelay(1000);
    }
-  
+   getSDmountStats ( &mounts, FALSE );
+   snprintf ( buffer, sizeof(buffer), "Mnt %u Use %u", mounts.mounts, mounts.reuses );
+   DisplayStrCentered(LINE3,buffer);
+   CyDelay(1500);
   
 SD_DIAG_EXIT:
    CyDelay(250);
@@ -658,6 +787,256 @@ int32 SDreadBuffer(FS_FILE *file,char *buf,int32 len)
 }
 
 
+/*******************************************************************************
+* Sector cache. Project files are read and written a few bytes at a time and
+* emFile is built without its own cache or file buffer, so each of those
+* calls was a sector read-modify-write on the card. The cache keeps one
+* sector of each open project in RAM: reads are served from it, which reads
+* ahead for a sequential pass, and writes gather in it until SDcacheFlush,
+* the file is closed, SDunmount, or SD_CACHE_FLUSH_MS after the last write.
+* Files it holds must only be read and written through it.
+*******************************************************************************/
+typedef struct
+{
+   FS_FILE * file;
+   uint32    base;                      // file offset of data[0], sector aligned
+   uint16    len;                       // valid bytes in data
+   uint16    dirty_lo, dirty_hi;        // bytes to write back, none if equal
+   uint32    used_ms;
+   uint8     data[SD_CACHE_SECTOR];
+} sd_cache_t;
+static sd_cache_t sdCache[SD_CACHE_SLOTS];
+static sd_cache_stats_t sdCacheStats;
+
+/*******************************************************************************
+* Function Name: sdCacheWriteBack()
+********************************************************************************
+* Summary:     Writes the dirty bytes of a slot to the file in one write
+* Return:      0 success -1 error
+*******************************************************************************/
+static int32 sdCacheWriteBack ( sd_cache_t * c )
+{
+   int32 n;
+   uint16 lo = c->dirty_lo;
+   if ( c->dirty_hi == c->dirty_lo )
+   {
+      return 0;
+   }
+   n = c->dirty_hi - c->dirty_lo;
+   c->dirty_lo = c->dirty_hi = 0;
+   sdCacheStats.fs_writes++;
+   FS_FSeek ( c->file, c->base + lo, FS_SEEK_SET );
+   return ( FS_Write ( c->file, &c->data[lo], n ) == n ) ? 0 : -1;
+}
+
+/*******************************************************************************
+* Function Name: sdCacheSector()
+********************************************************************************
+* Summary:     The slot holding the sector of file at offset, loading it into
+*              the file's slot or the least recently used one if needed
+* Return:      slot, null on error
+*******************************************************************************/
+static sd_cache_t * sdCacheSector ( FS_FILE * file, uint32 offset )
+{
+   sd_cache_t * c = null;
+   uint32 base = offset & ~( (uint32)SD_CACHE_SECTOR - 1 );
+   uint8 i;
+   for ( i = 0; i < SD_CACHE_SLOTS; i++ )
+   {
+      if ( sdCache[i].file == file )
+      {
+         c = &sdCache[i];
+         break;
+      }
+      if ( ( c == null ) || ( sdCache[i].file == null ) || ( ( c->file != null ) && ( sdCache[i].used_ms < c->used_ms ) ) )
+      {
+         c = &sdCache[i];
+      }
+   }
+   c->used_ms = msTimer;
+   if ( ( c->file == file ) && ( c->base == base ) )
+   {
+      return c;
+   }
+   if ( ( c->file != null ) && ( sdCacheWriteBack ( c ) != 0 ) )
+   {
+      return null;
+   }
+   c->file = file;
+   c->base = base;
+   c->len  = 0;
+   sdCacheStats.fs_reads++;
+   if ( FS_FSeek ( file, base, FS_SEEK_SET ) == 0 )
+   {
+      c->len = FS_Read ( file, c->data, SD_CACHE_SECTOR );  // short at the end of the file
+   }
+   return c;
+}
+
+/*******************************************************************************
+* Function Name: SDcacheRead()
+********************************************************************************
+* Summary:     Reads len bytes at offset of a file through the cache
+* Return:      0 success -1 error or past the end of the file
+*******************************************************************************/
+int32 SDcacheRead ( FS_FILE * file, uint32 offset, char * buf, int32 len )
+{
+   sd_cache_t * c;
+   uint16 pos, n;
+   sdCacheStats.reads++;
+   while ( len > 0 )
+   {
+      c = sdCacheSector ( file, offset );
+      if ( c == null )
+      {
+         return -1;
+      }
+      pos = offset - c->base;
+      if ( pos >= c->len )
+      {
+         return -1;
+      }
+      n = ( len < ( c->len - pos ) ) ? len : ( c->len - pos );
+      memcpy ( buf, &c->data[pos], n );
+      buf += n; offset += n; len -= n;
+   }
+   return 0;
+}
+
+/*******************************************************************************
+* Function Name: SDcacheWrite()
+********************************************************************************
+* Summary:     Writes len bytes at offset of a file into the cache. A write
+*              that would leave a hole past the end of the file goes straight
+*              to the card, after what the slot holds, and the slot is
+*              dropped since the card now has more than it.
+* Return:      0 success -1 error
+*******************************************************************************/
+int32 SDcacheWrite ( FS_FILE * file, uint32 offset, char * buf, int32 len )
+{
+   sd_cache_t * c;
+   uint16 pos, n;
+   sdCacheStats.writes++;
+   while ( len > 0 )
+   {
+      c = sdCacheSector ( file, offset );
+      if ( c == null )
+      {
+         return -1;
+      }
+      pos = offset - c->base;
+      if ( pos > c->len )
+      {
+         if ( sdCacheWriteBack ( c ) != 0 )
+         {
+            return -1;
+         }
+         c->file = null;
+         sdCacheStats.fs_writes++;
+         FS_FSeek ( file, offset, FS_SEEK_SET );
+         return ( FS_Write ( file, buf, len ) == len ) ? 0 : -1;
+      }
+      n = ( len < ( SD_CACHE_SECTOR - pos ) ) ? len : ( SD_CACHE_SECTOR - pos );
+      memcpy ( &c->data[pos], buf, n );
+      if ( pos + n > c->len )
+      {
+         c->len = pos + n;
+      }
+      if ( c->dirty_hi == c->dirty_lo )
+      {
+         c->dirty_lo = pos;
+         c->dirty_hi = pos + n;
+      }
+      else
+      {
+         c->dirty_lo = ( pos < c->dirty_lo ) ? pos : c->dirty_lo;
+         c->dirty_hi = ( pos + n > c->dirty_hi ) ? pos + n : c->dirty_hi;
+      }
+      buf += n; offset += n; len -= n;
+   }
+   return 0;
+}
+
+/*******************************************************************************
+* Function Name: SDcacheFlush()
+********************************************************************************
+* Summary:     Writes back what the cache holds for a file, or for all files
+* Parameters:  file, null for all
+* Return:      0 success -1 error
+*******************************************************************************/
+int32 SDcacheFlush ( FS_FILE * file )
+{
+   int32 error = 0;
+   uint8 i;
+   for ( i = 0; i < SD_CACHE_SLOTS; i++ )
+   {
+      if ( ( sdCache[i].file != null ) && ( ( file == null ) || ( sdCache[i].file == file ) ) )
+      {
+         error |= sdCacheWriteBack ( &sdCache[i] );
+      }
+   }
+   return error;
+}
+
+/*******************************************************************************
+* Function Name: SDcacheClose()
+********************************************************************************
+* Summary:     Flushes and forgets a file before it is closed or changed
+*              outside the cache
+*******************************************************************************/
+void SDcacheClose ( FS_FILE * file )
+{
+   uint8 i;
+   for ( i = 0; i < SD_CACHE_SLOTS; i++ )
+   {
+      if ( sdCache[i].file == file )
+      {
+         sdCacheWriteBack ( &sdCache[i] );
+         sdCache[i].file = null;
+      }
+   }
+}
+
+/*******************************************************************************
+* Function Name: SDcacheIdle()
+********************************************************************************
+* Summary:     Called from the idle loop, writes back sectors not written to
+*              for SD_CACHE_FLUSH_MS
+*******************************************************************************/
+void SDcacheIdle ( void )
+{
+   uint8 i, flushed = FALSE;
+   for ( i = 0; i < SD_CACHE_SLOTS; i++ )
+   {
+      if ( ( sdCache[i].file != null ) && ( sdCache[i].dirty_hi != sdCache[i].dirty_lo )
+           && ( ( msTimer - sdCache[i].used_ms ) > SD_CACHE_FLUSH_MS ) )
+      {
+         sdCacheWriteBack ( &sdCache[i] );
+         flushed = TRUE;
+      }
+   }
+   if ( flushed )
+   {
+      FS_Sync ( "" );
+   }
+}
+
+/*******************************************************************************
+* Function Name: getSDcacheStats()
+********************************************************************************
+* Summary:     Calls into the cache against reads and writes sent to emFile
+* Parameters:  destination, TRUE to clear the figures after the copy
+*******************************************************************************/
+void getSDcacheStats ( sd_cache_stats_t * stats, uint8 reset )
+{
+   *stats = sdCacheStats;
+   if ( reset )
+   {
+      memset ( &sdCacheStats, 0, sizeof(sdCacheStats) );
+   }
+}
+
+
 /*******************************************************************************
 * Function Name: SDProjOpen()
 ********************************************************************************
@@ -800,6 +1179,207 @@ uint8 SDtestProjectCreation ( void )
   RemoveDir(project_name);
   return 1;
 }
+#define SD_BENCH_STATIONS  25
+#define SD_BENCH_LARGE     1000
+/******************************************************************************
+ *
+ *  Name: SDlargeProjectBenchmark()
+ *
+ *  PARAMETERS: station to store
+ *
+ *  DESCRIPTION:  Creates a journal project, fills it with SD_BENCH_LARGE
+ *                stations and shows the creation time, the fill time, the
+ *                file size and the space it takes on the card in whole
+ *                clusters. The project is removed afterwards.
+ *            
+ *  RETURNS: 1 if completed
+ *
+ *****************************************************************************/ 
+static uint8 SDlargeProjectBenchmark ( station_data_t * station )
+{
+  FS_DISK_INFO info;
+  uint32 start, create_ms, fill_ms, size = 0, cluster, on_card;
+  uint16_t i;
+  uint8 pass = TRUE;
+  char buf[30];
+  
+  CLEAR_DISP;
+  snprintf ( buf, 30, "Storing %u", SD_BENCH_LARGE );
+  DisplayStrCentered(LINE1,buf);
+  DisplayStrCentered(LINE2,"Please Wait");
+  start = msTimer;
+  if ( SD_CreateProjectSimpleFile ( "Bench1000" ) == null )
+  {
+    return FALSE;
+  }
+  create_ms = msTimer - start;
+  start = msTimer;
+  for ( i = 0; i < SD_BENCH_LARGE; i++ )
+  {
+    if ( writeStation ( "Bench1000", i, station ) == 0 )
+    {
+      pass = FALSE;
+      break;
+    }
+    incrementStationNumber ( "Bench1000" );  // commits the station, as a store does
+  }
+  fill_ms = msTimer - start;
+  if ( projSessionGet ( "Bench1000" ) != null )
+  {
+    SDcacheFlush ( null );
+    size = FS_GetFileSize ( projSessionGet ( "Bench1000" ) );
+  }
+  projSessionClose ( );
+  FS_Remove ( "Project\\Bench1000" );
+  catalogRemove ( "Bench1000" );
+  FS_GetVolumeInfo ( "", &info );
+  cluster = (uint32)info.SectorsPerCluster * info.BytesPerSector;
+  on_card = ( cluster != 0 ) ? ( ( size + cluster - 1 ) / cluster ) * cluster : size;
+  CLEAR_DISP;
+  if ( pass )
+  {
+    snprintf ( buf, 30, "Create: %lu ms", (unsigned long)create_ms );
+    DisplayStrCentered(LINE1,buf);
+    snprintf ( buf, 30, "%u Sta: %lu s", SD_BENCH_LARGE, (unsigned long)( fill_ms / 1000 ) );
+    DisplayStrCentered(LINE2,buf);
+    snprintf ( buf, 30, "File %luK Card %luK", (unsigned long)( size / 1024 ), (unsigned long)( on_card / 1024 ) );
+    DisplayStrCentered(LINE3,buf);
+  }
+  else
+  {
+    snprintf ( buf, 30, "Stopped at %u", i );
+    DisplayStrCentered(LINE2,buf);
+  }
+  DisplayStrCentered(LINE4,"Press <ESC> to Exit");
+  while( getKey( TIME_DELAY_MAX ) != ESC ) ;
+  return pass;
+}
+/******************************************************************************
+ *
+ *  Name: SDstoreBenchmark()
+ *
+ *  PARAMETERS: 
+ *
+ *  DESCRIPTION:  Times storing SD_BENCH_STATIONS stations the way a fixed
+ *                layout project was stored (open, seek, write, count, close
+ *                per station) against appending them to a journal project
+ *                through the session and the sector cache, with the
+ *                cache's write counts. Both test projects are removed.
+ *                ENTER on the results goes on to SDlargeProjectBenchmark.
+ *            
+ *  RETURNS: 1 if both runs completed
+ *
+ *****************************************************************************/ 
+uint8 SDstoreBenchmark ( void )
+{
+  FS_FILE *file = null;
+  station_data_t station;
+  uint8_t head[offsetof(project_data_t,station[0])];
+  uint16_t i, st_num;
+  uint32 start, fixed_ms = 0, log_ms = 0;
+  uint8 pass = TRUE;
+  sd_cache_stats_t io;
+  enum buttons button;
+  char buf[30];
+  
+  CLEAR_DISP;
+  DisplayStrCentered(LINE1,"Store Benchmark");
+  DisplayStrCentered(LINE2,"Please Wait");
+  memset ( &station, 0, sizeof(station) );
+  memset ( head, 0, sizeof(head) );
+  memset ( &io, 0, sizeof(io) );
+  strcpy ( station.name, "BENCH" );
+  projSessionClose ( );
+  // fixed layout: the header only, stations are written at their offsets
+  file = FS_FOpen ( "Project\\BenchFix", "wb+" );
+  if ( ( file == null ) || ( SD_WriteBuffer ( file, (char*)head, sizeof(head) ) != 0 ) )
+  {
+    pass = FALSE;
+  }
+  else
+  {
+    FS_FClose ( file );
+    file = null;
+    start = msTimer;
+    for ( i = 0; ( i < SD_BENCH_STATIONS ) && pass; i++ )
+    {
+      file = SDProjOpen ( "BenchFix" );
+      if ( file == null )
+      {
+        pass = FALSE;
+        break;
+      }
+      FS_FSeek ( file, offsetof(project_data_t,station[i]), FS_SEEK_SET );
+      SD_WriteBuffer ( file, (char*)&station, STATION_FIXED_SIZE );
+      FS_FSeek ( file, offsetof(project_data_t,station_number), FS_SEEK_SET );
+      SDreadBuffer ( file, (char*)&st_num, 2 );
+      st_num++;
+      FS_FSeek ( file, offsetof(project_data_t,station_number), FS_SEEK_SET );
+      SD_WriteBuffer ( file, (char*)&st_num, 2 );
+      FS_FClose ( file );
+      file = null;
+    }
+    fixed_ms = msTimer - start;
+  }
+  if ( file != null )
+  {
+    FS_FClose ( file );  // only left open if the header write failed
+  }
+  FS_Remove ( "Project\\BenchFix" );
+  // journal: one record appended per station through the session
+  if ( pass && ( SD_CreateProjectSimpleFile ( "BenchLog" ) != null ) )
+  {
+    getSDcacheStats ( &io, TRUE );
+    start = msTimer;
+    for ( i = 0; i < SD_BENCH_STATIONS; i++ )
+    {
+      if ( writeStation ( "BenchLog", i, &station ) == 0 )
+      {
+        pass = FALSE;
+        break;
+      }
+      incrementStationNumber ( "BenchLog" );  // commits the station, as a store does
+    }
+    log_ms = msTimer - start;
+    getSDcacheStats ( &io, FALSE );
+    projSessionClose ( );
+    FS_Remove ( "Project\\BenchLog" );
+    catalogRemove ( "BenchLog" );
+  }
+  else
+  {
+    pass = FALSE;
+  }
+  CLEAR_DISP;
+  // project writes asked for against writes that reached emFile
+  snprintf ( buf, 30, "%u Sta %u>%u wr", SD_BENCH_STATIONS, io.writes, io.fs_writes );
+  DisplayStrCentered(LINE1,buf);
+  if ( pass )
+  {
+    snprintf ( buf, 30, "Fixed:   %lu ms", (unsigned long)fixed_ms );
+    DisplayStrCentered(LINE2,buf);
+    snprintf ( buf, 30, "Journal: %lu ms", (unsigned long)log_ms );
+    DisplayStrCentered(LINE3,buf);
+  }
+  else
+  {
+    DisplayStrCentered(LINE2,"Benchmark Failed");
+  }
+  DisplayStrCentered(LINE4,"ENTER=1000 ESC=Exit");
+  while( 1 )
+  {
+    button = getKey( TIME_DELAY_MAX );
+    if ( ( button == ESC ) || ( button == ENTER ) )
+    {
+      break;
+    }
+  }
+  if ( pass && ( button == ENTER ) )
+  {
+    pass = SDlargeProjectBenchmark ( &station );
+  }
+  return pass;
+}
 /******************************************************************************
  *  Name: 
  *  PARAMETERS: 
@@ -822,11 +1402,11 @@ void sd_card_menu(void)
     LCD_position(LINE2);
     _LCD_PRINT("SD Card Not Detected");
     CyDelay ( 1000 );
-    SDstop(0); // FS_DeInt if no card detected
+    SDunmount(); // FS_DeInt if no card detected
   }
   else
   {
-    SD_Wake(); 
+    SDstart();                  // given back when the menu is left
     while(1)                    // only exit menu when ESC is pressed
     { 
       sd_menu_display(menu_track);
@@ -881,6 +1461,8 @@ void sd_card_menu(void)
           
           case  5: SDtestProjectCreation();
                    break;  // 
+          case  6: SDstoreBenchmark();
+                   break;  // 
           default: break;
         }
         if(button==ESC)
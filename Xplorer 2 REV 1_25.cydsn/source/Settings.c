@@ -30,6 +30,8 @@
 #include "Utilities.h"
 #include "UARTS.h"
 #include "Alfat.h"
+#include "PulseCounter.h"
+#include "Measurement.h"
 
 /************************************* EXTERNAL FUNCTION DECLARATIONS  *************************************/
 extern float convertDensityToPCF ( float value_in_operational_units);
@@ -283,7 +285,9 @@ enum buttons enable_disable_features(char c)
   
  
 if ((Controls.LCD_light && (c == 'L')) || (Features.auto_scroll && (c == 'S')) || (Features.auto_depth && (c == 'D')) || (Features.avg_std_mode && (c == 'A')) 
-   || (Features.auto_store_on && (c == 'O')) || (Features.sound_on && (c == 'B')) || (Features.chi_sq_mode == 0 && (c == 'Q')) || (Features.gps_on == 1 && (c == 'G')) )  //the feature in question is enabled
+   || (Features.auto_store_on && (c == 'O')) || (Features.sound_on && (c == 'B')) || (Features.chi_sq_mode == 0 && (c == 'Q')) || (Features.gps_on == 1 && (c == 'G'))
+   || (Features.adaptive_count && (c == 'P')) || (Features.std_early_accept && (c == 'E'))
+   || (Features.auto_start && (c == 'H')) )  //the feature in question is enabled
  {
   //  enable=FALSE;
     if(Features.language_f)
@@ -369,6 +373,18 @@ if ((Controls.LCD_light && (c == 'L')) || (Features.auto_scroll && (c == 'S')) |
     {
       Features.gps_on ^= 1;
     }
+    else if(c=='P')
+    {
+      Features.adaptive_count ^= 1;
+    }
+    else if(c=='E')
+    {
+      Features.std_early_accept ^= 1;
+    }
+    else if(c=='H')
+    {
+      Features.auto_start ^= 1;
+    }
   
     
    
@@ -453,6 +469,42 @@ if ((Controls.LCD_light && (c == 'L')) || (Features.auto_scroll && (c == 'S')) |
     }
 
   }  
+  else if(c=='P')
+  {
+    CLEAR_DISP;
+    if ( Features.adaptive_count == 1 )
+    {
+     LCD_PrintAtPositionCentered("Precision Stop On",LINE2+10);
+    }
+    else
+    {
+     LCD_PrintAtPositionCentered("Precision Stop Off",LINE2+10);
+    }
+  }
+  else if(c=='E')
+  {
+    CLEAR_DISP;
+    if ( Features.std_early_accept == 1 )
+    {
+     LCD_PrintAtPositionCentered("Early STD Accept On",LINE2+10);
+    }
+    else
+    {
+     LCD_PrintAtPositionCentered("Early STD Accept Off",LINE2+10);
+    }
+  }
+  else if(c=='H')
+  {
+    CLEAR_DISP;
+    if ( Features.auto_start == 1 )
+    {
+     LCD_PrintAtPositionCentered("Auto Start On",LINE2+10);
+    }
+    else
+    {
+     LCD_PrintAtPositionCentered("Auto Start Off",LINE2+10);
+    }
+  }
  // save struct Features to eeprom
  NV_MEMBER_STORE( FEATURE_SETTINGS, Features );
          
@@ -479,14 +531,13 @@ void auto_depth_enable_or_calibrate(void)
   enum buttons button;
   float volts_safe,volts_bs,slope;
   char temp_str[21];
-  auto_depth_settings(); //TEXT// display "Auto Depth Settings\n1. Enable/Disable\n
-  ESC_to_Exit(LINE4);
+  auto_depth_settings(); //TEXT// display "Auto Depth Settings\n1. Enable/Disable\n2. Depth Strip Type\n3. Auto Start"
        
   while(1)
   {
     button = getKey(TIME_DELAY_MAX);
     
-    if((button == 1) || (button == 2 ) || (button == ESC) || (button == MENU))
+    if((button == 1) || (button == 2 ) || (button == 3 ) || (button == ESC) || (button == MENU))
       break;
   }
   
@@ -508,6 +559,16 @@ void auto_depth_enable_or_calibrate(void)
     } 
     delay_ms(1000); 
   }
+  else if(button == 3)
+  {
+    enable_disable_features('H');  // count starts when the rod leaves SAFE and is held at a depth
+    if ( Features.auto_start && !Features.auto_depth )
+    {
+      CLEAR_DISP;
+      LCD_PrintAtPositionCentered("Needs Auto Depth",LINE2+10);
+      delay_ms(1500);
+    }
+  }
   else if ((button == 2) && ( NV_RAM_MEMBER_RD( gauge_type ) != GAUGE_3440_PLUS ))
   {
    CLEAR_DISP;
@@ -667,7 +728,8 @@ void standCountMode(void)
   // Put the data into EEPROM
   NV_MEMBER_STORE (FEATURE_SETTINGS, Features);     // write kg or GCC as active units and save to memory          
   delay_ms ( 1000 );
-
+  
+  enable_disable_features('E');                     // standard may end once it is settled
 }
 
  /******************************************************************************
@@ -1390,7 +1452,7 @@ void special_cal(void)  // Acquire/Enter Special Calibration Constants
   uint8_t count = 1, loopcnt = 0;  
   int32_t total_dens_cnts = 0;
   int32_t dens_cnt_avg = 0;
-  float spec_depth, spec_den=0,spec_den_gcc = 0, spec_a, spec_c, spec_cal_b_value, CR_value; 
+  float spec_depth, spec_den=0,spec_den_gcc = 0, spec_cal_b_value, CR_value; 
   char number_ptr[20] = NULL_NAME_STRING;
   char temp_str[20];
   enum buttons button;
@@ -1606,9 +1668,7 @@ void special_cal(void)  // Acquire/Enter Special Calibration Constants
   
             spec_depth = NV_RAM_MEMBER_RD(SPECIALCAL_DEPTH);  // retrieve depth to get corresponding constants
                      
-            spec_a = get_constant('a',spec_depth);
-            spec_c = get_constant('c',spec_depth);
-            spec_cal_b_value =  log( spec_a / (CR_value + spec_c)) /  spec_den ;  // b value in GCC
+            spec_cal_b_value = calSpecialB ( (uint8_t)spec_depth, CR_value, spec_den );  // b value in GCC
   
             
             CLEAR_DISP;
@@ -1780,9 +1840,7 @@ void special_cal(void)  // Acquire/Enter Special Calibration Constants
           spec_den_gcc = spec_den/1000;
           // Explorer II uses GCC for density constants.
           spec_depth = tst_depth_g;  
-          spec_a = get_constant('a',spec_depth);
-          spec_c = get_constant('c',spec_depth);
-         	spec_cal_b_value = log( spec_a / (CR_value + spec_c)) / spec_den_gcc;  // units in GCC
+         	spec_cal_b_value = calSpecialB ( (uint8_t)spec_depth, CR_value, spec_den_gcc );  // units in GCC
           
           CLEAR_DISP;
           LCD_position (LINE1);        
@@ -2537,3 +2595,191 @@ void idle_shutdown(void)  //
   Controls.shut_dwn = TRUE;                      // enable shut down feature when NO is pressed  
 }
 
+
+/******************************************************************************
+ *  Name: gps_settings
+ *  
+ *  PARAMETERS: NA
+ *
+ *  DESCRIPTION: Enables or disables the GPS and sets the oldest fix a
+ *               reading will take. Readings never wait for a new fix.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+void gps_settings(void)
+{
+  float num_temp;
+  char number_ptr[20] = NULL_NAME_STRING;
+  
+  if ( ( enable_disable_features('G') != YES ) || !Features.gps_on )
+  {
+    return;
+  }
+  
+  num_temp = NV_RAM_MEMBER_RD(GPS_MAX_AGE);
+  if ( ( num_temp == 0 ) || ( num_temp > GPS_MAX_AGE_LIMIT ) )
+  {
+    num_temp = GPS_MAX_AGE_DEFAULT;
+  }
+  
+  CLEAR_DISP;
+  LCD_position(LINE1);
+  if(Features.language_f)
+  {
+    _LCD_PRINT("Max Fix Age (s):");
+  }
+  else
+  {
+    _LCD_PRINT("Edad Max Fijo (s):");
+  }
+  Enter_to_Accept(LINE3);
+  ESC_to_Exit(LINE4);
+  
+  sprintf(number_ptr,"%u", (uint16)num_temp);
+  num_temp = enterNumber ( number_ptr, LINE2, 2 );
+  
+  if ( getLastKey() == ESC )
+  {
+    return;
+  }
+  if ( num_temp < 1 )
+  {
+    num_temp = 1;
+  }
+  else if ( num_temp > GPS_MAX_AGE_LIMIT )
+  {
+    num_temp = GPS_MAX_AGE_LIMIT;
+  }
+  NV_MEMBER_STORE(GPS_MAX_AGE, (uint8)num_temp);
+}
+
+/******************************************************************************
+ *  Name: dead_time_settings(void)
+ *  
+ *  PARAMETERS: NA
+ *
+ *  DESCRIPTION: Selects the dead time model (off, non-paralyzable or
+ *               paralyzable) and enters the GM and He3 tube dead times in us.
+ *               Protected by the access code since it changes every count.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/ 
+ 
+void dead_time_settings(void)
+{
+  float  num_temp;
+  uint8  model;
+  char number_ptr[20] = NULL_NAME_STRING;
+  enum buttons button;
+  const char * model_txt[3] = { "Off            ", "Non-Paralyzable", "Paralyzable    " };
+  
+  if ( !enter_access_code() )
+  {
+    return;
+  }
+  Controls.shut_dwn = FALSE;
+  
+  model = NV_RAM_MEMBER_RD(DT_MODEL);
+  if ( model > DEAD_TIME_PARALYZABLE )
+  {
+    model = DEAD_TIME_OFF;
+  }
+  
+  CLEAR_DISP;
+  LCD_position(LINE1);
+  _LCD_PRINT("Dead Time Model:");
+  up_down_select_text(1);
+  Enter_to_Accept(LINE4);
+  
+  while(1)
+  {
+    LCD_position(LINE2);
+    _LCD_PRINTF("%s",model_txt[model]);
+    
+    button = getKey(TIME_DELAY_MAX);
+    if ( button == UP )
+    {
+      model = ( model + 2 ) % 3;
+    }
+    else if ( button == DOWN )
+    {
+      model = ( model + 1 ) % 3;
+    }
+    else if ( ( button == ENTER ) || ( button == ESC ) )
+    {
+      break;
+    }
+  }
+  if ( button == ESC )
+  {
+    Controls.shut_dwn = TRUE;
+    return;
+  }
+  NV_MEMBER_STORE(DT_MODEL,model);
+  
+  if ( model != DEAD_TIME_OFF )
+  {
+    // GM tube dead time
+    num_temp = NV_RAM_MEMBER_RD(DT_TAU_GM);
+    if ( !( num_temp >= 0 ) || ( num_temp > DEAD_TIME_MAX_US ) )
+    {
+      num_temp = 0;
+    }
+    CLEAR_DISP;
+    LCD_position(LINE1);
+    _LCD_PRINT("GM Dead Time (us):");
+    Enter_to_Accept(LINE3);
+    ESC_to_Exit(LINE4);
+    sprintf(number_ptr,"%.1f",num_temp);
+    num_temp = enterNumber ( number_ptr, LINE2, 6 );
+    if ( getLastKey() != ESC )
+    {
+      if ( num_temp > DEAD_TIME_MAX_US )
+      {
+        num_temp = DEAD_TIME_MAX_US;
+      }
+      NV_MEMBER_STORE(DT_TAU_GM,num_temp);
+      
+      // He3 tube dead time
+      num_temp = NV_RAM_MEMBER_RD(DT_TAU_HE3);
+      if ( !( num_temp >= 0 ) || ( num_temp > DEAD_TIME_MAX_US ) )
+      {
+        num_temp = 0;
+      }
+      CLEAR_DISP;
+      LCD_position(LINE1);
+      _LCD_PRINT("He3 Dead Time (us):");
+      Enter_to_Accept(LINE3);
+      ESC_to_Exit(LINE4);
+      sprintf(number_ptr,"%.1f",num_temp);
+      num_temp = enterNumber ( number_ptr, LINE2, 6 );
+      if ( getLastKey() != ESC )
+      {
+        if ( num_temp > DEAD_TIME_MAX_US )
+        {
+          num_temp = DEAD_TIME_MAX_US;
+        }
+        NV_MEMBER_STORE(DT_TAU_HE3,num_temp);
+      }
+    }
+  }
+  
+  CLEAR_DISP;
+  LCD_position(LINE1);
+  _LCD_PRINT("Dead Time Model:");
+  LCD_position(LINE2);
+  _LCD_PRINTF("%s",model_txt[NV_RAM_MEMBER_RD(DT_MODEL)]);
+  if ( model != DEAD_TIME_OFF )
+  {
+    LCD_position(LINE3);
+    _LCD_PRINTF("GM:%.1fus",NV_RAM_MEMBER_RD(DT_TAU_GM));
+    LCD_position(LINE4);
+    _LCD_PRINTF("He3:%.1fus",NV_RAM_MEMBER_RD(DT_TAU_HE3));
+  }
+  delay_ms(1500);
+  
+  Controls.shut_dwn = TRUE;
+}
+
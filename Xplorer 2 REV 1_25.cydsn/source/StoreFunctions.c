@@ -29,6 +29,8 @@
 #include "ProjectData.h"
 #include "SDcard.h"
 #include "UARTS.h"
+#include "Measurement.h"
+#include <stddef.h> /* for offsetof */
 /************************************* EXTERNAL FUNCTION DECLARATIONS  *************************************/
 extern float convertKgM3DensityToUnitDensity ( float value_in_kg, uint8_t units );
 extern  uint8_t getCalibrationDepth ( uint8_t depth_inches );
@@ -131,6 +133,14 @@ void start_new_project ( void )  // leads user through setup for new project
                CyDelay ( 1500 );
                go_to_screen = 0;
               }
+              else if ( getProjectNumber() >= MAX_PROJECTS )
+              {
+               CLEAR_DISP;
+               LCD_PrintAtPosition ("Too Many Projects",LINE2);
+               ESC_to_Exit(LINE4);                //TEXT// display "ESC to Exit"
+               CyDelay ( 1500 );
+               escape = TRUE;
+              }
               else
               {
                // create file
@@ -259,7 +269,7 @@ void start_new_project ( void )  // leads user through setup for new project
  *  DESCRIPTION: Allows user to select a project for review.normal_data
  *
  *
- *  RETURNS: 00 if selected or error (17)
+ *  RETURNS: 00 if selected or NO_SELECTION
  *
  *****************************************************************************/
 uint16_t getProjectIndex ( char * project )
@@ -279,7 +289,7 @@ uint16_t getProjectIndex ( char * project )
     hold_buzzer();
     SDstop(null );
     delay_ms(1000);
-    return ( 17);
+    return NO_SELECTION;
   }
    //TEXT// display "   Select Project\n    From List" LINE2,3
   select_from_list_text(0);
@@ -291,7 +301,7 @@ uint16_t getProjectIndex ( char * project )
   _LCD_PRINT ("                    ");
   LCD_position(LINE1);
   // Get project name
-  SD_FindFile  (  display_index, "\\Project\\", project, false );
+  catalogGetName ( display_index, project );
   sprintf ( lcdstr, "%u. %s",display_index, project );
   LCD_print (lcdstr);
   up_down_ENTER_select_text();
@@ -306,7 +316,7 @@ uint16_t getProjectIndex ( char * project )
   if ( button == ESC )
   {
     SDstop(null );
-    return (17);
+    return NO_SELECTION;
   }
   if ( button == UP )
   {
@@ -338,7 +348,7 @@ uint16_t getProjectIndex ( char * project )
   }
  }// end while(1)
   SDstop(null );
- return (17);
+ return NO_SELECTION;
 }
 /******************************************************************************
  *
@@ -349,7 +359,7 @@ uint16_t getProjectIndex ( char * project )
  *  DESCRIPTION: Allows user to select a station for review.normal_data
  *
  *
- *  RETURNS: station index or error (17)
+ *  RETURNS: station index or NO_SELECTION
  *
  *****************************************************************************/
 uint32_t getStation ( char * project )
@@ -357,18 +367,20 @@ uint32_t getStation ( char * project )
   uint16 station_count;
   uint16_t display_index;
   char station[PROJ_NAME_LENGTH] = NULL_NAME_STRING;
+  char temp_str[8];
+  const station_dir_t * dir;
+  const station_dir_entry_t * entry;
   enum buttons button;
-  FS_FILE* nfile = null;
   if ( SD_CheckIfProjExists ( project ) == false )
   {
-    return 17;
+    return NO_SELECTION;
   }
-  // open the file for read,write
-  nfile = SDProjOpen ( project );
-  if ( nfile == null )
+  // open the project for the whole browse, names come from the station directory
+  if ( projSessionGet ( project ) == null )
   {
-    return 17;
+    return NO_SELECTION;
   }
+  loadStationDir ( project, 0 );
   //read number of stations from eeprom
   station_count = getStationNumber ( project );
   if ( station_count == 0 )
@@ -376,7 +388,7 @@ uint32_t getStation ( char * project )
     no_data_stored_text();  //TEXT// display "   No Data Stored"  LINE2
     hold_buzzer();
     delay_ms(1000);
-    return(17);
+    return NO_SELECTION;
   }
   display_index = 0;
   select_from_list_text(1); //TEXT// display "   Select Station\n     From List"  LINE2,3
@@ -391,6 +403,24 @@ uint32_t getStation ( char * project )
     getStationName (  project, station , display_index );
     sprintf (lcdstr, "%s", station );
     LCD_print ( lcdstr );
+    dir = loadStationDir ( project, display_index );
+    entry = ( dir != null ) ? &dir->entry[display_index - dir->first] : null;
+    if ( ( entry != null ) && ( entry->sweep_id != 0 ) )
+    {  // the depths of a sweep share its name
+      if ( entry->depth == 1 )
+      {
+        sprintf ( temp_str, "BS" );
+      }
+      else if ( Features.SI_units )
+      {
+        sprintf ( temp_str, "%umm", entry->depth * 25 );
+      }
+      else
+      {
+        sprintf ( temp_str, "%uin", entry->depth );
+      }
+      print_string_backward ( temp_str, LINE1 + 19 );
+    }
     up_down_ENTER_select_text();
     while(1)
     {
@@ -402,7 +432,7 @@ uint32_t getStation ( char * project )
     }
     if(button == ESC)
     {
-      return(17);
+      return NO_SELECTION;
     }
     if(button == UP)
     {
@@ -445,7 +475,7 @@ uint32_t getStation ( char * project )
  *  DESCRIPTION:
  *  //select proj. (0=resume,1=delete,2=display)
  *
- *  RETURNS: selected station number of selected project, and proj name, or 17 is esc
+ *  RETURNS: selected station number of selected project, and proj name, or NO_SELECTION on ESC
  *
  *****************************************************************************/
 uint16_t select_stored_project ( uint8_t function, char* prj_name )
@@ -459,9 +489,8 @@ uint16_t select_stored_project ( uint8_t function, char* prj_name )
   {
     no_stored_projects_text();  //TEXT// display "    No Projects\n      Stored" LINE2,3
     hold_buzzer();
-    SDstop(null);
     delay_ms(1000);
-    return ( 17);
+    return NO_SELECTION;
   }
   //TEXT// display "   Select Project\n    From List" LINE2,3
   select_from_list_text(0);
@@ -474,12 +503,8 @@ uint16_t select_stored_project ( uint8_t function, char* prj_name )
       _LCD_PRINT ("                    ");
       LCD_position(LINE1);
       // Get project name
-      SD_FindFile (  display_index, "\\Project\\", prj_name, false );
-      sprintf ( lcdstr, "%s", prj_name );
-      station_count = getStationNumber ( prj_name );
-      SD_FindFile (  display_index, "\\Project\\", prj_name, false );
+      catalogGetName ( display_index, prj_name );
       sprintf ( lcdstr, "%s", prj_name );
-      station_count = getStationNumber ( prj_name );
       LCD_print (lcdstr);
       up_down_ENTER_select_text();
       while(1)
@@ -492,7 +517,7 @@ uint16_t select_stored_project ( uint8_t function, char* prj_name )
       }
       if ( button == ESC )
       {
-        return (17);
+        return NO_SELECTION;
       }
       if ( button == UP )
       {
@@ -531,13 +556,14 @@ uint16_t select_stored_project ( uint8_t function, char* prj_name )
         /////////////////////////////////////////////////////////////////////////////
         else if ( function == 2 )  // select project for display
         {          //read number of stations
+          loadStationDir ( prj_name, 0 );
           station_count = getStationNumber ( prj_name );
           if ( station_count == 0 )
           {
             no_data_stored_text();  //TEXT// display "   No Data Stored"  LINE2
             hold_buzzer();
             delay_ms(1000);
-            return(17);
+            return NO_SELECTION;
           }
           display_index = 0;
           select_from_list_text(1); //TEXT// display "   Select Station\n     From List"  LINE2,3
@@ -563,7 +589,7 @@ uint16_t select_stored_project ( uint8_t function, char* prj_name )
             }
             if ( button == ESC )
             {
-               return(17);
+               return NO_SELECTION;
             }
             if(button == UP)
             {
@@ -607,8 +633,12 @@ void delete_projects(void)  // allows user to delete one or all project(s)
   Bool escape = 0;
   uint8_t go_to_screen = 0;
   char selected_project_name [ PROJ_NAME_LENGTH] ;
+  char active_before [ PROJ_NAME_LENGTH ], active_after [ PROJ_NAME_LENGTH ];
   enum buttons button;
-  uint8 esc_key;
+  uint16 esc_key;
+  uint8 policy = PROJ_DELETE_EXPORTED;
+  uint16 days = 365, deleted;
+  char num_temp[11];
  // char project [] = "TEMP";
   //unsigned int32 selected_project;
  // char temp_str[PROJ_NAME_LENGTH] = NULL_NAME_STRING;
@@ -627,12 +657,12 @@ void delete_projects(void)  // allows user to delete one or all project(s)
     switch ( go_to_screen )
     {
       case 0:
-            delete_data_text();     //TEXT// display "Delete Data\n1. Delete All Data\n2. Delete One Proj." LINE1,2,3
+            delete_data_text();     //TEXT// display "1. Delete All Data\n2. Delete One Proj.\n3. Clean Up Card" LINE1,2,3
             up_down_select_text(0); //TEXT// display "Select #, ESC Exit"
             while(1)
             {
               button = getKey ( TIME_DELAY_MAX );
-              if((button == 1) || (button == 2) || (button == ESC))
+              if((button == 1) || (button == 2) || (button == 3) || (button == ESC))
               {
                 break;
               }
@@ -645,10 +675,14 @@ void delete_projects(void)  // allows user to delete one or all project(s)
             {
               go_to_screen = 1;  //go to delete all data screen set
             }
-            else
+            else if ( button == 2 )
             {
               go_to_screen = 4;  //go to select_stored_project(delete)
             }
+            else
+            {
+              go_to_screen = 6;  //go to clean up card
+            }
             break;
       case 1: // ASk to Delete all data from project storage
             enter_to_delete_text();  //TEXT// display "  Press ENTER to\n  Delete All Data"  LINE2,3
@@ -703,7 +737,7 @@ void delete_projects(void)  // allows user to delete one or all project(s)
               break;
       case 4: //select single project to delete
               esc_key = select_stored_project( 1, selected_project_name );  //arg 1 returns index of selected project
-              if ( esc_key == 17 )  //esc was pressed, 17 is not a valid vector
+              if ( esc_key == NO_SELECTION )  //esc was pressed
               {
                 return;
               }
@@ -750,6 +784,81 @@ void delete_projects(void)  // allows user to delete one or all project(s)
               NV_MEMBER_STORE( FEATURE_SETTINGS, Features );// makes user reselect a new proj.
             }
             break;
+      case 6: // pick which projects the clean up removes
+            cleanup_policy_text();  //TEXT// display "Clean Up Card\n1. Older Than Days\n2. Exported Only" LINE1,2,3
+            up_down_select_text(0); //TEXT// display "Select #, ESC Exit"
+            while(1)
+            {
+              button = getKey ( TIME_DELAY_MAX );
+              if((button == 1) || (button == 2) || (button == ESC))
+              {
+                break;
+              }
+            }
+            if(button == ESC)
+            {
+              escape = TRUE;
+            }
+            else if ( button == 1 )
+            {
+              policy = PROJ_DELETE_OLDER;
+              go_to_screen = 7;
+            }
+            else
+            {
+              policy = PROJ_DELETE_EXPORTED;
+              go_to_screen = 8;
+            }
+            break;
+      case 7: // age limit, dated by the last station in each project
+            sprintf ( num_temp, "%u", days );
+            cleanup_days_text(num_temp);  //TEXT// display "Delete Older Than\nDays: %s",num_temp
+            YES_to_Accept(LINE3);         //TEXT// display "YES to Accpet"
+            ESC_to_Exit(LINE4);           //TEXT// display "ESC to Exit"
+            days = (uint16)enter_number_std ( num_temp, LINE2 + 6, 4, 0 );
+            button = getLastKey();
+            if(button == ESC)
+            {
+              escape = TRUE;
+            }
+            else if(button == YES)
+            {
+              go_to_screen = 8;
+            }
+            break;
+      case 8: // Ask before deleting, then delete in one pass over the card
+            erase_cleanup_text();  //TEXT// display "Erase Selected\nProjects?\nYES to Continue" LINE1,2,3
+            ESC_to_Exit(LINE4);
+            while(1)
+            {
+              button = getKey ( TIME_DELAY_MAX );
+              if((button == YES) || (button == ESC))
+              {
+                break;
+              }
+            }
+            if(button == ESC)
+            {
+              escape = TRUE;
+            }
+            else
+            {
+              getActiveProjectEE ( active_before );
+              deleted = deleteProjectsBy ( policy, days );
+              getActiveProjectEE ( active_after );  // deleteProjectsBy clears it if the active project went
+              CLEAR_DISP;
+              projects_deleted_text ( deleted );  //TEXT// display "%u Projects\nDeleted" LINE2,3
+              hold_buzzer();
+              updateProjectInfo();
+              if ( strncmp ( active_before, active_after, PROJ_NAME_LENGTH ) != 0 )
+              {
+                Features.auto_store_on = FALSE;
+                NV_MEMBER_STORE( FEATURE_SETTINGS, Features );// makes user reselect a new proj.
+              }
+              delay_ms(2000);
+              escape = TRUE;
+            }
+            break;
     }
   }
 }
@@ -781,7 +890,7 @@ void review_data(void)  // computes and displays stored data
   SD_Wake();
   // Ask the user to select a project
   index = select_stored_project ( 0, proj );
-  if ( index == 17)  // no project selected
+  if ( index == NO_SELECTION )  // no project selected
   {
      return;
   }
@@ -789,7 +898,7 @@ void review_data(void)  // computes and displays stored data
   {
     // get a station from the project
     location = getStation ( proj );
-    if ( location == 17)  // no project selected
+    if ( location == NO_SELECTION )  // no project selected
     {
      return;
     }
@@ -1004,10 +1113,11 @@ void review_data(void)  // computes and displays stored data
  *  RETURNS:
  *
  *****************************************************************************/
-Bool USB_write_file (  char * project , FILE_PARAMETERS * file)  // writes project info at vector to file on USB
+Bool USB_write_file (  char * project , FILE_PARAMETERS * file, Bool recompute )  // writes project info at vector to file on USB
 {
-  uint8_t depth_rev,  units_rev, i;
-  uint16_t station_count, m_stand_rev, m_count_rev;
+  FS_FILE * pFile;
+  uint8_t depth_rev,  units_rev;
+  uint16_t i, station_count, m_stand_rev, m_count_rev;
   uint32_t d_count_rev, d_stand_rev;
   float moist_rev, PR_rev, MA_rev, MCR_rev, DT_rev, per_MA, dry_dense_rev, moist_percent_rev;
   float  moisture_offset_rev, density_offset_rev, bottom_den_rev,kk_value_rev;
@@ -1029,19 +1139,30 @@ Bool USB_write_file (  char * project , FILE_PARAMETERS * file)  // writes proje
     nullString( temp_str, sizeof(temp_str) );
     sprintf(temp_str,"Date\tSerial Number\tStation\tDepth\tWD or DT\t%%MA\tMA\t%%Voids\tM Count\tD Count\tMCR\tDCR\tMoist\t%%Moist\tDD\t%%PR\tPR\tDensity Std Cnt\tMoist Std Cnt\t");
     AlfatWriteStr( file,temp_str);
-    sprintf(temp_str,"Const A\tConst B\tConst C\tConst E\tConst F\tDensity Offset\tMoisture Offset(K)\tTrenchOffset\t Nomograph  Offset\tBottom Density\tLAT\tLNG\tALT\r\n");
+    sprintf(temp_str,"Const A\tConst B\tConst C\tConst E\tConst F\tDensity Offset\tMoisture Offset(K)\tTrenchOffset\t Nomograph  Offset\tBottom Density\tLAT\tLNG\tALT\tSweep\r\n");
     AlfatWriteStr( file,temp_str);   //write string to USB
     // Get the number of stations to store
     station_count = getStationNumber( project );
     // Get the serial number
     serial_number = getSerialNumber ();
+    // the project stays open for the whole pass
+    pFile = projSessionGet ( project );
+    if ( pFile == null )
+    {
+      isrTIMER_1_Enable();
+      return FALSE;
+    }
     // store each station
     for( i=0; i < station_count; i++ )
     {
-      if ( readStation ( project, i, & review ) == -1 )
+      if ( readStation ( project, i, &review ) != 0 )
       {
        break;
       }
+      if ( recompute )
+      {
+        recomputeStation ( &review );
+      }
       //read station name into local variable
       if ( strlen(review.name) < PROJ_NAME_LENGTH  )
       {
@@ -1338,7 +1459,13 @@ Bool USB_write_file (  char * project , FILE_PARAMETERS * file)  // writes proje
       AlfatWriteStr( file,temp_str);   //write string to USB
       sprintf( temp_str,"%9.6f\t",  review.gps_read.longitude );
       AlfatWriteStr( file,temp_str);   //write string to USB
-      sprintf( temp_str,"%u.00",  review.gps_read.altitude );
+      sprintf( temp_str,"%u.00\t",  review.gps_read.altitude );
+      // SWEEP, the depths of one sweep share it
+      if ( review.sweep_id != 0 )
+      {
+        sprintf ( temp_val, "%u", review.sweep_id );
+        strcat ( temp_str, temp_val );
+      }
       strcat ( temp_str, "\r\n");
       // store the row of data
       AlfatWriteStr( file,temp_str);   //write string to USB
@@ -1368,6 +1495,9 @@ void write_data_to_USB ( void )  // leads user though process to write project(s
   enum buttons button;
   Bool pass = TRUE;
   FILE_PARAMETERS  file;
+  uint32_t export_ms = 0;
+  proj_session_stats_t session;
+  sd_cache_stats_t io;
   if ( alfat_errors > 0 )
   {
     date_usb_error_text();  // if alfat errors put up message
@@ -1437,7 +1567,7 @@ void write_data_to_USB ( void )  // leads user though process to write project(s
             break;
       case 2:
             location = select_stored_project (1, proj);   //get memory location of project to write to USB
-            if(location == 17)  // no project selected
+            if(location == NO_SELECTION )  // no project selected
             {
               go_to_screen = 0;
               break;
@@ -1465,11 +1595,14 @@ void write_data_to_USB ( void )  // leads user though process to write project(s
                 escape = TRUE;
                 break;
               }
+              export_ms = msTimer;
+              getProjSessionStats ( &session, TRUE );
+              getSDcacheStats ( &io, TRUE );
               if(scope == 1)  //write all data to USB
               {
                 for( i=1; i <= project_info.number_of_projects; i++ )
                 {
-                  SD_FindFile (  i, "\\Project\\", proj, false );
+                  catalogGetName ( i, proj );
                   strcpy ( name_temp, proj );
                   LCD_PrintBlanksAtPosition ( 20, LINE4 );
                   LCD_PrintAtPositionCentered ( name_temp , LINE4 + 10 );
@@ -1477,12 +1610,13 @@ void write_data_to_USB ( void )  // leads user though process to write project(s
                   pass = USB_open_file ( name_temp, & file);
                   if ( pass == TRUE )
                   {
-                     pass = USB_write_file(name_temp, &file);   //write project data to the USB drive
+                     pass = USB_write_file(name_temp, &file, FALSE);   //write project data to the USB drive
                      if ( pass == TRUE )
                      {
                       // close file
                       AlfatFlushData( file.fileHandle );
                       AlfatCloseFile( file.fileHandle );
+                      catalogMarkExported ( name_temp );  // lets "Clean Up Card" pick it
                      }
                  }
                  // If wrting to the USB fails, break out of the for loop
@@ -1499,15 +1633,19 @@ void write_data_to_USB ( void )  // leads user though process to write project(s
                 pass = USB_open_file  ( proj, &fp );
                 if ( pass == TRUE )
                 {
-                  pass = USB_write_file ( proj, &fp );   //write project data to the USB drive
+                  pass = USB_write_file ( proj, &fp, FALSE );   //write project data to the USB drive
                   if ( pass == TRUE )
                   {
                    // close file
                    AlfatFlushData(fp.fileHandle);
                    AlfatCloseFile(fp.fileHandle);   //close file
+                   catalogMarkExported ( proj );
                   }
                 }
               }
+             export_ms = msTimer - export_ms;
+             getProjSessionStats ( &session, FALSE );
+             getSDcacheStats ( &io, FALSE );
              if ( pass == FALSE )
              {
               escape = TRUE;
@@ -1517,6 +1655,12 @@ void write_data_to_USB ( void )  // leads user though process to write project(s
              break;
       case 4:
               USB_text(3);  // display "   Data Download\n     Complete" on LINE2 and LINE3
+              // export time and project file opens, the figures to compare SD access changes by
+              sprintf ( lcdstr, "%lums %u open", (unsigned long)export_ms, session.opens );
+              LCD_PrintAtPosition ( lcdstr, LINE4 );
+              // station reads against sector reads sent to the card
+              sprintf ( lcdstr, "Reads %u>%u", io.reads, io.fs_reads );
+              LCD_PrintAtPosition ( lcdstr, LINE1 );
               delay_ms(2000);
               escape = TRUE;
               break;
@@ -1526,6 +1670,165 @@ void write_data_to_USB ( void )  // leads user though process to write project(s
   //AlfatStop();
   AlfatStop();
 }
+/******************************************************************************
+ *
+ *  Name: recomputeProjectTo ( char * project, char * derived )
+ *
+ *  PARAMETERS: project to recompute, name of the new project
+ *
+ *  DESCRIPTION: Copies a project to a new project in one pass, working each
+ *               station out again with the gauge's current constants,
+ *               offsets, Proctor and Marshall. The source is not changed.
+ *
+ *  RETURNS: number of stations written
+ *
+ *****************************************************************************/
+uint16_t recomputeProjectTo ( char * project, char * derived )
+{
+  station_data_t station_d;
+  uint16_t i, station_count, done = 0;
+  
+  if ( SD_CreateProjectSimpleFile ( derived ) == null )
+  {
+    return 0;
+  }
+  // both projects stay in session, the new one is a journal
+  if ( ( projSessionGet ( project ) != null ) && ( projSessionGet ( derived ) != null ) )
+  {
+    station_count = getStationNumber ( project );
+    setStationAutoNumber ( derived, checkStationAutoNumber ( project ) );
+    writeAutoStationStart ( derived, getAutoStationStart ( project ) );
+    for ( i = 0; i < station_count; i++ )
+    {
+      if ( readStation ( project, i, &station_d ) != 0 )
+      {
+        break;
+      }
+      recomputeStation ( &station_d );  // stations that can't be worked out are copied as they are
+      if ( writeStation ( derived, i, &station_d ) == 0 )
+      {
+        break;
+      }
+      done++;  // a journal counts each station as it is appended
+    }
+  }
+  catalogUpdate ( derived );
+  return done;
+}
+/******************************************************************************
+ *
+ *  Name: recompute_project ( void )
+ *
+ *  PARAMETERS: NA
+ *
+ *  DESCRIPTION: Leads the user through recomputing a stored project with
+ *               the current settings, either into a new project named
+ *               after it with "_R" added or straight to a USB drive.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+void recompute_project ( void )
+{
+  char proj[PROJ_NAME_LENGTH];
+  char derived[PROJ_NAME_LENGTH];
+  FILE_PARAMETERS fp;
+  enum buttons button;
+  uint16_t done, j;
+  Bool pass;
+  
+  if ( select_stored_project ( 1, proj ) == NO_SELECTION )
+  {
+    return;
+  }
+  strncpy ( derived, proj, PROJ_NAME_LENGTH - 3 );
+  derived[PROJ_NAME_LENGTH - 3] = '\0';
+  strcat ( derived, "_R" );
+  
+  CLEAR_DISP;
+  LCD_PrintAtPosition ( "Recompute Project", LINE1 );
+  LCD_PrintAtPosition ( "1. To New Project", LINE2 );
+  LCD_PrintAtPosition ( "2. To USB Drive", LINE3 );
+  ESC_to_Exit(LINE4);
+  while(1)
+  {
+    button = getKey ( TIME_DELAY_MAX );
+    if ( ( button == 1 ) || ( button == 2 ) || ( button == ESC ) )
+    {
+      break;
+    }
+  }
+  if ( button == 1 )
+  {
+    if ( SD_CheckIfProjExists ( derived ) )
+    {
+      CLEAR_DISP;
+      LCD_PrintAtPosition ( "Project Exists!", LINE2 );
+      LCD_PrintAtPosition ( derived, LINE3 );
+      delay_ms ( 1500 );
+      return;
+    }
+    CLEAR_DISP;
+    LCD_PrintAtPositionCentered ( "Recomputing", LINE2 + 10 );
+    done = recomputeProjectTo ( proj, derived );
+    CLEAR_DISP;
+    LCD_position ( LINE1 );
+    _LCD_PRINTF ( "%u Stations Saved As", done );
+    LCD_PrintAtPositionCentered ( derived, LINE2 + 10 );
+    hold_buzzer();
+    delay_ms ( 2000 );
+  }
+  else if ( button == 2 )
+  {
+    if ( alfat_errors > 0 )
+    {
+      date_usb_error_text();  // if alfat errors put up message
+      getKey(TIME_DELAY_MAX);
+      return;
+    }
+    USB_text(0); // display "  Insert External\n Drive in USB Port\n     Press ENTER" on LINE1, LINE2 and LINE4
+    while(1)
+    {
+      button = getKey ( TIME_DELAY_MAX );
+      if((button == ENTER) || (button == ESC))
+      {
+        break;
+      }
+    }
+    if ( button == ESC )
+    {
+      return;
+    }
+    AlfatStart();
+    j = 0;
+    while ( !check_for_USB() && j < 5 )
+    {
+      USB_text(2);  // display " No USB Device "
+      delay_ms ( 1000 );
+      j++;
+    }
+    if ( j < 5 )
+    {
+      USB_text(1);  // display "    Writing Data\n    To USB Drive" on LINE2 and LINE3
+      if ( initialize_USB( TRUE ) )
+      {
+        pass = USB_open_file ( derived, &fp );
+        if ( pass == TRUE )
+        {
+          pass = USB_write_file ( proj, &fp, TRUE );
+          AlfatFlushData(fp.fileHandle);
+          AlfatCloseFile(fp.fileHandle);
+        }
+        if ( pass == TRUE )
+        {
+          USB_text(3);  // display "   Data Download\n     Complete" on LINE2 and LINE3
+          delay_ms(2000);
+        }
+      }
+    }
+    AlfatStop();
+  }
+}
 /******************************************************************************
  *
  *  Name:
@@ -1540,8 +1843,8 @@ void write_data_to_USB ( void )  // leads user though process to write project(s
  *****************************************************************************/
 void print_data (  char * project )  // writes project info to file on USB
 {
-  uint8_t depth_rev, units_rev, i, data_set = 0;
-  uint16_t station_count, d_stand_rev, m_count_rev;
+  uint8_t depth_rev, units_rev, data_set = 0;
+  uint16_t i, station_count, d_stand_rev, m_count_rev;
   //m_stand_rev,
   uint32_t  d_count_rev;
   float dense_rev, moist_rev, PR_rev, MA_rev, MCR_rev, DT_rev, per_MA, dry_dense_rev, moist_percent_rev;
@@ -1727,6 +2030,7 @@ void print_data (  char * project )  // writes project info to file on USB
       data_set = 0; //reset data_set
       puts_printer ( "\r" );
     }
+  SDstop(null);
   isrTIMER_1_Enable();
   AlfatRxtInt_Enable() ;
   isrUART2_Disable() ;
@@ -1746,8 +2050,8 @@ void print_data (  char * project )  // writes project info to file on USB
 void write_data_to_printer(void)  // leads user though process to write project(s) to Rs232
 {
   Bool escape = 0, scope;
-  uint8_t go_to_screen = 0,  i = 0;
-  uint16_t location = 0;
+  uint8_t go_to_screen = 0;
+  uint16_t i = 0, location = 0;
   enum buttons button;
   char proj_name [PROJ_NAME_LENGTH];
   project_info.number_of_projects = getProjectNumber ();
@@ -1811,7 +2115,7 @@ void write_data_to_printer(void)  // leads user though process to write project(
             break;
       case 2:
             location = select_stored_project(  1, proj_name );   //get memory location of project to write to USB
-            if(location == 17)  // no project selected
+            if(location == NO_SELECTION )  // no project selected
             {
               go_to_screen = 0;
               break;
@@ -1833,7 +2137,7 @@ void write_data_to_printer(void)  // leads user though process to write project(
               for ( i = 1 ; i <= project_info.number_of_projects;  i++)
               {
                 // Get project name
-                SD_FindFile ( i, "\\Project\\", proj_name, false );
+                catalogGetName ( i, proj_name );
                 print_data ( proj_name );
                }
             }
@@ -1852,6 +2156,31 @@ void write_data_to_printer(void)  // leads user though process to write project(
     }
   }
 }
+/******************************************************************************
+ *
+ *  Name: storeErrorText ( )
+ *
+ *  DESCRIPTION: Says why a station wasn't stored: the card is out, full, or
+ *               the write failed
+ *
+ *****************************************************************************/
+void storeErrorText ( void )
+{
+  CLEAR_DISP;
+  if ( SD_CARD_DETECT_Read() == SD_CARD_OUT )
+  {
+    LCD_PrintAtPositionCentered ( SD_Str[SDOUT], LINE2 + 10 );
+  }
+  else if ( FS_GetVolumeFreeSpace ( "" ) < sizeof(proj_log_record_t) )
+  {
+    LCD_PrintAtPositionCentered ( "SD Card Full", LINE2 + 10 );
+  }
+  else
+  {
+    LCD_PrintAtPositionCentered ( SD_Str[SDERRWRITE], LINE2 + 10 );
+  }
+  LCD_PrintAtPositionCentered ( "Station Not Stored", LINE3 + 10 );
+}
 /******************************************************************************
  *
  *  Name: storeStationData ( station_data_t station_d )
@@ -1870,22 +2199,24 @@ void storeStationData ( char * project, station_data_t station  )
   FS_FILE *  SDfile = null;
   uint16 station_num;
   strcpy ( station.name, "              ");
-  SD_Wake();
+  SDstart();                 // given back by SDstop on every way out
   // Open the project file.
-  SDfile = SDProjOpen ( project );
+  SDfile = projSessionGet ( project );
   if ( SDfile == null )
   {
+    storeErrorText ( );
     SDstop ( null );
+    delay_ms(1500);
     return ;
   }
   // get the current station number from the open project file
   station_num = getStationNumber ( project );
   // Check to see if all station positions are full
-  if ( station_num >= MAX_STATIONS )
+  if ( !projectHasRoom ( project ) )
   {
    // display "Max # of Stations\nFor %s Has\nBeen Exceeded.\nStart New Project",current_project
    max_stations_text( project );
-   SDstop ( SDfile );       // stop SD card and close the opened file
+   SDstop ( null );         // done with the card, SDidle unmounts it later
    delay_ms(1500);
    return ;
   }
@@ -1901,11 +2232,17 @@ void storeStationData ( char * project, station_data_t station  )
   enter_name ( station.name, lcd_line );
   if ( getLastKey() == ESC )
   {
-    SDstop ( SDfile );       // stop SD card and close the opened file
+    SDstop ( null );         // done with the card, SDidle unmounts it later
+    return;
+  }
+  //write the station and increment number of stations within project
+  if ( ( writeStation ( project, station_num, &station ) == 0 ) || ( incrementStationNumber ( project ) == 0 ) )
+  {
+    storeErrorText ( );
+    SDstop ( null );
+    delay_ms(1500);
     return;
   }
-  writeStation ( project, station_num, &station );
-  //increment number of stations within project
-  incrementStationNumber ( project );
   project_info.station_index++ ;
+  SDstop ( null );
 }
\ No newline at end of file
@@ -39,11 +39,9 @@
 
 
 /************************************* EXTERNAL VARIABLE AND BUFFER DECLARATIONS  *************************************/
-extern void PulseCntStrt( float timeSec );
-extern void resetPulseTimers ( void );
-extern void stop_ONE_SHOT_Early ( void );
-extern uint32 getHEPulseCounts ( void );
-extern uint32 getGMPulseCounts ( void );
+#include "PulseCounter.h"
+#include "Tests.h"
+#include "SDcard.h"
 
 /************************************************  LOCAL DEFINITIONS  *************************************************/
 #define DENSITY_PASS_PERCENT    .01
@@ -51,15 +49,41 @@ extern uint32 getGMPulseCounts ( void );
 
 #define PRESCALE_7_5  2                   // prescale is 3.75s
 #define PRESCALE_15   4                   // prescale is 3.75s
-#define PRESCALE_30   PRESCALE_15 * 2
-#define PRESCALE_60   PRESCALE_15 * 4
-#define PRESCALE_240  PRESCALE_15 * 16
+#define PRESCALE_30   ( PRESCALE_15 * 2 )
+#define PRESCALE_60   ( PRESCALE_15 * 4 )
+#define PRESCALE_240  ( PRESCALE_15 * 16 )
 
 #define SMART_MC_CHI_COUNTS 32
 
+#define STD_SCREEN_MIN        4           // sub-counts before outlier screening starts
+#define STD_OUTLIER_SIGMA     4.0         // sub-count further than this from the mean is screened out
+#define STD_MAX_REJECTS       3           // more outliers than this and no early accept
+#define STD_EARLY_MIN         16          // shortest standard an early accept takes, 120s
+#define STD_SETTLE_Z          2.0         // the mean must be this many SE inside the pass band
+#define STD_CHI_LOW           0.5         // sub-count variance / Poisson variance limits
+#define STD_CHI_HIGH          1.6
+
+#define PRESCALE_MS           3750        // all counts are normalized to 3.75s
+#define PRECISION_MIN_MS      PRESCALE_MS // shortest count a precision stop accepts
+#define PRECISION_DEFAULT     100         // 1.00% relative standard error
+
 #define STD_COUNT_DELAY 450
 
+#define STAT_COUNTS           20          // 60s counts in a full stat test
+#define DRIFT_COUNTS          5           // 240s counts in a full drift test
+#define DRIFT_DENSE_LIMIT     0.5         // % drift that passes
+#define DRIFT_MOIST_LIMIT     1.0
+#define SEQ_ALPHA             0.02        // chance of failing a good gauge early
+#define SEQ_BETA              0.05        // chance of passing a bad gauge early
+#define SEQ_STAT_MIN          8           // fewest stat counts a sequential decision takes
+#define SEQ_DRIFT_MIN         3           // fewest drift counts a sequential decision takes
+#define SEQ_DRIFT_Z           3.0         // drift must be this many SE clear of the limit
+#define SEQ_LOG_FILE          "SEQTEST.TXT"
+
 /*****************************************  VARIABLE AND BUFFER DECLARATIONS  *****************************************/
+ uint32_t last_count_ms;                  // length of the last measurePulses count
+ float    last_count_rse;                 // worse of the GM/He3 relative std. errors, in %
+ uint8_t  last_count_quality;             // PQ_xxx flags of the last measurePulses count
  int32_t stat_dense_avg1;
  
  int32_t stat_dense_avg;
@@ -392,6 +416,182 @@ extern uint32 getGMPulseCounts ( void );
   isrTIMER_1_Enable();
  }
  
+/******************************************************************************
+ *
+ *  Name: getPrecisionMinCounts ( )
+ *
+ *  PARAMETERS: NA
+ *
+ *  DESCRIPTION: The Poisson relative standard error of a count N is 1/sqrt(N),
+ *               so a target RSE is reached once N >= 1/RSE^2. The target is
+ *               kept in COUNT_RSE in units of 0.01%.
+ *
+ *  RETURNS: counts each tube needs before the count may stop
+ *
+ *****************************************************************************/
+uint32_t getPrecisionMinCounts ( void )
+{
+  uint16_t rse = NV_RAM_MEMBER_RD ( COUNT_RSE );
+  float target;
+
+  if ( ( rse == 0 ) || ( rse > 1000 ) )   // not set yet
+  {
+    rse = PRECISION_DEFAULT;
+  }
+  target = rse / 10000.0;
+  
+  return (uint32_t)( 1.0 / ( target * target ) ) + 1;
+}
+
+/******************************************************************************
+ *
+ *  Name: getCountRSE ( )
+ *
+ *  PARAMETERS: raw density and moisture counts
+ *
+ *  DESCRIPTION: 
+ *
+ *  RETURNS: the larger of the two Poisson relative standard errors in %
+ *
+ *****************************************************************************/
+float getCountRSE ( uint32_t density_raw, uint32_t moisture_raw )
+{
+  uint32_t n = ( density_raw < moisture_raw ) ? density_raw : moisture_raw;
+  
+  if ( n == 0 )
+  {
+    return 100.0;
+  }
+  return 100.0 / sqrt ( n );
+}
+
+/******************************************************************************
+ *
+ *  Name: runStatsReset ( ), runStatsAdd ( ), runStatsSD ( )
+ *
+ *  PARAMETERS: statistics, new sample
+ *
+ *  DESCRIPTION: Welford's running mean and variance, so the standard count
+ *               statistics are up to date after every sub-count without a
+ *               second pass over the counts.
+ *
+ *  RETURNS: sample standard deviation, 0 until there are two samples
+ *
+ *****************************************************************************/
+void runStatsReset ( run_stats_t * s )
+{
+  s->n    = 0;
+  s->mean = 0;
+  s->m2   = 0;
+}
+
+void runStatsAdd ( run_stats_t * s, float x )
+{
+  float delta;
+  
+  s->n++;
+  delta    = x - s->mean;
+  s->mean += delta / s->n;
+  s->m2   += delta * ( x - s->mean );
+}
+
+float runStatsSD ( const run_stats_t * s )
+{
+  if ( s->n < 2 )
+  {
+    return 0;
+  }
+  return sqrtf ( s->m2 / ( s->n - 1 ) );
+}
+
+/******************************************************************************
+ *
+ *  Name: getStdChiRatio ( )
+ *
+ *  PARAMETERS: sub-count statistics
+ *
+ *  DESCRIPTION: Sub-counts are raw 7.5s counts / PRESCALE_7_5, so Poisson
+ *               statistics give a variance of mean / PRESCALE_7_5. The ratio
+ *               of the measured variance to that is the chi-square / (n-1)
+ *               of the Smart MC chi test, 1.0 for a healthy gauge.
+ *
+ *  RETURNS: variance ratio, 1.0 until there are two samples
+ *
+ *****************************************************************************/
+float getStdChiRatio ( const run_stats_t * s )
+{
+  if ( ( s->n < 2 ) || ( s->mean <= 0 ) )
+  {
+    return 1.0;
+  }
+  return ( s->m2 / ( s->n - 1 ) ) / ( s->mean / PRESCALE_7_5 );
+}
+
+/******************************************************************************
+ *
+ *  Name: stdSubCountOutlier ( )
+ *
+ *  PARAMETERS: statistics so far, new sub-count
+ *
+ *  DESCRIPTION: Screens a sub-count against the running mean, using the
+ *               larger of the measured and the Poisson standard deviation.
+ *
+ *  RETURNS: TRUE if the sub-count should be left out
+ *
+ *****************************************************************************/
+static BOOL stdSubCountOutlier ( const run_stats_t * s, float x )
+{
+  float sd, poisson_sd;
+  
+  if ( s->n < STD_SCREEN_MIN )
+  {
+    return FALSE;
+  }
+  sd = runStatsSD ( s );
+  poisson_sd = sqrtf ( s->mean / PRESCALE_7_5 );
+  if ( sd < poisson_sd )
+  {
+    sd = poisson_sd;
+  }
+  return ( fabsf ( x - s->mean ) > STD_OUTLIER_SIGMA * sd );
+}
+
+/******************************************************************************
+ *
+ *  Name: stdTubeSettled ( )
+ *
+ *  PARAMETERS: sub-count statistics, expected standard, pass fraction
+ *
+ *  DESCRIPTION: The standard for one tube is settled when the mean, give or
+ *               take STD_SETTLE_Z standard errors, is inside the pass band
+ *               around the expected standard and the scatter looks Poisson.
+ *
+ *  RETURNS: TRUE if more sub-counts can not change the pass
+ *
+ *****************************************************************************/
+static BOOL stdTubeSettled ( const run_stats_t * s, float ref, float pass )
+{
+  float chi, var, se;
+  
+  if ( ( ref <= 0 ) || ( s->n < STD_EARLY_MIN ) )
+  {
+    return FALSE;
+  }
+  chi = getStdChiRatio ( s );
+  if ( ( chi < STD_CHI_LOW ) || ( chi > STD_CHI_HIGH ) )
+  {
+    return FALSE;
+  }
+  var = s->mean / PRESCALE_7_5;
+  if ( var < s->m2 / ( s->n - 1 ) )
+  {
+    var = s->m2 / ( s->n - 1 );
+  }
+  se = sqrtf ( var / s->n );
+  
+  return ( ( fabsf ( s->mean - ref ) + STD_SETTLE_Z * se ) <= ( pass * ref ) );
+}
+
 /******************************************************************************
  *
  *  Name: measurePulses ( )
@@ -410,6 +610,8 @@ void measurePulses ( uint8_t line, uint8_t time1, uint16_t * moisture_count, uin
   uint16_t  i = 0;
   uint8_t  LCD_line;  //line3+11   
   uint32_t density_temp, moisture_temp,div_by; 
+  uint32_t min_counts = 0;
+  BOOL precision_stop = FALSE;
 
   uint8_t batt_flag;
   
@@ -573,6 +775,13 @@ void measurePulses ( uint8_t line, uint8_t time1, uint16_t * moisture_count, uin
   Controls.update_time = FALSE;
   LCD_timer = 0;  
  
+  // field readings may stop early once both tubes reach the target precision
+  if ( Features.adaptive_count && !Spec_flags.self_test && !Flags.in_spec_cal
+       && !Flags.stand_flag && !Flags.stat_flag && !Flags.drift_flag )
+  {
+    min_counts = getPrecisionMinCounts ( );
+  }
+ 
   resetPulseTimers ( );
   PulseCntStrt( time1 );
   
@@ -582,6 +791,8 @@ void measurePulses ( uint8_t line, uint8_t time1, uint16_t * moisture_count, uin
     uint32 timer;
     CyDelay ( 250 );
     i++;      
+    pulseQualityUpdate ( );
+    serviceShutDown ( );
 
       if( !Spec_flags.self_test )
       {
@@ -599,6 +810,19 @@ void measurePulses ( uint8_t line, uint8_t time1, uint16_t * moisture_count, uin
           }    
           break;
         }
+        if ( min_counts && ( checkCountDone() == FALSE ) )
+        {
+          last_count_ms = getPulseBinEdge ( &density_temp, &moisture_temp );
+          if ( ( last_count_ms >= PRECISION_MIN_MS ) && ( density_temp >= min_counts ) && ( moisture_temp >= min_counts ) )
+          {
+            last_count_rse = getCountRSE ( density_temp, moisture_temp );
+            density_temp   = deadTimeCorrect ( density_temp,  last_count_ms, PROBE_GM_COUNT );
+            moisture_temp  = deadTimeCorrect ( moisture_temp, last_count_ms, PROBE_HE3_COUNT );
+            stop_ONE_SHOT_Early();
+            precision_stop = TRUE;
+            break;
+          }
+        }
         if ( checkCountDone() == FALSE ) 
         {
           // The one shot counts at 1000HZ.
@@ -611,15 +835,29 @@ void measurePulses ( uint8_t line, uint8_t time1, uint16_t * moisture_count, uin
    }                               
                                    
 
-  if ( checkCountDone() == TRUE )  //count completed 
+  last_count_quality = getPulseQuality ( );
+  
+  if ( precision_stop )  // counts are up to the last bin edge, scale them to 3.75s
+  {
+    *density_count   = (uint32_t)( ((float)density_temp  * PRESCALE_MS) / last_count_ms );
+    *moisture_count  = (uint16_t)( ((float)moisture_temp * PRESCALE_MS) / last_count_ms );
+  }
+  else if ( checkCountDone() == TRUE )  //count completed 
   {
     density_temp  = getGMPulseCounts (); 
     moisture_temp = getHEPulseCounts (); 
+    last_count_ms = (uint32_t)time1 * 1000;
+    last_count_rse = getCountRSE ( density_temp, moisture_temp );
+    density_temp  = deadTimeCorrect ( density_temp,  last_count_ms, PROBE_GM_COUNT );
+    moisture_temp = deadTimeCorrect ( moisture_temp, last_count_ms, PROBE_HE3_COUNT );
 
     
     *density_count   = (uint32_t)(density_temp/div_by);
     *moisture_count  = (uint16_t)(moisture_temp/div_by);   
-    
+  }
+  
+  if ( precision_stop || ( checkCountDone() == TRUE ) )
+  {
     if ( !Spec_flags.self_test )
     {
      NV_MEMBER_STORE(M_CNT_AVG, *moisture_count);
@@ -680,6 +918,189 @@ void clearAndStartPulseTimer ( void )
  
 }
 
+/******************************************************************************
+ *
+ *  Name: statSequentialCheck ( )
+ *
+ *  PARAMETERS: running statistics of the 60s stat test counts of one tube
+ *
+ *  DESCRIPTION: Wald SPRT on the count variance. H0 is the Poisson variance
+ *               mean/PRESCALE_60 (ideal ratio 0.25), the alternatives are the
+ *               variances at RATIO_UPPER and RATIO_LOWER. With the sum of
+ *               squares q in units of the Poisson variance and nu = n-1,
+ *               LLR = -nu/2 ln(k) + q/2 (1 - 1/k) for variance factor k.
+ *               Gauges between the ideal and the limits stay ambiguous and
+ *               run the full series.
+ *
+ *  RETURNS: SEQ_PASS, SEQ_FAIL or SEQ_CONTINUE
+ *
+ *****************************************************************************/
+seq_result_t statSequentialCheck ( const run_stats_t * s )
+{
+  float ideal, k_hi, k_lo, nu, q, llr_hi, llr_lo, upper, lower;
+  
+  if ( ( s->n < SEQ_STAT_MIN ) || ( s->mean <= 0 ) )
+  {
+    return SEQ_CONTINUE;
+  }
+  ideal = sqrt ( PRESCALE_60 ) / PRESCALE_60;
+  k_hi  = ( RATIO_UPPER / ideal ) * ( RATIO_UPPER / ideal );
+  k_lo  = ( RATIO_LOWER / ideal ) * ( RATIO_LOWER / ideal );
+  nu    = s->n - 1;
+  q     = s->m2 / ( s->mean / PRESCALE_60 );
+  
+  llr_hi = -0.5 * nu * log ( k_hi ) + 0.5 * q * ( 1.0 - 1.0 / k_hi );
+  llr_lo = -0.5 * nu * log ( k_lo ) + 0.5 * q * ( 1.0 - 1.0 / k_lo );
+  upper  = log ( ( 1.0 - SEQ_BETA ) / SEQ_ALPHA );
+  lower  = log ( SEQ_BETA / ( 1.0 - SEQ_ALPHA ) );
+  
+  if ( ( llr_hi >= upper ) || ( llr_lo >= upper ) )
+  {
+    return SEQ_FAIL;
+  }
+  if ( ( llr_hi <= lower ) && ( llr_lo <= lower ) )
+  {
+    return SEQ_PASS;
+  }
+  return SEQ_CONTINUE;
+}
+
+/******************************************************************************
+ *
+ *  Name: statRatiosPass ( )
+ *
+ *  PARAMETERS: running statistics of the density and moisture stat counts
+ *
+ *  DESCRIPTION: The stat test pass criterion on the counts so far, so an
+ *               early stop always agrees with the ratios displayed.
+ *
+ *  RETURNS: TRUE if both ratios are inside RATIO_LOWER..RATIO_UPPER
+ *
+ *****************************************************************************/
+static BOOL statRatiosPass ( const run_stats_t * d, const run_stats_t * m )
+{
+  float d_ratio, m_ratio;
+  
+  if ( ( d->mean <= 0 ) || ( m->mean <= 0 ) )
+  {
+    return FALSE;
+  }
+  d_ratio = runStatsSD ( d ) / sqrt ( d->mean );
+  m_ratio = runStatsSD ( m ) / sqrt ( m->mean );
+  
+  return ( d_ratio >= RATIO_LOWER ) && ( d_ratio <= RATIO_UPPER ) && ( m_ratio >= RATIO_LOWER ) && ( m_ratio <= RATIO_UPPER );
+}
+
+/******************************************************************************
+ *
+ *  Name: driftSequentialCheck ( )
+ *
+ *  PARAMETERS: running statistics of the 240s drift counts of one tube,
+ *              stat test average, drift limit in %
+ *
+ *  DESCRIPTION: The drift is clear once it is SEQ_DRIFT_Z standard errors
+ *               inside or outside the limit. The standard error takes in
+ *               the Poisson scatter of both the drift mean and the 20 count
+ *               stat average it is compared with.
+ *
+ *  RETURNS: SEQ_PASS, SEQ_FAIL or SEQ_CONTINUE
+ *
+ *****************************************************************************/
+seq_result_t driftSequentialCheck ( const run_stats_t * s, float stat_avg, float limit )
+{
+  float avg, per, se;
+  
+  if ( ( s->n < SEQ_DRIFT_MIN ) || ( stat_avg <= 0 ) )
+  {
+    return SEQ_CONTINUE;
+  }
+  avg = ( stat_avg + s->mean ) / 2.0;
+  per = 100.0 * fabsf ( stat_avg - s->mean ) / avg;
+  se  = 100.0 * sqrt ( s->mean / PRESCALE_240 / s->n + stat_avg / PRESCALE_60 / STAT_COUNTS ) / avg;
+  
+  if ( per - SEQ_DRIFT_Z * se > limit )
+  {
+    return SEQ_FAIL;
+  }
+  if ( per + SEQ_DRIFT_Z * se <= limit )
+  {
+    return SEQ_PASS;
+  }
+  return SEQ_CONTINUE;
+}
+
+/******************************************************************************
+ *
+ *  Name: statSequentialStop ( ), driftSequentialStop ( )
+ *
+ *  PARAMETERS: running statistics of the density and moisture counts so
+ *              far, for the drift test also the stat test averages
+ *
+ *  DESCRIPTION: Whether the stat or drift test can stop after the latest
+ *               count. The stat test stops when both tubes clearly pass,
+ *               or one clearly fails, and the ratios so far agree. The
+ *               drift test stops when both drifts are clearly inside, or
+ *               one clearly outside, its limit.
+ *
+ *  RETURNS: SEQ_PASS, SEQ_FAIL or SEQ_CONTINUE
+ *
+ *****************************************************************************/
+seq_result_t statSequentialStop ( const run_stats_t * d, const run_stats_t * m )
+{
+  seq_result_t d_seq = statSequentialCheck ( d );
+  seq_result_t m_seq = statSequentialCheck ( m );
+  
+  if ( ( d_seq == SEQ_PASS ) && ( m_seq == SEQ_PASS ) && statRatiosPass ( d, m ) )
+  {
+    return SEQ_PASS;
+  }
+  if ( ( ( d_seq == SEQ_FAIL ) || ( m_seq == SEQ_FAIL ) ) && !statRatiosPass ( d, m ) )
+  {
+    return SEQ_FAIL;
+  }
+  return SEQ_CONTINUE;
+}
+
+seq_result_t driftSequentialStop ( const run_stats_t * d, const run_stats_t * m, float d_stat_avg, float m_stat_avg )
+{
+  seq_result_t d_seq = driftSequentialCheck ( d, d_stat_avg, DRIFT_DENSE_LIMIT );
+  seq_result_t m_seq = driftSequentialCheck ( m, m_stat_avg, DRIFT_MOIST_LIMIT );
+  
+  if ( ( d_seq == SEQ_FAIL ) || ( m_seq == SEQ_FAIL ) )
+  {
+    return SEQ_FAIL;
+  }
+  if ( ( d_seq == SEQ_PASS ) && ( m_seq == SEQ_PASS ) )
+  {
+    return SEQ_PASS;
+  }
+  return SEQ_CONTINUE;
+}
+
+/******************************************************************************
+ *
+ *  Name: logSequentialTest ( )
+ *
+ *  PARAMETERS: test name, counts taken, full series length, dense and moist
+ *              averages and results
+ *
+ *  DESCRIPTION: Appends the outcome of a stat or drift test to the SD log
+ *               so early decisions can be checked against full series.
+ *
+ *  RETURNS: NA
+ *
+ *****************************************************************************/
+static void logSequentialTest ( char * test, uint8_t n, uint8_t full, int32_t d_avg, int32_t m_avg, float d_res, float m_res, BOOL pass )
+{
+  char date_string[30];
+  char line[100];
+  
+  getTimeDateStr ( date_time_g, date_string );
+  snprintf ( line, 100, "%s,%s,%u/%u,%s,%s,%ld,%ld,%.3f,%.3f", test, date_string, n, full, ( n < full ) ? "EARLY" : "FULL",
+             pass ? "PASS" : "FAIL", (long)d_avg, (long)m_avg, (double)d_res, (double)m_res );
+  SD_AppendLog ( SEQ_LOG_FILE, line );
+}
+
 /******************************************************************************
  *
  *  Name: measurePulses ( )
@@ -693,9 +1114,10 @@ void clearAndStartPulseTimer ( void )
  *
  *****************************************************************************/ 
 
-void measurePulsesStandardCount ( uint8_t line, uint32_t * moisture_count, uint32_t * density_count )  // acquires moisture and density count during tests 
+void measurePulsesStandardCount ( uint8_t line, std_stats_t * stats )  // acquires moisture and density count during tests 
 {
   uint8_t  n, LCD_line, sec;  //line3+11   
+  uint32_t density_count, moisture_count;
   uint8_t batt_flag;
   uint32 timer, i;
   float elapsed_time;
@@ -730,6 +1152,12 @@ void measurePulsesStandardCount ( uint8_t line, uint32_t * moisture_count, uint3
   
   display_time(240,line );
   
+  runStatsReset ( &stats->d );
+  runStatsReset ( &stats->m );
+  stats->taken    = 0;
+  stats->rejected = 0;
+  stats->early    = FALSE;
+  
   // get the start of the test
   timer = msTimer;   
   for ( n = 0; n < SMART_MC_CHI_COUNTS; n++ ) // take 32, 7.5 second counts
@@ -777,8 +1205,38 @@ void measurePulsesStandardCount ( uint8_t line, uint32_t * moisture_count, uint3
    }// exit for() loop
    
     // read in the counts
-    density_count[n]  = getGMPulseCounts()/PRESCALE_7_5;            
-    moisture_count[n] = getHEPulseCounts()/PRESCALE_7_5;            
+    density_count  = deadTimeCorrect ( getGMPulseCounts(), 7500, PROBE_GM_COUNT )/PRESCALE_7_5;            
+    moisture_count = deadTimeCorrect ( getHEPulseCounts(), 7500, PROBE_HE3_COUNT )/PRESCALE_7_5;            
+    stats->taken++;
+    
+    // screen the sub-count, then fold it into the running statistics
+    if ( stdSubCountOutlier ( &stats->d, density_count ) || stdSubCountOutlier ( &stats->m, moisture_count ) )
+    {
+      stats->rejected++;
+    }
+    else
+    {
+      runStatsAdd ( &stats->d, density_count );
+      runStatsAdd ( &stats->m, moisture_count );
+    }
+    
+    sprintf ( lcdstr, "D%5.0f s%4.1f R%4.2f", (double)stats->d.mean, (double)runStatsSD ( &stats->d ), (double)getStdChiRatio ( &stats->d ) );
+    LCD_PrintAtPosition ( lcdstr, LINE1 );
+    sprintf ( lcdstr, "M%5.0f s%4.1f R%4.2f", (double)stats->m.mean, (double)runStatsSD ( &stats->m ), (double)getStdChiRatio ( &stats->m ) );
+    LCD_PrintAtPosition ( lcdstr, LINE3 );
+    if ( stats->rejected )
+    {
+      LCD_position ( line );
+      _LCD_PRINTF ( "Rej:%u", stats->rejected );
+    }
+    
+    if ( Features.std_early_accept && ( stats->rejected <= STD_MAX_REJECTS )
+         && stdTubeSettled ( &stats->d, stats->d_ref, DENSITY_PASS_PERCENT )
+         && stdTubeSettled ( &stats->m, stats->m_ref, MOISTURE_PASS_PERCENT ) )
+    {
+      stats->early = TRUE;
+      break;
+    }
  } // finished 32 counts                                
   
     
@@ -813,9 +1271,9 @@ void measurePulsesStandardCount ( uint8_t line, uint32_t * moisture_count, uint3
 /////TEST FUNCTIONS/////////////////////////////////////////////////////////////
 void stand_test(void)  // leads user through standard count procedure (STD button initiates)
 {
-  int8_t tests = 0, tests_tot = 0, index,n;
+  int8_t tests = 0, tests_tot = 0, index;
   uint16_t moisture_count[4],moisture_cnt ;
-  uint32_t density_cnt,density_count[4],density[SMART_MC_CHI_COUNTS],moisture[SMART_MC_CHI_COUNTS],moisture_mean,density_mean;
+  uint32_t density_cnt,density_count[4],moisture_mean,density_mean;
   int32_t date_int;
   
   float percent_diff_dense, percent_diff_moist, avg_std_moist, avg_std_dense, d_stand_cal;
@@ -825,6 +1283,8 @@ void stand_test(void)  // leads user through standard count procedure (STD butto
   uint16_t d_stand;
   uint16_t m_stand;
   float temp, moist_sd,density_sd ;
+  std_stats_t std_stats;
+  BOOL ref_known;
 
   static uint8 dummy_tests = 0;
 
@@ -912,39 +1372,75 @@ void stand_test(void)  // leads user through standard count procedure (STD butto
 		    };
 
 
+        // the reference the new standard is checked against, known before the count so
+        // the standard can be accepted early
+        ref_known = TRUE;
+        density_count[0] = NV_RAM_MEMBER_RD(stand_test.dense_count_1);  // the stored standards, shifted along once this one is kept
+        density_count[1] = NV_RAM_MEMBER_RD(stand_test.dense_count_2);
+        density_count[2] = NV_RAM_MEMBER_RD(stand_test.dense_count_3);
+        
+        moisture_count[0] = NV_RAM_MEMBER_RD(stand_test.moist_count_1);
+        moisture_count[1] = NV_RAM_MEMBER_RD(stand_test.moist_count_2);
+        moisture_count[2] = NV_RAM_MEMBER_RD(stand_test.moist_count_3);
+        
+        if(Features.avg_std_mode == TRUE)                 // this mode will compare the new standards to a rolling average of the last four valid
+        {                                                 // measurements and display the % error.
+          tests = NV_RAM_MEMBER_RD(stand_test.std_number);             //get number of tests completed
+          
+          if (tests == 2 )
+          {
+           // average the last two "stored" readings
+            avg_std_dense = ((float)density_count[0] + (float)d_stand)/2.0;
+            avg_std_moist = ((float)moisture_count[0] + (float)m_stand)/2.0;
+          }
+          else if (tests == 3 )
+          {
+           // average the last three "stored" readings
+            avg_std_dense = ((float)density_count[0] + (float)density_count[1] + (float)d_stand)/3.0;
+            avg_std_moist = ((float)moisture_count[0] + (float)moisture_count[1] + (float)m_stand)/3.0;
+          }
+          else if ( tests == 4 )
+          {
+            // average the last four "stored" readings
+            avg_std_dense = ((float)density_count[0] + (float)density_count[1] + (float)density_count[2] + (float)d_stand)/4.0;
+            avg_std_moist = ((float)moisture_count[0] + (float)moisture_count[1] + (float)moisture_count[2] + (float)m_stand)/4.0;
+          }
+          else // test = 1 or 0, the new count becomes the reference
+          {
+            ref_known = FALSE;
+            avg_std_dense = 0;
+            avg_std_moist = 0;
+          }
+      
+        }
+        else // Not in averaging mode
+        {
+          d_stand_cal   =  (float)NV_RAM_MEMBER_RD(DENSE_CAL_STD); //read calibrated standard counts from memory
+          avg_std_moist =  (float)NV_RAM_MEMBER_RD(MOIST_CAL_STD);
+               
+          // gets days since last calibration
+  
+          date_int = decode_date( date_time_g ) - decode_date ( NV_RAM_MEMBER_RD (Constants.CAL_DATE) );  
+  
+          temp = (-0.693/(30.0 * 365.25)) * (float)date_int;         
+          temp = pow ( 2.71828183, temp );
+          avg_std_dense = d_stand_cal * temp;
+        }          
+        std_stats.d_ref = avg_std_dense;
+        std_stats.m_ref = avg_std_moist;
+
         CLEAR_DISP;
-        measurePulsesStandardCount(LINE4, &moisture[0], &density[0]);  // 4 minute test, 240 sec
+        measurePulsesStandardCount(LINE4, &std_stats);  // 4 minute test, 240 sec
        
        if ( button == ESC )          
        {
         break;
        }
-        moisture_mean = 0;
-        density_mean  = 0;
-        // get the average of the counts
-        for ( n =0; n < SMART_MC_CHI_COUNTS; n++ )
-        {
-         moisture_mean += moisture[n];
-         density_mean += density[n];
-        } 
-        moisture_mean /= SMART_MC_CHI_COUNTS;    // unprescaled count
-        density_mean  /= SMART_MC_CHI_COUNTS;    // unprescaled count
-
-        
-        // get the SD of the counts
-        moist_sd = density_sd = 0;
-        for ( n =0; n < SMART_MC_CHI_COUNTS; n++ )
-        {
-          temp = (float)(moisture_mean) - (float)moisture[n];
-          moist_sd += (temp*temp);
-          temp = (float)(density_mean) - (float)density[n];
-          density_sd += (temp*temp);
-        } 
-        moist_sd /= (SMART_MC_CHI_COUNTS - 1);
-        density_sd /= (SMART_MC_CHI_COUNTS - 1);
-
-        moist_sd = sqrtf(moist_sd);
-        density_sd = sqrtf(density_sd);
+        // mean and SD of the accepted sub-counts, kept up to date during the count
+        moisture_mean = (uint32_t)std_stats.m.mean;    // unprescaled count
+        density_mean  = (uint32_t)std_stats.d.mean;    // unprescaled count
+        moist_sd   = runStatsSD ( &std_stats.m );
+        density_sd = runStatsSD ( &std_stats.d );
 
 
         density_cnt  =  density_mean ;
@@ -983,56 +1479,25 @@ void stand_test(void)  // leads user through standard count procedure (STD butto
 
         //COUNT COMPLETED WITHOUT INTERRUPTION//    
         Controls.shut_dwn = FALSE;                        // disable shut down feature when NO is pressed
-        if(Features.avg_std_mode == TRUE)                 // this mode will compare the new standards to a rolling average of the last four valid
-        {                                                 // measurements and display the % error.
-          density_count[0] = NV_RAM_MEMBER_RD(stand_test.dense_count_1);
-          density_count[1] = NV_RAM_MEMBER_RD(stand_test.dense_count_2);
-          density_count[2] = NV_RAM_MEMBER_RD(stand_test.dense_count_3);
-          
-          moisture_count[0] = NV_RAM_MEMBER_RD(stand_test.moist_count_1);
-          moisture_count[1] = NV_RAM_MEMBER_RD(stand_test.moist_count_2);
-          moisture_count[2] = NV_RAM_MEMBER_RD(stand_test.moist_count_3);
-          
-          tests = NV_RAM_MEMBER_RD(stand_test.std_number);             //get number of tests completed
-          
-          if (tests == 2 )
-          {
-           // average the last two "stored" readings
-            avg_std_dense = ((float)density_count[0] + (float)d_stand)/2.0;
-            avg_std_moist = ((float)moisture_count[0] + (float)m_stand)/2.0;
-          }
-          else if (tests == 3 )
-          {
-           // average the last three "stored" readings
-            avg_std_dense = ((float)density_count[0] + (float)density_count[1] + (float)d_stand)/3.0;
-            avg_std_moist = ((float)moisture_count[0] + (float)moisture_count[1] + (float)m_stand)/3.0;
-          }
-          else if ( tests == 4 )
-          {
-            // average the last four "stored" readings
-            avg_std_dense = ((float)density_count[0] + (float)density_count[1] + (float)density_count[2] + (float)d_stand)/4.0;
-            avg_std_moist = ((float)moisture_count[0] + (float)moisture_count[1] + (float)moisture_count[2] + (float)m_stand)/4.0;
-          }
-          else // test = 1 or 0
+        if ( !ref_known )                                 // nothing to compare with yet, the new count is the reference
+        {
+          avg_std_dense = (float)density_cnt;
+          avg_std_moist = (float)moisture_cnt;
+        }
+        if ( std_stats.early || std_stats.rejected )
+        { // say why the standard is not the usual 32 sub-counts
+          CLEAR_DISP;
+          LCD_position(LINE1);
+          if ( std_stats.early )
           {
-            avg_std_dense = (float)density_cnt;
-            avg_std_moist = (float)moisture_cnt;
+            _LCD_PRINTF ( "Accepted at %us", (uint16_t)( std_stats.taken * 15 / 2 ) );
           }
-      
+          LCD_position(LINE2);
+          _LCD_PRINTF ( "Outliers: %u", std_stats.rejected );
+          sprintf ( lcdstr, "SD D:%.1f M:%.1f", (double)density_sd, (double)moist_sd );
+          LCD_PrintAtPosition ( lcdstr, LINE3 );
+          delay_ms ( 2000 );
         }
-        else // Not in averaging mode
-        {
-          d_stand_cal   =  (float)NV_RAM_MEMBER_RD(DENSE_CAL_STD); //read calibrated standard counts from memory
-          avg_std_moist =  (float)NV_RAM_MEMBER_RD(MOIST_CAL_STD);
-               
-          // gets days since last calibration
-  
-          date_int = decode_date( date_time_g ) - decode_date ( NV_RAM_MEMBER_RD (Constants.CAL_DATE) );  
-  
-          temp = (-0.693/(30.0 * 365.25)) * (float)date_int;         
-          temp = pow ( 2.71828183, temp );
-          avg_std_dense = d_stand_cal * temp;
-        }          
         percent_diff_dense = ((float)density_cnt - avg_std_dense) / avg_std_dense;       //calculate % difference in density cnt from rolling avg.
         if(fabsf(percent_diff_dense) > DENSITY_PASS_PERCENT)
         {
@@ -1146,11 +1611,13 @@ void stand_test(void)  // leads user through standard count procedure (STD butto
 uint8_t stat_test(void)  // leads user through static test procedure
 {  
   Bool     auto_scroll_advance = 0;
-  int8_t   display_set = 0,  pass_fail = 0, i;
+  int8_t   display_set = 0,  pass_fail = 0, i, n_counts = 0;
   int32_t  mc_sub  = 0,     dc_sub = 0, delta = 0,loop_cnt ;
+  run_stats_t d_run, m_run;
   int32_t  dc_sum = 0,      mc_sum = 0;  
   float    dc_std = 0,     dc_theo = 0, mc_std = 0, mc_theo = 0;
   char pass = 'P', fail = 'F';
+  BOOL stat_pass;
   enum buttons button;
 
   uint16_t moisture_cnt = 0;
@@ -1195,7 +1662,9 @@ uint8_t stat_test(void)  // leads user through static test procedure
   	};
 
     reading();  // display "Reading # " on LINE2
-    for(i=0; i<20; i++)                             // loop for taking (20) 1 minute counts
+    runStatsReset ( &d_run );
+    runStatsReset ( &m_run );
+    for(i=0; i<STAT_COUNTS; i++)                    // loop for taking (20) 1 minute counts
     {      
       LCD_position(LINE2+10);
       _LCD_PRINTF ( "%d",(i+1));
@@ -1221,6 +1690,15 @@ uint8_t stat_test(void)  // leads user through static test procedure
       stat_moist[i] = moisture_cnt;
       dc_sum += (int32_t)density_cnt;  
       mc_sum += (int32_t)moisture_cnt; 
+      n_counts = i + 1;
+      
+      // stop as soon as the ratios are clearly good or clearly bad
+      runStatsAdd ( &d_run, density_cnt );
+      runStatsAdd ( &m_run, moisture_cnt );
+      if ( statSequentialStop ( &d_run, &m_run ) != SEQ_CONTINUE )
+      {
+        break;
+      }
     }
     
     if(Controls.LCD_light)    
@@ -1233,23 +1711,34 @@ uint8_t stat_test(void)  // leads user through static test procedure
       break;     
     }  
     
-    stat_dense_avg = dc_sum / 20;
-    stat_moist_avg = mc_sum / 20;
+    for ( i = n_counts; i < STAT_COUNTS; i++ )    // counts not needed after an early decision
+    {
+      stat_dense[i] = 0;
+      stat_moist[i] = 0;
+    }
+    
+    stat_dense_avg = dc_sum / n_counts;
+    stat_moist_avg = mc_sum / n_counts;
     dc_theo = sqrt((float)stat_dense_avg );
     mc_theo = sqrt((float)stat_moist_avg );
         
-    for(i=0; i<20; i++)
+    for(i=0; i<n_counts; i++)
     {        
       delta = (int32_t)stat_dense[i] - stat_dense_avg;  //+-
       dc_sub += (delta * delta); //+
       delta = (int32_t)stat_moist[i] - stat_moist_avg; //+-
       mc_sub += (delta * delta); //+
     }
-    dc_std = sqrt((float)dc_sub / 19.0); //+
-    mc_std = sqrt((float)mc_sub / 19.0); //+
+    dc_std = sqrt((float)dc_sub / (n_counts - 1)); //+
+    mc_std = sqrt((float)mc_sub / (n_counts - 1)); //+
     stat_dense_ratio = dc_std / (dc_theo ); //+
     stat_moist_ratio = mc_std / (mc_theo);  //+
     
+    stat_pass = ( stat_dense_ratio >= test_ratio_lower ) && ( stat_dense_ratio <= test_ratio_upper )
+                && ( stat_moist_ratio >= test_ratio_lower ) && ( stat_moist_ratio <= test_ratio_upper );
+    NV_MEMBER_STORE ( st_pass_fail, (uint16_t)( ( n_counts << 8 ) | !stat_pass ) );
+    logSequentialTest ( "STAT", n_counts, STAT_COUNTS, stat_dense_avg, stat_moist_avg, stat_dense_ratio, stat_moist_ratio, stat_pass );
+    
     NV_MEMBER_STORE(D_CNT_STD, (uint16_t)stat_dense_avg);            //store values for L% calc in drift test
     NV_MEMBER_STORE(M_CNT_STD, (uint16_t)stat_moist_avg);
 	
@@ -1437,6 +1926,8 @@ void drift_test(void)  // leads user through drift test procedure
   int8_t display_set = 1, i;
   int32_t dc_sum = 0, mc_sum = 0, dc_statavg, mc_statavg, loop_cnt;
   int32_t delta_1 = 0, delta = 0;
+  int8_t n_counts = 0;
+  run_stats_t d_run, m_run;
   char  pass = 'P', fail = 'F'; 
   enum buttons button;
   uint16_t moisture_cnt = 0;
@@ -1477,7 +1968,11 @@ void drift_test(void)  // leads user through drift test procedure
    
     // Get the 5, 4 minute readings
     reading();  // display "Reading # " on LINE2
-    for(i=0; i<5; i++)
+    dc_statavg = NV_RAM_MEMBER_RD(D_CNT_STD);            // retreive stat values from EEPROM
+    mc_statavg = NV_RAM_MEMBER_RD(M_CNT_STD);            
+    runStatsReset ( &d_run );
+    runStatsReset ( &m_run );
+    for(i=0; i<DRIFT_COUNTS; i++)
     {      
       LCD_position (LINE2+10);
       _LCD_PRINTF ( "%d ",(i+1) );
@@ -1496,7 +1991,16 @@ void drift_test(void)  // leads user through drift test procedure
       dc_sum += density_cnt;
       drift_moist[i] = moisture_cnt;
       mc_sum += moisture_cnt;
+      n_counts = i + 1;
       delay_ms(10);
+      
+      // stop once both drifts are clearly inside, or one clearly outside, the limits
+      runStatsAdd ( &d_run, density_cnt );
+      runStatsAdd ( &m_run, moisture_cnt );
+      if ( driftSequentialStop ( &d_run, &m_run, dc_statavg, mc_statavg ) != SEQ_CONTINUE )
+      {
+        break;
+      }
     }
     
     Flags.drift_flag = FALSE;
@@ -1511,10 +2015,14 @@ void drift_test(void)  // leads user through drift test procedure
       break;
     }      
     
-    drift_dense_avg = dc_sum / 5;
-    drift_moist_avg = mc_sum / 5;
-    dc_statavg = NV_RAM_MEMBER_RD(D_CNT_STD);            // retreive stat values from EEPROM
-    mc_statavg = NV_RAM_MEMBER_RD(M_CNT_STD);            
+    for ( i = n_counts; i < DRIFT_COUNTS; i++ )   // counts not needed after an early decision
+    {
+      drift_dense[i] = 0;
+      drift_moist[i] = 0;
+    }
+    
+    drift_dense_avg = dc_sum / n_counts;
+    drift_moist_avg = mc_sum / n_counts;
     delta = dc_statavg - drift_dense_avg;
     delta_1 = (dc_statavg + drift_dense_avg) / 2;                         // new code
     
@@ -1545,6 +2053,9 @@ void drift_test(void)  // leads user through drift test procedure
 	//********************************* copies the below statement from if(diag)
 	  NV_MEMBER_STORE( dr_dense_avg,drift_dense_avg );
   	NV_MEMBER_STORE ( dr_moist_avg,drift_moist_avg );
+    NV_MEMBER_STORE ( dr_counts_used, (uint8)n_counts );
+    logSequentialTest ( "DRIFT", n_counts, DRIFT_COUNTS, drift_dense_avg, drift_moist_avg, drift_dense_per, drift_moist_per,
+                        ( drift_dense_per <= DRIFT_DENSE_LIMIT ) && ( drift_moist_per <= DRIFT_MOIST_LIMIT ) );
 	
  	  if ( Flags.diag )
     { //write results to EEPROM     
@@ -1564,7 +2075,7 @@ void drift_test(void)  // leads user through drift test procedure
         LCD_position (LINE1);
         stat_drift_count_text(0); //TEXT// display "D% Drift = "
         
-        sprintf( lcdstr,"%.2f %c", (double)drift_dense_per, (drift_dense_per <=0.5) ? pass : fail);
+        sprintf( lcdstr,"%.2f %c", (double)drift_dense_per, (drift_dense_per <= DRIFT_DENSE_LIMIT) ? pass : fail);
         LCD_print (lcdstr);
         
         LCD_position (LINE2);
@@ -1573,7 +2084,7 @@ void drift_test(void)  // leads user through drift test procedure
             
         LCD_position (LINE3);
         stat_drift_count_text(2); //TEXT// display "M%% Drift = "
-        sprintf ( lcdstr,"%.2f %c",(double)drift_moist_per, (drift_moist_per <= 1.0) ? pass : fail);
+        sprintf ( lcdstr,"%.2f %c",(double)drift_moist_per, (drift_moist_per <= DRIFT_MOIST_LIMIT) ? pass : fail);
         LCD_print ( lcdstr );
         
         LCD_position (LINE4);
@@ -37,6 +37,7 @@
 #include "UARTS.h"
 #include "BlueTooth.h"
 #include "Batteries.h"
+#include "PulseCounter.h"
 #include <FS.h>
 /************************************* EXTERNAL VARIABLE AND BUFFER DECLARATIONS  *************************************/
  extern uint8_t getCalibrationDepth ( uint8_t depth_inches );
@@ -227,7 +228,7 @@ void SendBleReset() {
  *****************************************************************************/ 
 void SendBLEData ( station_data_t * ble_data, bool isRecall )
 {  // BUF CONTAINS DATA WITHOUT BEGIN AND END FLAGS
-    uint16 len = sizeof(station_data_t);
+    uint16 len = STATION_FIXED_SIZE;  // the packet keeps the shipped station layout
     ble_data->battery_voltage[0] = readBatteryVoltage(NICAD) ;
     ble_data->battery_voltage[1] = readBatteryVoltage(ALK) ;
     BlueToothUartPutPktHeaderDelay(CMD_FLAG_READ, len + PROJ_NAME_LENGTH + sizeof(bool));
@@ -904,6 +905,7 @@ void raw_count_test (void )
   uint16_t moisture_cnt = 0;
   uint32_t density_1_2_cnt = 0;
   uint32_t density_cnt = 0;
+  pulse_isr_stats_t isr_stats;
   
   enum buttons button;
     
@@ -935,14 +937,49 @@ void raw_count_test (void )
   // run count for 5 seconds
   measurePulses ( LINE3, 15, &moisture_cnt, &density_cnt, tst_depth_g);  
   Spec_flags.self_test = FALSE;
+  getPulseIsrStats ( &isr_stats );
   
   display_count_text ( moisture_cnt, density_cnt, density_1_2_cnt );
 
-  while(1)
+  button = getKey( TIME_DELAY_MAX );
+  if ( button == ESC )
   {
-    button = getKey( TIME_DELAY_MAX );
-    break;
+    return;
+  }
+  
+  // reload interrupt load and lost reloads of the last count
+  CLEAR_DISP;
+  LCD_position(LINE1);
+  _LCD_PRINTF("Reload: %u",isr_stats.reload);
+  LCD_position(LINE2);
+  _LCD_PRINTF("ISR/s GM:%lu",(unsigned long)getPulseIsrRate ( &isr_stats, PROBE_GM_COUNT ));
+  LCD_position(LINE3);
+  _LCD_PRINTF("ISR/s He3:%lu",(unsigned long)getPulseIsrRate ( &isr_stats, PROBE_HE3_COUNT ));
+  LCD_position(LINE4);
+  _LCD_PRINTF("Miss GM:%lu",(unsigned long)getMissedReloads ( &isr_stats, PROBE_GM_COUNT ));
+  LCD_position(LINE4+11);
+  _LCD_PRINTF("He3:%lu",(unsigned long)getMissedReloads ( &isr_stats, PROBE_HE3_COUNT ));
+  button = getKey( TIME_DELAY_MAX );
+  if ( button == ESC )
+  {
+    return;
+  }
+  
+  // worst interrupt entry latency, and whether either count can be trusted
+  CLEAR_DISP;
+  LCD_position(LINE1);
+  _LCD_PRINT("Worst ISR Latency");
+  LCD_position(LINE2);
+  _LCD_PRINTF("%lu us",(unsigned long)getWorstIsrLatencyUs ( &isr_stats ));
+  if ( checkPulseIntegrity ( &isr_stats, PROBE_GM_COUNT ) && checkPulseIntegrity ( &isr_stats, PROBE_HE3_COUNT ) )
+  {
+    LCD_PrintAtPosition ( "Counters OK", LINE4 );
   }
+  else
+  {
+    LCD_PrintAtPosition ( "COUNTER WARNING", LINE4 );
+  }
+  button = getKey( TIME_DELAY_MAX );
 
 }
 
@@ -1353,6 +1390,124 @@ void check_depth (void )
 
 
 
+/******************************************************************************
+ *
+ *  Name: auto_shut_down ( void )
+ *
+ *  PARAMETERS: NA
+ *
+ *  DESCRIPTION: Powers the gauge off after the inactivity time, with
+ *               OFF_MODE set to auto shutdown.
+ *            
+ *  RETURNS: NA 
+ *
+ *****************************************************************************/ 
+
+void auto_shut_down ( void )
+{
+      Flags.stand_flag = FALSE;
+      Controls.shut_dwn = TRUE;                           // set when "auto" shut off is enabled   
+      
+      // update status of shutdown, 1 = auto shutdown 
+      NV_MEMBER_STORE(OFF_MODE,1);
+          
+      // write all flag settings to memory      
+      NV_MEMBER_STORE( OFFSET_SETTINGS,Offsets);
+       
+      //NV_MEMBER_STORE( FEATURE_SETTINGS, Features );
+         
+      NV_MEMBER_STORE( FLAG_SETTINGS, Flags );          
+     
+      Controls_U.controls_bitfield = &Controls;     
+      NV_MEMBER_STORE( CONTROL_SETTINGS, Controls );     
+	    Global_ID();                                                 // shutdown all competition.
+
+	    shutdown_inactivity_text_text();
+       // flash the keyboard backlight
+      KEY_B_LIGHT_ENABLE(); 		                    // turn on keyboard backlight                  
+      delay_ms(1000);    
+     	KEY_B_LIGHT_DISABLE();                       // turn OFF keyboard backlight
+      delay_ms(1000);
+      Global_ID();
+      
+      MICRO_POWER_DISABLE();
+           
+      while(1) 
+      {
+       delay_ms(100);  
+       MICRO_POWER_DISABLE();
+      };    
+}
+
+
+/******************************************************************************
+ *
+ *  Name: requestShutDown, serviceShutDown, checkShutDownWait
+ *
+ *  PARAMETERS: mode  MANUAL for the power key, AUTO for the inactivity time
+ *
+ *  DESCRIPTION: The power off requests come from ISRs, which may have
+ *               stopped the main context inside an emFile call. With the
+ *               card unmounted the gauge powers off at once. Otherwise the
+ *               request is left to serviceShutDown, called by the main
+ *               context where no file call is under way (key waits and the
+ *               count poll), which unmounts the card first. If the main
+ *               context does not get there within SHUT_DOWN_WAIT_MS the
+ *               ms tick powers off anyway.
+ *            
+ *  RETURNS: NA 
+ *
+ *****************************************************************************/ 
+
+static volatile uint8  shutDownPending = FALSE;
+static volatile uint8  shutDownMode;
+static volatile uint32 shutDownAskedMs;
+
+static void runShutDown ( uint8 mode )
+{
+  if ( mode == AUTO )
+  {
+    auto_shut_down ( );
+  }
+  else
+  {
+    shut_down_text ( );
+  }
+}
+
+void requestShutDown ( uint8 mode )
+{
+  if ( shutDownPending )
+  {
+    return;
+  }
+  if ( sdOpened == OFF )
+  {
+    runShutDown ( mode );
+  }
+  shutDownMode    = mode;
+  shutDownAskedMs = msTimer;
+  shutDownPending = TRUE;
+}
+
+void serviceShutDown ( void )
+{
+  if ( shutDownPending )
+  {
+    SDunmount ( );  // write back the SD cache and unmount before the power goes
+    runShutDown ( shutDownMode );
+  }
+}
+
+void checkShutDownWait ( void )
+{
+  if ( shutDownPending && ( ( msTimer - shutDownAskedMs ) > SHUT_DOWN_WAIT_MS ) )
+  {
+    runShutDown ( shutDownMode );
+  }
+}
+
+
 /******************************************************************************
  *
  *  Name: 
@@ -29,6 +29,10 @@ char GGA_data = 0;
 
 GPSDATA gdata;
 
+static GPSDATA gps_snap;                // last GGA sentence with a valid fix
+static uint32  gps_snap_ms;             // msTimer when gps_snap was taken
+static uint8   gps_snap_ok = 0;
+
 char gps_Buff[rxBufSize];       // receive string storage buffer
 
 void checkGPSFix();
@@ -68,6 +72,12 @@ CY_ISR(GPS_RX_ISR)
         GGA_data = 1;
         checkGPSFix();
         parseGPSString();
+        if ( ( gps_fix == '1' ) || ( gps_fix == '2' ) )
+        {
+          gps_snap    = gdata;
+          gps_snap_ms = msTimer;
+          gps_snap_ok = 1;
+        }
        }
 		  }
       rxIndx = 0;
@@ -108,6 +118,34 @@ void clearGPSData ( )
 
 
 
+/*
+ *  FUNCTION: gpsGetSnapshot
+ *
+ *  PARAMETERS: fix filled with the newest valid fix, age_ms its age
+ *
+ *  DESCRIPTION: The receive interrupt keeps the newest GGA sentence that
+ *               had a fix, so a reading takes its position without
+ *               waiting for the next 1PPS sentence.
+ *
+ *  RETURNS: 1 if a fix has been seen since the GPS was started, else 0
+ *
+ */
+
+uint8 gpsGetSnapshot ( GPSDATA * fix, uint32 * age_ms )
+{
+  uint8 int_state, ok;
+  
+  int_state = CyEnterCriticalSection();
+  ok = gps_snap_ok;
+  if ( ok )
+  {
+    *fix    = gps_snap;
+    *age_ms = msTimer - gps_snap_ms;
+  }
+  CyExitCriticalSection ( int_state );
+  return ok;
+}
+
 /*
  *  FUNCTION: checkGPSFix
  *
@@ -356,6 +394,7 @@ void initGPS ( void )
   UART_GPS_Stop();
   rxIndx = 0;
   GGA_data = 0 ;
+  gps_snap_ok = 0;
    
   GPS_EN_REG_Write ( 0 );
   UART_GPS_Start();
@@ -373,6 +412,7 @@ void disableGPS ( void )
   UART_GPS_Stop();        // stop the UART
   GPS_EN_REG_Write( 1 );  // power down the GPS 
   isrGPS_RX_Disable();    // diable the interrupt
+  gps_snap_ok = 0;
 }
 
   
@@ -38,6 +38,8 @@
 #include "Batteries.h"
 #include "UARTS.H"
 #include "ProjectData.h"
+#include "SDcard.h"
+#include "Measurement.h"
 /*-------------------------[   Global Functions   ]---------------------------*/
 extern void pulseBuzzer ( void );
 extern void print_menu ( void ); 
@@ -110,7 +112,7 @@ void CheckBleVersion()
 
 int main() { //initialization and main loop
   //uint32_t size_proj;
-  uint8_t last_power_down, auto_depth_timer = 0, refresh = 0;
+  uint8_t last_power_down, auto_depth_timer = 0, refresh = 0, auto_go = FALSE;
   uint16_t  clock_timer = 0;
   enum buttons button;
   static uint8_t b_counter = 25;
@@ -249,6 +251,11 @@ int main() { //initialization and main loop
           // display auto depth every 1 second
           tst_depth_g = get_depth_auto(LINE2);               
           auto_depth_timer = 0;             
+          if ( Features.auto_start && checkAutoStart ( tst_depth_g ) )
+          {
+            auto_go = TRUE;   // rod placed and held, count without a key press
+            break;
+          }
         }
        
         // read clock every 10 seconds
@@ -258,6 +265,9 @@ int main() { //initialization and main loop
             LCD_position(LINE3);
             printTimeDate ( date_time_g );
             clock_timer = 0;
+            SDcacheIdle();      // write back project data left in the SD cache
+            projSessionIdle();  // close the project file once it is no longer in use
+            SDidle();           // unmount the card once it is no longer in use
          }
          
         
@@ -350,6 +360,23 @@ int main() { //initialization and main loop
        scan_keys();
       }   // loop for a key press       
       
+      if ( auto_go )
+      {
+        auto_go = FALSE;
+        do
+        {
+          Spec_flags.recall_flag = FALSE;
+          if ( measureMoistureDensity( ) == 0 )
+          {
+            break;
+          }
+        } while ( getLastKey() == ENTER );  //start another count if enter is pressed
+        refresh = TRUE;
+        Flags.button_pressed = TRUE;
+        clock_timer = 100;
+        continue;
+      }
+      
       shutdown_timer = 0;    
       // enable the shut down timer
       // enable automatic timeout and shut down feature  
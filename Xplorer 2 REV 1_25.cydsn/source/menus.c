@@ -33,6 +33,8 @@
 #include "Utilities.h"
 #include "Tests.h"
 #include "SDcard.h"
+#include "Measurement.h"
+#include "Profiler.h"
 
 extern void standCountMode(void);
 
@@ -63,7 +65,7 @@ void main_menu(void)  // controls the main menu, (MENU button initiates)
 {
  
 //#if(GAUGETYPE==1)
- uint8_t menu_track = 1, menu_n = 10, selection;       
+ uint8_t menu_track = 1, menu_n = 11, selection;       
 
  enum buttons button;
  
@@ -120,7 +122,7 @@ void main_menu(void)  // controls the main menu, (MENU button initiates)
           case  4:  enable_disable_features('L');     break;  // LCD_backlight
           case  5:  stat_test();                      break;  // run stat test
           case  6:  drift_test();                     break;  // run drift test
-          case  7:  enable_disable_features('G');     break;  // GPS
+          case  7:  gps_settings();                   break;  // GPS
           case  8:  auto_depth_enable_or_calibrate(); break;  // auto depth       
           case  9:  review_std_counts();              break;  // review last 30 standard counts
           case 10:  select_language();                break;  // select between English and Spanish        
@@ -136,6 +138,8 @@ void main_menu(void)  // controls the main menu, (MENU button initiates)
           case 20:  diag_menu();                      break;  // go to diagnostic menu
           
           case 21:  select_mode();                    break;  // Smart MC Mode
+          case 22:  measureRolling();                 break;  // continuous rolling count
+          case 23:  measureSweep();                   break;  // multi-depth profile
         }
      }
       
@@ -171,10 +175,7 @@ void project_menu(void)  // controls the project menu (PROJECT button initiates)
   char proj[PROJ_NAME_LENGTH]; 
   in_menu = TRUE;
  
-  if ( sdOpened == OFF )
-  {
-    SDstart();
-  }
+  SDstart();                  // one reference for the whole menu
   
   while(1)                    // only exit menu when ESC is pressed
   { 
@@ -200,10 +201,7 @@ void project_menu(void)  // controls the project menu (PROJECT button initiates)
     { 
       selection = button;           
   
-      if ( sdOpened == OFF )
-      {
-        SDstart();
-      }
+      SD_Wake();                // remount if an action unmounted the card
       switch(selection)
       {
   
@@ -223,6 +221,9 @@ void project_menu(void)  // controls the project menu (PROJECT button initiates)
         case 5:
               delete_projects();     
               break;
+        case 6:
+              recompute_project();
+              break;
         default:
               break;   
       }
@@ -234,10 +235,7 @@ void project_menu(void)  // controls the project menu (PROJECT button initiates)
       break;
   } 
   
-  if (  sdOpened == ON  )
-  {
-    SDstop(null);
-  }
+  SDstop(null);
 }
 
 
@@ -261,10 +259,7 @@ void print_menu(void)  // controls the project menu (PROJECT button initiates)
 {
   enum buttons button, selection;
  
-  if ( sdOpened == OFF )
-  {
-    SDstart();
-  }
+  SDstart();                  // one reference for the whole menu
   
   while(1)                    // only exit menu when ESC is pressed
   { 
@@ -283,10 +278,7 @@ void print_menu(void)  // controls the project menu (PROJECT button initiates)
     { 
       selection = button;           
   
-      if ( sdOpened == OFF )
-      {
-        SDstart();
-      }
+      SD_Wake();                // remount if an action unmounted the card
       switch(selection)
       {
         case 1:
@@ -307,10 +299,7 @@ void print_menu(void)  // controls the project menu (PROJECT button initiates)
       break;
   } 
   
-  if (  sdOpened == ON  )
-  {
-    SDstop(null);
-  }
+  SDstop(null);
 }
 /******************************************************************************
  *  Name: 
@@ -320,7 +309,7 @@ void print_menu(void)  // controls the project menu (PROJECT button initiates)
  *****************************************************************************/ 
 void diag_menu(void)
 {
-  uint8_t menu_track = 1, menu_n = 8, selection;    
+  uint8_t menu_track = 1, menu_n = 9, selection;    
   enum buttons button;
   
   in_menu = TRUE;
@@ -397,6 +386,12 @@ void diag_menu(void)
                   break;
         case  15: idle_shutdown();
                   break;
+        case  16: dead_time_settings();
+                  break;
+        case  17: postCountTimingReport();
+                  break;
+        case  18: profViewLog();
+                  break;
 
         
        default: break;
@@ -218,11 +218,17 @@ void main_menu_display(uint8_t menu_trk)   // display for the main menu
           _LCD_PRINT("18. Cal. Constants  ");
            break;    
           
-      case 0:    
+      case 10:    
          _LCD_PRINT("19. Soil Air Voids   ");         
          LCD_position(LINE2);          
          _LCD_PRINT("20. Diagnostic Test ");         
           break;      
+
+      case 0:    
+         _LCD_PRINT("22. Rolling Count   ");         
+         LCD_position(LINE2);          
+         _LCD_PRINT("23. Depth Sweep     ");         
+          break;      
           
 
           
@@ -281,12 +287,18 @@ void main_menu_display(uint8_t menu_trk)   // display for the main menu
             _LCD_PRINT("18. Const. de Calib.");       // Cal constants
             break; 
             
-       case 0:    
+       case 10:    
             _LCD_PRINT("19. Tierra Aire Nulo");         
             LCD_position(LINE2);          
             _LCD_PRINT("20. Auto Diagnostico ");           // Diagnostics   
           
           break; 
+
+       case 0:    
+            _LCD_PRINT("22. Cuenta Continua ");           // Rolling count
+            LCD_position(LINE2);          
+            _LCD_PRINT("23. Perfil de Prof. ");           // Depth sweep
+          break; 
          
        break;
          
@@ -320,7 +332,7 @@ void project_menu_display(uint8_t menu_trk)   // display for the project menu
       LCD_position(LINE1);
       _LCD_PRINT("5. Delete Data      ");
       LCD_position(LINE2);
-      _LCD_PRINT("                    ");      
+      _LCD_PRINT("6. Recompute Project");      
       break;   
      }
    }
@@ -346,7 +358,7 @@ void project_menu_display(uint8_t menu_trk)   // display for the project menu
         LCD_position(LINE1);
         _LCD_PRINT("5. Borrar la Info.   ");       
         LCD_position(LINE2);
-        _LCD_PRINT("                    ");       
+        _LCD_PRINT("6. Recalcular Proy. ");       
       }
    }
   if(in_menu)
@@ -508,11 +520,18 @@ void diag_menu_display( uint8_t menu_trk)
          _LCD_PRINT("14. Reset BLE Module");        
           break;    
         
-      case 0:
+      case 8:
           LCD_position(LINE1);
          _LCD_PRINT("15.Idle Shutdwn Time");
          LCD_position(LINE2);
-         _LCD_PRINT("                    ");      
+         _LCD_PRINT("16.Dead Time Corr.  ");      
+        break;      
+        
+      case 0:
+          LCD_position(LINE1);
+         _LCD_PRINT("17.Post Count Timing");
+         LCD_position(LINE2);
+         _LCD_PRINT("18.Timing Log       ");      
         break;      
         
       break;                  
@@ -546,7 +565,7 @@ void sd_menu_display(uint8_t menu_trk)   // display for the project menu
     LCD_position(LINE1);
     _LCD_PRINT("5. Add/Delete Files ");
     LCD_position(LINE2);
-    _LCD_PRINT("                    ");
+    _LCD_PRINT("6. Store Benchmark  ");
     break;
     
   }
@@ -1548,6 +1567,24 @@ void enable_disable_text(char *temp_str,char c)
       _LCD_PRINTF("%s Chi2 Test?",temp_str);
       break;
 
+      case 'P':
+      _LCD_PRINTF("%s Precision",temp_str);
+      LCD_position(LINE2);
+      _LCD_PRINT("Stop?");
+      break;
+      
+      case 'E':
+      _LCD_PRINTF("%s Early",temp_str);
+      LCD_position(LINE2);
+      _LCD_PRINT("STD Accept?");
+      break;
+      
+      case 'H':
+      _LCD_PRINTF("%s Auto",temp_str);
+      LCD_position(LINE2);
+      _LCD_PRINT("Start at Depth?");
+      break;
+
     }    
   }
     else
@@ -1599,6 +1636,24 @@ void enable_disable_text(char *temp_str,char c)
       case 'Q':
       _LCD_PRINTF("%s Chi2 Test?",temp_str);
       break;
+
+      case 'P':
+      _LCD_PRINTF("%s Parada por",temp_str);  // Habilitar / Deshabilitar Parada por Precision
+      LCD_position(LINE2);
+      _LCD_PRINT("Precision?");
+      break;
+      
+      case 'E':
+      _LCD_PRINTF("%s Acepta",temp_str);  // Habilitar / Deshabilitar Acepta Std Temprana
+      LCD_position(LINE2);
+      _LCD_PRINT("Std Temprana?");
+      break;
+      
+      case 'H':
+      _LCD_PRINTF("%s Inicio",temp_str);  // Habilitar / Deshabilitar Inicio Automatico
+      LCD_position(LINE2);
+      _LCD_PRINT("Automatico?");
+      break;
       }    
     }
 }
@@ -1626,7 +1681,8 @@ void auto_depth_settings(void)
       LCD_position(LINE3);
       _LCD_PRINT("2. Depth Strip Type");
      } 
-    
+    LCD_position(LINE4);
+    _LCD_PRINT("3. Auto Start");
   }
     else 
      {
@@ -1638,6 +1694,8 @@ void auto_depth_settings(void)
        LCD_position(LINE3);
        _LCD_PRINT("2. Depth Strip Type");
       }        
+      LCD_position(LINE4);
+      _LCD_PRINT("3. Inicio Automatico");
     }
 }
 
@@ -3147,21 +3205,93 @@ void delete_data_text()
   LCD_position(LINE1);
   if(Features.language_f)
   {
-    _LCD_PRINT("Delete Data");
-    LCD_position(LINE2);
     _LCD_PRINT("1. Delete All Data");
-    LCD_position(LINE3); 
+    LCD_position(LINE2);
     _LCD_PRINT("2. Delete One Proj."); 
+    LCD_position(LINE3); 
+    _LCD_PRINT("3. Clean Up Card"); 
   }
     else
     {
-      _LCD_PRINT("Borrar la Info.");
-      LCD_position(LINE2);
       _LCD_PRINT("1. Toda Informacion");  // Borrar la Informacin; 1. Borrar toda Informacion  2.Borrar un projecto
-      LCD_position(LINE3);  
+      LCD_position(LINE2);
       _LCD_PRINT("2. Un Projecto"); 
+      LCD_position(LINE3);  
+      _LCD_PRINT("3. Limpiar Tarjeta"); 
     }  
 }
+void cleanup_policy_text()
+{ 
+  LCD_position(LINE1);
+  if(Features.language_f)
+  {
+    _LCD_PRINT("Clean Up Card");
+    LCD_position(LINE2);
+    _LCD_PRINT("1. Older Than Days");
+    LCD_position(LINE3); 
+    _LCD_PRINT("2. Exported Only"); 
+  }
+    else
+    {
+      _LCD_PRINT("Limpiar Tarjeta");   // Limpiar Tarjeta; 1. Mas Antiguos que Dias  2. Solo Exportados
+      LCD_position(LINE2);
+      _LCD_PRINT("1. Mas de X Dias");
+      LCD_position(LINE3);  
+      _LCD_PRINT("2. Solo Exportados"); 
+    }  
+}
+void cleanup_days_text(char *temp_str)
+{ 
+  LCD_position(LINE1);
+  if(Features.language_f)
+  {
+    _LCD_PRINT("Delete Older Than");
+    LCD_position(LINE2);
+    _LCD_PRINTF("Days: %s",temp_str); 
+  }
+    else
+    {
+      _LCD_PRINT("Borrar Mas Antiguos");   // Borrar mas antiguos que Dias
+      LCD_position(LINE2);
+      _LCD_PRINTF("Dias: %s",temp_str); 
+    }
+}
+void erase_cleanup_text()
+{ 
+  LCD_position(LINE1);
+  if(Features.language_f)
+  {
+    _LCD_PRINT("Erase Selected");
+    LCD_position(LINE2);
+    _LCD_PRINT("Projects?");
+    LCD_position(LINE3);
+    _LCD_PRINT("YES to Continue"); 
+  }
+    else
+    {
+      _LCD_PRINT("Borrar Proyectos");   // Borrar los proyectos seleccionados SI para continuar
+      LCD_position(LINE2);
+      _LCD_PRINT("Seleccionados?");
+      LCD_position(LINE3);
+      _LCD_PRINT("SI Para Continuar"); 
+    }
+}
+void projects_deleted_text(uint16 deleted)
+{  
+  LCD_position(LINE2);
+  if(Features.language_f)
+  {
+    _LCD_PRINTF("  %u Projects",deleted);
+    LCD_position(LINE3);
+    _LCD_PRINT("      Deleted"); 
+  }
+    else
+    {
+      _LCD_PRINTF("  %u Proyectos",deleted);   // proyectos borrados
+      LCD_position(LINE3);
+      _LCD_PRINT("     Borrados"); 
+    }
+}
 void enter_to_delete_text()
 {  
   LCD_position(LINE2);